@@ -33,6 +33,8 @@
 #include "globalconf.h"
 #include "objects/client.h"
 #include "objects/screen.h"
+#include "profile.h"
+#include "property.h"
 #include "spawn.h"
 #include "systray.h"
 #include "xwindow.h"
@@ -54,6 +56,7 @@
 #include <xcb/xtest.h>
 #include <xcb/shape.h>
 #include <xcb/xfixes.h>
+#include <xcb/shm.h>
 
 #include <glib-unix.h>
 
@@ -64,6 +67,8 @@ static char **awesome_argv;
 
 /** time of last main loop wakeup */
 static struct timeval last_wakeup;
+/** When we finished handling X11 events and GLib started dispatching sources */
+static int64_t sources_start;
 
 /** current limit for the main loop's runtime */
 static float main_loop_iteration_limit = 0.1;
@@ -71,6 +76,16 @@ static float main_loop_iteration_limit = 0.1;
 /** A pipe that is used to asynchronously handle SIGCHLD */
 static int sigchld_pipe[2];
 
+/** How managing the windows that existed at startup went, see scan() */
+static struct
+{
+    int windows;
+    double time;
+    /** Round trips that could not be avoided, counted from the code rather
+     * than measured */
+    int estimated_round_trips;
+} startup_stats;
+
 /* Initialise various random number generators */
 static void
 init_rng(void)
@@ -195,6 +210,9 @@ scan(xcb_query_tree_cookie_t tree_c)
     xcb_get_window_attributes_reply_t *attr_r;
     xcb_get_geometry_reply_t *geom_r;
     xcb_get_property_cookie_t prop_cookie;
+    lua_State *L = globalconf_get_lua_State();
+    gint64 start = g_get_monotonic_time();
+    int round_trips = 0;
 
     tree_r = xcb_query_tree_reply(globalconf.connection,
                                   tree_c,
@@ -226,6 +244,12 @@ scan(xcb_query_tree_cookie_t tree_c)
         geom_wins[i] = xcb_get_geometry_unchecked(globalconf.connection, wins[i]);
     }
 
+    /* Collect the windows that we are going to manage */
+    xcb_window_t manage_wins[tree_c_len];
+    xcb_get_window_attributes_reply_t *manage_attr[tree_c_len];
+    xcb_get_geometry_reply_t *manage_geom[tree_c_len];
+    int manage_len = 0;
+
     for(i = 0; i < tree_c_len; i++)
     {
         attr_r = xcb_get_window_attributes_reply(globalconf.connection,
@@ -244,15 +268,78 @@ scan(xcb_query_tree_cookie_t tree_c)
             continue;
         }
 
-        client_manage(wins[i], geom_r, attr_r);
+        manage_wins[manage_len] = wins[i];
+        manage_attr[manage_len] = attr_r;
+        manage_geom[manage_len] = geom_r;
+        manage_len++;
+    }
+    /* The query tree reply and the attributes/geometry/state batch */
+    round_trips += 2;
 
-        p_delete(&attr_r);
-        p_delete(&geom_r);
+    /* Send the requests for all windows before waiting for any reply, so that
+     * managing N windows costs one round trip instead of N. */
+    client_manage_cookies_t *cookies = p_new(client_manage_cookies_t, MAX(manage_len, 1));
+    client_t *managed[MAX(manage_len, 1)];
+
+    for(i = 0; i < manage_len; i++)
+        client_manage_prepare(manage_wins[i], &cookies[i]);
+    if(manage_len > 0)
+        round_trips++;
+
+    for(i = 0; i < manage_len; i++)
+    {
+        managed[i] = client_manage_prepared(manage_wins[i], manage_geom[i],
+                                            manage_attr[i], &cookies[i]);
+        /* Keep the client alive until its reparent was checked */
+        if(managed[i])
+        {
+            luaA_object_push(L, managed[i]);
+            luaA_object_ref(L, -1);
+        }
+        round_trips += cookies[i].extra_round_trips;
+        p_delete(&manage_attr[i]);
+        p_delete(&manage_geom[i]);
     }
 
+    /* The reparent errors all arrive together */
+    bool checked = false;
+    for(i = 0; i < manage_len; i++)
+        if(managed[i])
+        {
+            client_manage_check(managed[i], &cookies[i]);
+            luaA_object_unref(L, managed[i]);
+            checked = true;
+        }
+    if(checked)
+        round_trips++;
+
+    p_delete(&cookies);
+
     p_delete(&tree_r);
 
     restore_client_order(prop_cookie);
+
+    startup_stats.windows = manage_len;
+    startup_stats.time = (g_get_monotonic_time() - start) / 1e6;
+    startup_stats.estimated_round_trips = round_trips;
+}
+
+/** Push statistics about managing the existing windows at startup onto the
+ * Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+awesome_push_startup_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, startup_stats.windows);
+    lua_setfield(L, -2, "windows");
+    lua_pushnumber(L, startup_stats.time);
+    lua_setfield(L, -2, "time");
+    lua_pushinteger(L, startup_stats.estimated_round_trips);
+    lua_setfield(L, -2, "estimated_round_trips");
+    return 1;
 }
 
 static void
@@ -372,6 +459,8 @@ acquire_timestamp(void)
     }
 }
 
+DO_ARRAY(xcb_generic_event_t *, xcb_generic_event, DO_NOTHING)
+
 static xcb_generic_event_t *poll_for_event(void)
 {
     if (globalconf.pending_event) {
@@ -386,34 +475,56 @@ static xcb_generic_event_t *poll_for_event(void)
 static void
 a_xcb_check(void)
 {
+    xcb_generic_event_array_t events;
     xcb_generic_event_t *mouse = NULL, *event;
 
+    /* Not static, handling an event can run a nested main loop */
+    xcb_generic_event_array_init(&events);
+
+    /* Handle events in batches of everything that already arrived, so that
+     * redundant events can be merged. Handling events may read further
+     * events from the connection, so repeat until nothing is left. */
     while((event = poll_for_event()))
     {
-        /* We will treat mouse events later.
-         * We cannot afford to treat all mouse motion events,
-         * because that would be too much CPU intensive, so we just
-         * take the last we get after a bunch of events. */
-        if(XCB_EVENT_RESPONSE_TYPE(event) == XCB_MOTION_NOTIFY)
-        {
-            p_delete(&mouse);
-            mouse = event;
-        }
-        else
+        do
+            xcb_generic_event_array_append(&events, event);
+        while((event = poll_for_event()));
+
+        event_coalesce(events.tab, events.len);
+
+        for(int i = 0; i < events.len; i++)
         {
-            uint8_t type = XCB_EVENT_RESPONSE_TYPE(event);
-            if(mouse && (type == XCB_ENTER_NOTIFY || type == XCB_LEAVE_NOTIFY
-                        || type == XCB_BUTTON_PRESS || type == XCB_BUTTON_RELEASE))
+            event = events.tab[i];
+            if(!event)
+                continue;
+
+            /* We will treat mouse events later.
+             * We cannot afford to treat all mouse motion events,
+             * because that would be too much CPU intensive, so we just
+             * take the last we get after a bunch of events. */
+            if(XCB_EVENT_RESPONSE_TYPE(event) == XCB_MOTION_NOTIFY)
             {
-                /* Make sure enter/motion/leave/press/release events are handled
-                 * in the correct order */
-                event_handle(mouse);
                 p_delete(&mouse);
+                mouse = event;
+            }
+            else
+            {
+                uint8_t type = XCB_EVENT_RESPONSE_TYPE(event);
+                if(mouse && (type == XCB_ENTER_NOTIFY || type == XCB_LEAVE_NOTIFY
+                            || type == XCB_BUTTON_PRESS || type == XCB_BUTTON_RELEASE))
+                {
+                    /* Make sure enter/motion/leave/press/release events are handled
+                     * in the correct order */
+                    event_handle(mouse);
+                    p_delete(&mouse);
+                }
+                event_handle(event);
+                p_delete(&event);
             }
-            event_handle(event);
-            p_delete(&event);
         }
+        events.len = 0;
     }
+    xcb_generic_event_array_wipe(&events);
 
     if(mouse)
     {
@@ -443,6 +554,9 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     int saved_errno;
     lua_State *L = globalconf_get_lua_State();
 
+    if (sources_start)
+        profile_record(PROFILE_SOURCES, sources_start);
+
     /* Do all deferred work now */
     awesome_refresh();
 
@@ -458,11 +572,16 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     globalconf.pending_event = xcb_poll_for_event(globalconf.connection);
     if (globalconf.pending_event != NULL)
         timeout = 0;
+    /* Property replies that were already read from the connection will not
+     * wake us up */
+    if (property_replies_ready())
+        timeout = 0;
 
     /* Check how long this main loop iteration took */
     gettimeofday(&now, NULL);
     timersub(&now, &last_wakeup, &length_time);
     length = length_time.tv_sec + length_time.tv_usec * 1.0f / 1e6;
+    profile_record_seconds(PROFILE_ITERATION, length);
     if (length > main_loop_iteration_limit) {
         warn("Last main loop iteration took %.6f seconds! Increasing limit for "
                 "this warning to that value.", length);
@@ -473,7 +592,9 @@ a_glib_poll(GPollFD *ufds, guint nfsd, gint timeout)
     res = g_poll(ufds, nfsd, timeout);
     saved_errno = errno;
     gettimeofday(&last_wakeup, NULL);
+    sources_start = profile_now();
     a_xcb_check();
+    sources_start = profile_record(PROFILE_EVENTS, sources_start);
     errno = saved_errno;
 
     return res;
@@ -769,6 +890,7 @@ main(int argc, char **argv)
     xcb_prefetch_extension_data(globalconf.connection, &xcb_xinerama_id);
     xcb_prefetch_extension_data(globalconf.connection, &xcb_shape_id);
     xcb_prefetch_extension_data(globalconf.connection, &xcb_xfixes_id);
+    xcb_prefetch_extension_data(globalconf.connection, &xcb_shm_id);
 
     if (xcb_cursor_context_new(globalconf.connection, globalconf.screen, &globalconf.cursor_ctx) < 0)
         fatal("Failed to initialize xcb-cursor");
@@ -837,6 +959,10 @@ main(int argc, char **argv)
         xcb_discard_reply(globalconf.connection,
                 xcb_xfixes_query_version(globalconf.connection, 1, 0).sequence);
 
+    /* check for MIT-SHM extension */
+    query = xcb_get_extension_data(globalconf.connection, &xcb_shm_id);
+    globalconf.have_shm = query && query->present;
+
     event_init();
 
     /* Allocate the key symbols */
@@ -22,10 +22,12 @@
 #ifndef AWESOME_AWESOME_H
 #define AWESOME_AWESOME_H
 
+#include <lua.h>
 #include <stdbool.h>
 
 void awesome_restart(void);
 void awesome_atexit(bool restart);
+int awesome_push_startup_stats(lua_State *);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
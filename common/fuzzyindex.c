@@ -0,0 +1,403 @@
+/*
+ * fuzzyindex.c - ranked fuzzy string search
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/fuzzyindex.h"
+
+#define FUZZYINDEX_MIN_GRAMS 256
+
+/** Copy a string, converting ASCII letters to lowercase. This matches what
+ * gears.string.query_to_pattern() considers to be case-insensitive.
+ */
+static char *
+fuzzyindex_lower(const char *s)
+{
+    ssize_t len = a_strlen(s);
+    char *res = p_new(char, len + 1);
+
+    for(ssize_t i = 0; i < len; i++)
+        res[i] = s[i] >= 'A' && s[i] <= 'Z' ? s[i] - 'A' + 'a' : s[i];
+    res[len] = '\0';
+    return res;
+}
+
+static inline uint32_t
+fuzzyindex_gram(const char *s, int len)
+{
+    uint32_t gram = (uint32_t) len << 24;
+    for(int i = 0; i < len; i++)
+        gram |= (uint32_t) (uint8_t) s[i] << (8 * (2 - i));
+    return gram;
+}
+
+static inline int
+fuzzyindex_slot(uint32_t gram, int size)
+{
+    uint32_t h = gram * UINT32_C(2654435769);
+    return (h ^ (h >> 16)) & (size - 1);
+}
+
+static void
+fuzzyindex_resize(fuzzyindex_t *idx, int size)
+{
+    fuzzyindex_postings_t *old = idx->grams;
+    int old_size = idx->grams_size;
+
+    idx->grams = p_new(fuzzyindex_postings_t, size);
+    idx->grams_size = size;
+
+    for(int i = 0; i < old_size; i++)
+    {
+        if(!old[i].gram)
+            continue;
+        int slot = fuzzyindex_slot(old[i].gram, size);
+        while(idx->grams[slot].gram)
+            slot = (slot + 1) & (size - 1);
+        idx->grams[slot] = old[i];
+    }
+
+    p_delete(&old);
+}
+
+/** Get the entries containing an n-gram.
+ * \param idx The index.
+ * \param gram The n-gram.
+ * \param create Whether to add the n-gram if it is not there yet.
+ * \return The postings or NULL.
+ */
+static fuzzyindex_postings_t *
+fuzzyindex_postings(fuzzyindex_t *idx, uint32_t gram, bool create)
+{
+    if(create && (idx->grams_len + 1) * 4 > idx->grams_size * 3)
+        fuzzyindex_resize(idx, MAX(FUZZYINDEX_MIN_GRAMS, idx->grams_size * 2));
+    if(idx->grams_size == 0)
+        return NULL;
+
+    int mask = idx->grams_size - 1;
+    for(int i = fuzzyindex_slot(gram, idx->grams_size);; i = (i + 1) & mask)
+    {
+        fuzzyindex_postings_t *postings = &idx->grams[i];
+        if(postings->gram == gram)
+            return postings;
+        if(!postings->gram)
+        {
+            if(!create)
+                return NULL;
+            postings->gram = gram;
+            idx->grams_len++;
+            return postings;
+        }
+    }
+}
+
+static void
+fuzzyindex_index_string(fuzzyindex_t *idx, int entry, const char *s)
+{
+    int len = a_strlen(s);
+
+    /* Single characters for subsequences, trigrams for substrings */
+    for(int n = 1; n <= 3; n += 2)
+        for(int i = 0; i + n <= len; i++)
+        {
+            fuzzyindex_postings_t *postings =
+                fuzzyindex_postings(idx, fuzzyindex_gram(s + i, n), true);
+            /* Entries are added in order, so a repeated n-gram of the same
+             * entry is always the last one in the list */
+            if(postings->entries.len == 0
+               || postings->entries.tab[postings->entries.len - 1] != entry)
+                int_array_append(&postings->entries, entry);
+        }
+}
+
+/** Free all memory used by an index.
+ * \param idx The index.
+ */
+void
+fuzzyindex_wipe(fuzzyindex_t *idx)
+{
+    fuzzyindex_entry_array_wipe(&idx->entries);
+    for(int i = 0; i < idx->grams_size; i++)
+        int_array_wipe(&idx->grams[i].entries);
+    p_delete(&idx->grams);
+    int_array_wipe(&idx->candidates);
+    int_array_wipe(&idx->ranked);
+    p_delete(&idx->seen);
+    p_clear(idx, 1);
+}
+
+/** Add an entry to an index.
+ * \param idx The index.
+ * \param name The name of the entry.
+ * \param cmdline A second string to match against, or NULL.
+ * \param weight How often the entry was used.
+ * \return The position of the new entry in idx->entries.
+ */
+int
+fuzzyindex_add(fuzzyindex_t *idx, const char *name, const char *cmdline, int weight)
+{
+    fuzzyindex_entry_t entry = {
+        .key = p_dup(NONULL(name), a_strlen(name) + 1),
+        .name = fuzzyindex_lower(name),
+        .cmdline = cmdline ? fuzzyindex_lower(cmdline) : NULL,
+        .weight = weight,
+    };
+    int pos = idx->entries.len;
+
+    fuzzyindex_entry_array_append(&idx->entries, entry);
+    fuzzyindex_index_string(idx, pos, entry.name);
+    if(entry.cmdline)
+        fuzzyindex_index_string(idx, pos, entry.cmdline);
+    return pos;
+}
+
+/** Set the weight of all entries with a name.
+ * \param idx The index.
+ * \param name The name as it was given to fuzzyindex_add().
+ * \param weight How often the entry was used.
+ */
+void
+fuzzyindex_set_weight(fuzzyindex_t *idx, const char *name, int weight)
+{
+    foreach(entry, idx->entries)
+        if(A_STREQ(entry->key, name))
+            entry->weight = weight;
+}
+
+static bool
+fuzzyindex_is_subsequence(const char *s, const char *query)
+{
+    for(; *s && *query; s++)
+        if(*s == *query)
+            query++;
+    return !*query;
+}
+
+/** Check how well an entry matches a query.
+ * \param entry The entry.
+ * \param query The lowercased query.
+ * \return The best match of the entry's name or command line.
+ */
+fuzzyindex_match_t
+fuzzyindex_match(fuzzyindex_entry_t *entry, const char *query)
+{
+    size_t len = strlen(query);
+
+    if(!strncmp(entry->name, query, len)
+       || (entry->cmdline && !strncmp(entry->cmdline, query, len)))
+        return FUZZYINDEX_PREFIX;
+    if(strstr(entry->name, query)
+       || (entry->cmdline && strstr(entry->cmdline, query)))
+        return FUZZYINDEX_SUBSTRING;
+    if(fuzzyindex_is_subsequence(entry->name, query)
+       || (entry->cmdline && fuzzyindex_is_subsequence(entry->cmdline, query)))
+        return FUZZYINDEX_SUBSEQUENCE;
+    return FUZZYINDEX_NO_MATCH;
+}
+
+/** Collect the entries that contain every n-gram of a query into
+ * idx->candidates.
+ * \param idx The index.
+ * \param query The lowercased query.
+ * \param len The length of the query.
+ * \param n The length of the n-grams to use.
+ */
+static void
+fuzzyindex_gather(fuzzyindex_t *idx, const char *query, int len, int n)
+{
+    int_array_t *shortest = NULL;
+
+    idx->candidates.len = 0;
+
+    /* Start with the shortest list, the others can only remove entries */
+    for(int i = 0; i + n <= len; i++)
+    {
+        fuzzyindex_postings_t *postings =
+            fuzzyindex_postings(idx, fuzzyindex_gram(query + i, n), false);
+        if(!postings)
+            return;
+        if(!shortest || postings->entries.len < shortest->len)
+            shortest = &postings->entries;
+    }
+    if(!shortest)
+        return;
+
+    int_array_splice(&idx->candidates, 0, 0, shortest->tab, shortest->len);
+
+    for(int i = 0; i + n <= len; i++)
+    {
+        int_array_t *list = &fuzzyindex_postings(idx, fuzzyindex_gram(query + i, n), false)->entries;
+        if(list == shortest)
+            continue;
+
+        /* Both lists are sorted, so walk them side by side */
+        int kept = 0, j = 0;
+        foreach(entry, idx->candidates)
+        {
+            while(j < list->len && list->tab[j] < *entry)
+                j++;
+            if(j == list->len)
+                break;
+            if(list->tab[j] == *entry)
+                idx->candidates.tab[kept++] = *entry;
+        }
+        idx->candidates.len = kept;
+    }
+}
+
+/** The index being sorted by fuzzyindex_rank_cmp() */
+static fuzzyindex_t *fuzzyindex_sorting;
+
+static int
+fuzzyindex_rank_cmp(const void *a, const void *b)
+{
+    int x = *(const int *) a, y = *(const int *) b;
+    fuzzyindex_entry_t *ex = &fuzzyindex_sorting->entries.tab[x];
+    fuzzyindex_entry_t *ey = &fuzzyindex_sorting->entries.tab[y];
+
+    if(fuzzyindex_sorting->seen[x] != fuzzyindex_sorting->seen[y])
+        return fuzzyindex_sorting->seen[y] - fuzzyindex_sorting->seen[x];
+    if(ex->weight != ey->weight)
+        return ex->weight < ey->weight ? 1 : -1;
+    return x - y;
+}
+
+/** Classify the candidates and add the ones that match well enough to
+ * idx->ranked. Each entry's match is kept in idx->seen.
+ * \param subsequence Whether the candidates are known not to contain the query.
+ */
+static void
+fuzzyindex_classify(fuzzyindex_t *idx, const char *query,
+                    fuzzyindex_match_t min_match, bool subsequence)
+{
+    foreach(entry, idx->candidates)
+    {
+        if(idx->seen[*entry])
+            continue;
+        fuzzyindex_entry_t *e = &idx->entries.tab[*entry];
+        fuzzyindex_match_t match;
+        if(!subsequence)
+            match = fuzzyindex_match(e, query);
+        else if(fuzzyindex_is_subsequence(e->name, query)
+                || (e->cmdline && fuzzyindex_is_subsequence(e->cmdline, query)))
+            match = FUZZYINDEX_SUBSEQUENCE;
+        else
+            match = FUZZYINDEX_NO_MATCH;
+        /* Mark entries that do not match as well, they are not looked at again */
+        idx->seen[*entry] = match + 1;
+        if(match >= min_match)
+            int_array_append(&idx->ranked, *entry);
+    }
+}
+
+/** Search an index.
+ *
+ * Prefix matches are ranked first, then substring matches and then entries
+ * that contain the query as a subsequence. Each group is ranked by weight and
+ * then by the order the entries were added in. All comparisons ignore the case
+ * of ASCII letters. An empty query matches all entries in the order they were
+ * added in.
+ * \param idx The index.
+ * \param query The query.
+ * \param max The maximum number of results, or 0 for all of them.
+ * \param min_match The worst kind of match to include.
+ * \param results Filled with the positions of the matching entries.
+ * \return The number of results.
+ */
+int
+fuzzyindex_search(fuzzyindex_t *idx, const char *query, int max,
+                  fuzzyindex_match_t min_match, int_array_t *results)
+{
+    char *lower = fuzzyindex_lower(query);
+    int len = strlen(lower);
+
+    min_match = MAX(min_match, FUZZYINDEX_SUBSEQUENCE);
+    results->len = 0;
+
+    if(len == 0)
+    {
+        int count = max > 0 ? MIN(max, idx->entries.len) : idx->entries.len;
+        for(int i = 0; i < count; i++)
+            int_array_append(results, i);
+        p_delete(&lower);
+        return results->len;
+    }
+
+    if(idx->seen_size < idx->entries.len)
+    {
+        p_delete(&idx->seen);
+        idx->seen_size = idx->entries.len;
+        idx->seen = p_new(uint8_t, idx->seen_size);
+    }
+    else if(idx->seen)
+        p_clear(idx->seen, idx->entries.len);
+    idx->ranked.len = 0;
+
+    bool done = false;
+    if(len != 2)
+    {
+        /* Everything containing the query contains all of its trigrams */
+        fuzzyindex_gather(idx, lower, len, len >= 3 ? 3 : 1);
+        fuzzyindex_classify(idx, lower, min_match, false);
+        /* Everything else can at best be a subsequence, which is ranked after
+         * what was found already */
+        done = len == 1 || min_match > FUZZYINDEX_SUBSEQUENCE
+            || (max > 0 && idx->ranked.len >= max);
+    }
+    if(!done)
+    {
+        fuzzyindex_gather(idx, lower, len, 1);
+        fuzzyindex_classify(idx, lower, min_match, len != 2);
+    }
+
+    fuzzyindex_sorting = idx;
+    if(max > 0 && idx->ranked.len > max)
+    {
+        /* Only keep the best ones, most entries are worse than all of them */
+        foreach(entry, idx->ranked)
+        {
+            if(results->len == max
+               && fuzzyindex_rank_cmp(entry, &results->tab[max - 1]) > 0)
+                continue;
+            int l = 0, r = results->len;
+            while(l < r)
+            {
+                int i = (l + r) / 2;
+                if(fuzzyindex_rank_cmp(entry, &results->tab[i]) > 0)
+                    l = i + 1;
+                else
+                    r = i;
+            }
+            if(results->len == max)
+                results->len--;
+            int_array_splice(results, l, 0, entry, 1);
+        }
+    }
+    else
+    {
+        qsort(idx->ranked.tab, idx->ranked.len, sizeof(int), fuzzyindex_rank_cmp);
+        int_array_splice(results, 0, 0, idx->ranked.tab, idx->ranked.len);
+    }
+    fuzzyindex_sorting = NULL;
+
+    p_delete(&lower);
+    return results->len;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
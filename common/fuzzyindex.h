@@ -0,0 +1,97 @@
+/*
+ * fuzzyindex.h - ranked fuzzy string search header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_FUZZYINDEX_H
+#define AWESOME_COMMON_FUZZYINDEX_H
+
+#include <stdint.h>
+
+#include "common/array.h"
+
+DO_ARRAY(int, int, DO_NOTHING)
+
+/** How well an entry matches a query, better matches are ranked first */
+typedef enum
+{
+    FUZZYINDEX_NO_MATCH = 0,
+    /** The characters of the query appear in this order */
+    FUZZYINDEX_SUBSEQUENCE,
+    /** The query appears somewhere */
+    FUZZYINDEX_SUBSTRING,
+    /** The name or the command line starts with the query */
+    FUZZYINDEX_PREFIX
+} fuzzyindex_match_t;
+
+typedef struct
+{
+    /** The name as given, usage weights are set by it */
+    char *key;
+    /** The lowercased name and command line, which may be NULL */
+    char *name, *cmdline;
+    /** Entries that were used more often are ranked first */
+    int weight;
+    /** What the entry stands for, up to the user of the index */
+    int value;
+} fuzzyindex_entry_t;
+
+static inline void
+fuzzyindex_entry_wipe(fuzzyindex_entry_t *entry)
+{
+    p_delete(&entry->key);
+    p_delete(&entry->name);
+    p_delete(&entry->cmdline);
+}
+
+DO_ARRAY(fuzzyindex_entry_t, fuzzyindex_entry, fuzzyindex_entry_wipe)
+
+/** The entries containing an n-gram, in increasing order */
+typedef struct
+{
+    /** The n-gram's length in the top byte and its characters below, 0 for
+     * an empty slot */
+    uint32_t gram;
+    int_array_t entries;
+} fuzzyindex_postings_t;
+
+/** A list of strings that can be searched by prefix, substring or
+ * subsequence. All single characters and all trigrams of the strings are
+ * indexed, so only entries that can match are looked at.
+ */
+typedef struct
+{
+    fuzzyindex_entry_array_t entries;
+    /** Open addressing hash table of n-grams, with linear probing */
+    fuzzyindex_postings_t *grams;
+    int grams_len, grams_size;
+    /** Scratch space for searches */
+    int_array_t candidates, ranked;
+    uint8_t *seen;
+    int seen_size;
+} fuzzyindex_t;
+
+void fuzzyindex_wipe(fuzzyindex_t *);
+int fuzzyindex_add(fuzzyindex_t *, const char *, const char *, int);
+void fuzzyindex_set_weight(fuzzyindex_t *, const char *, int);
+fuzzyindex_match_t fuzzyindex_match(fuzzyindex_entry_t *, const char *);
+int fuzzyindex_search(fuzzyindex_t *, const char *, int, fuzzyindex_match_t, int_array_t *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
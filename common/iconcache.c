@@ -0,0 +1,177 @@
+/*
+ * iconcache.c - content addressed cache for client icons
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* Most windows of the same application have the same _NET_WM_ICON, so instead
+ * of converting the icon data for every window, surfaces are looked up by a
+ * hash of the raw icon data. Since different icons can have the same hash, a
+ * copy of the raw data is kept to check hits against. The cache does not hold
+ * a reference to its surfaces: an icon is dropped from the cache once the last
+ * client using it released it.
+ */
+
+#include "common/iconcache.h"
+#include "common/array.h"
+
+typedef struct
+{
+    uint64_t hash;
+    int width, height;
+    /** The raw icon data that the surface was converted from */
+    uint32_t *data;
+    cairo_surface_t *surface;
+} iconcache_entry_t;
+
+static int
+iconcache_entry_cmp(const void *a, const void *b)
+{
+    const iconcache_entry_t *x = a, *y = b;
+
+    if(x->hash != y->hash)
+        return x->hash < y->hash ? -1 : 1;
+    if(x->width != y->width)
+        return x->width - y->width;
+    return x->height - y->height;
+}
+
+DO_BARRAY(iconcache_entry_t, iconcache_entry, DO_NOTHING, iconcache_entry_cmp)
+
+static iconcache_entry_array_t iconcache;
+static cairo_user_data_key_t iconcache_key;
+
+iconcache_stats_t iconcache_stats;
+
+/** Hash the raw data of an icon.
+ * This is FNV-1a, but over 64 bit words and with four independent lanes so
+ * that the multiplications can overlap. Hashing an icon should be much
+ * cheaper than converting it.
+ */
+static uint64_t
+iconcache_hash(int width, int height, const uint32_t *data)
+{
+    const uint64_t prime = UINT64_C(1099511628211);
+    size_t len = (size_t) width * height;
+    uint64_t lane[4], h;
+    size_t i = 0;
+
+    for(int l = 0; l < 4; l++)
+        lane[l] = UINT64_C(14695981039346656037) + l;
+
+    for(; i + 8 <= len; i += 8)
+        for(int l = 0; l < 4; l++)
+        {
+            uint64_t word;
+            memcpy(&word, &data[i + 2 * l], sizeof(word));
+            lane[l] = (lane[l] ^ word) * prime;
+        }
+    for(; i < len; i++)
+        lane[0] = (lane[0] ^ data[i]) * prime;
+
+    h = ((uint64_t) width << 32) | (uint32_t) height;
+    for(int l = 0; l < 4; l++)
+        h = (h ^ lane[l] ^ (lane[l] >> 29)) * prime;
+    return h;
+}
+
+/** Called by cairo when the last reference to a cached surface is gone. */
+static void
+iconcache_forget(void *data)
+{
+    iconcache_entry_t *key = data;
+    iconcache_entry_t *entry = iconcache_entry_array_lookup(&iconcache, key);
+
+    if(entry)
+    {
+        iconcache_entry_array_remove(&iconcache, entry);
+        iconcache_stats.entries--;
+        iconcache_stats.bytes -= (unsigned long) key->width * key->height * 8;
+    }
+    p_delete(&key->data);
+    p_delete(&key);
+}
+
+/** Check if a surface is in the icon cache and thus shared.
+ * \param surface The surface.
+ * \return True if the surface came from iconcache_get() and was cached.
+ */
+bool
+iconcache_contains(cairo_surface_t *surface)
+{
+    return cairo_surface_get_user_data(surface, &iconcache_key) != NULL;
+}
+
+/** Get a surface for some icon data, converting it if needed.
+ * The surface may be shared with other users of the same icon, so it must not
+ * be modified.
+ * \param width The width of the icon.
+ * \param height The height of the icon.
+ * \param data The icon's pixels in ARGB format with straight alpha.
+ * \return A new reference to a surface with the icon or NULL on error.
+ */
+cairo_surface_t *
+iconcache_get(int width, int height, const uint32_t *data)
+{
+    iconcache_entry_t key = {
+        .hash = iconcache_hash(width, height, data),
+        .width = width,
+        .height = height,
+    };
+    size_t len = (size_t) width * height;
+    iconcache_entry_t *entry;
+    cairo_surface_t *surface;
+
+    iconcache_stats.lookups++;
+    entry = iconcache_entry_array_lookup(&iconcache, &key);
+    if(entry && memcmp(entry->data, data, len * sizeof(*data)) == 0)
+    {
+        iconcache_stats.hits++;
+        return cairo_surface_reference(entry->surface);
+    }
+
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
+    if(cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS)
+    {
+        cairo_surface_destroy(surface);
+        return NULL;
+    }
+
+    /* ARGB32 rows are never padded, so the icon can be converted in one go */
+    cairo_surface_flush(surface);
+    iconcache_premultiply((uint32_t *) cairo_image_surface_get_data(surface),
+                          data, len);
+    cairo_surface_mark_dirty(surface);
+
+    /* A hash collision: the other icon keeps the slot and this one is not
+     * cached */
+    if(entry)
+        return surface;
+
+    key.data = p_dup(data, len);
+    key.surface = surface;
+    iconcache_entry_array_insert(&iconcache, key);
+    cairo_surface_set_user_data(surface, &iconcache_key,
+                                p_dup(&key, 1), iconcache_forget);
+    iconcache_stats.entries++;
+    iconcache_stats.bytes += (unsigned long) width * height * 8;
+
+    return surface;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,80 @@
+/*
+ * iconcache.h - content addressed cache for client icons header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_ICONCACHE_H
+#define AWESOME_COMMON_ICONCACHE_H
+
+#include <stdint.h>
+#include <cairo.h>
+
+#include "common/util.h"
+
+typedef struct
+{
+    /** Number of icons that were looked up */
+    unsigned long lookups;
+    /** Number of lookups that found an existing surface */
+    unsigned long hits;
+    /** Number of icons currently in the cache */
+    unsigned long entries;
+    /** Size of the pixel data of all cached icons, both the surfaces and the
+     * raw data kept to verify hits */
+    unsigned long bytes;
+} iconcache_stats_t;
+
+extern iconcache_stats_t iconcache_stats;
+
+cairo_surface_t *iconcache_get(int, int, const uint32_t *);
+bool iconcache_contains(cairo_surface_t *);
+
+/** Convert a pixel from straight to premultiplied alpha.
+ * Red and blue are scaled together in one 32 bit multiplication, the division
+ * by 255 is done with correct rounding via (x + (x >> 8) + 0x80) >> 8.
+ * \param argb The pixel in ARGB format with straight alpha.
+ * \return The pixel with its color channels multiplied by its alpha.
+ */
+static inline uint32_t
+iconcache_premultiply_pixel(uint32_t argb)
+{
+    uint32_t a = argb >> 24;
+    uint32_t rb = (argb & 0x00ff00ff) * a + 0x00800080;
+    uint32_t g = (argb & 0x0000ff00) * a + 0x00008000;
+
+    rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+    g = ((g + ((g >> 8) & 0x0000ff00)) >> 8) & 0x0000ff00;
+    return (a << 24) | rb | g;
+}
+
+/** Convert pixels from straight to premultiplied alpha.
+ * The loop has no branches so that the compiler can vectorize it.
+ * \param dst Where to store the converted pixels.
+ * \param src The ARGB pixels to convert.
+ * \param len The number of pixels.
+ */
+static inline void
+iconcache_premultiply(uint32_t *restrict dst, const uint32_t *restrict src, size_t len)
+{
+    for(size_t i = 0; i < len; i++)
+        dst[i] = iconcache_premultiply_pixel(src[i]);
+}
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -24,11 +24,16 @@
 
 #include <lua.h>
 #include <lauxlib.h>
+#include <time.h>
 
 #include "common/util.h"
 
 /** Lua function to call on dofunction() error */
-lua_CFunction lualib_dofunction_on_error;
+extern lua_CFunction lualib_dofunction_on_error;
+
+/** If set, dofunction() measures the time each function takes and reports it
+ * here together with where the function was defined */
+extern void (*lualib_dofunction_profile)(const lua_Debug *, double);
 
 void luaA_checkfunction(lua_State *, int);
 void luaA_checktable(lua_State *, int);
@@ -66,6 +71,17 @@ luaA_dofunction_error(lua_State *L)
 static inline bool
 luaA_dofunction(lua_State *L, int nargs, int nret)
 {
+    lua_Debug ar;
+    struct timespec start, end;
+    bool success = true, profile = lualib_dofunction_profile != NULL;
+
+    if(profile)
+    {
+        lua_pushvalue(L, -1);
+        lua_getinfo(L, ">S", &ar);
+        clock_gettime(CLOCK_MONOTONIC, &start);
+    }
+
     /* Move function before arguments */
     lua_insert(L, - nargs - 1);
     /* Push error handling function */
@@ -78,11 +94,20 @@ luaA_dofunction(lua_State *L, int nargs, int nret)
         warn("%s", lua_tostring(L, -1));
         /* Remove error function and error string */
         lua_pop(L, 2);
-        return false;
+        success = false;
     }
-    /* Remove error function */
-    lua_remove(L, error_func_pos);
-    return true;
+    else
+        /* Remove error function */
+        lua_remove(L, error_func_pos);
+
+    /* The function may have changed the profiling mode */
+    if(profile && lualib_dofunction_profile)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        lualib_dofunction_profile(&ar, (end.tv_sec - start.tv_sec)
+                                  + (end.tv_nsec - start.tv_nsec) / 1e9);
+    }
+    return success;
 }
 
 /** Call a registered function. Its arguments are the complete stack contents.
@@ -230,7 +230,19 @@ luaA_object_disconnect_signal_from_stack(lua_State *L, int oud,
 void
 signal_object_emit(lua_State *L, signal_array_t *arr, const char *name, int nargs)
 {
-    signal_t *sigfound = signal_array_getbyname(arr, name);
+    signal_object_emit_id(L, arr, signal_lookup_id(name), nargs);
+}
+
+/** Emit a signal from a signal array.
+ * \param L The Lua VM state.
+ * \param arr The signal array.
+ * \param id The signal id.
+ * \param nargs The number of arguments on the stack, they are popped.
+ */
+void
+signal_object_emit_id(lua_State *L, signal_array_t *arr, signal_id_t id, int nargs)
+{
+    signal_t *sigfound = signal_array_getbyid(arr, id);
 
     if(sigfound)
     {
@@ -267,18 +279,38 @@ void
 luaA_object_emit_signal(lua_State *L, int oud,
                         const char *name, int nargs)
 {
+    luaA_object_emit_signal_id(L, oud, signal_lookup_id(name), nargs);
+}
+
+/** Emit a signal on an object and then on its class.
+ * \param L The Lua VM state.
+ * \param oud The object index on the stack.
+ * \param id The signal id, see SIGNAL_ID().
+ * \param nargs The number of arguments on the stack, they are popped.
+ */
+void
+luaA_object_emit_signal_id(lua_State *L, int oud,
+                           signal_id_t id, int nargs)
+{
+    /* Nothing anywhere is connected to this signal */
+    if(!signal_has_listeners(id))
+    {
+        lua_pop(L, nargs);
+        return;
+    }
+
     int oud_abs = luaA_absindex(L, oud);
     lua_class_t *lua_class = luaA_class_get(L, oud);
     lua_object_t *obj = luaA_toudata(L, oud, lua_class);
     if(!obj) {
-        luaA_warn(L, "Trying to emit signal '%s' on non-object", name);
+        luaA_warn(L, "Trying to emit signal '%s' on non-object", signal_id_name(id));
         return;
     }
     else if(lua_class->checker && !lua_class->checker(obj)) {
-        luaA_warn(L, "Trying to emit signal '%s' on invalid object", name);
+        luaA_warn(L, "Trying to emit signal '%s' on invalid object", signal_id_name(id));
         return;
     }
-    signal_t *sigfound = signal_array_getbyname(&obj->signals, name);
+    signal_t *sigfound = signal_array_getbyid(&obj->signals, id);
     if(sigfound)
     {
         int nbfunc = sigfound->sigfuncs.len;
@@ -306,7 +338,7 @@ luaA_object_emit_signal(lua_State *L, int oud,
     /* Then emit signal on the class */
     lua_pushvalue(L, oud);
     lua_insert(L, - nargs - 1);
-    luaA_class_emit_signal(L, luaA_class_get(L, - nargs - 1), name, nargs + 1);
+    signal_object_emit_id(L, &luaA_class_get(L, - nargs - 1)->signals, id, nargs + 1);
 }
 
 int
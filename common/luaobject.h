@@ -150,12 +150,14 @@ luaA_object_push(lua_State *L, const void *pointer)
 }
 
 void signal_object_emit(lua_State *, signal_array_t *, const char *, int);
+void signal_object_emit_id(lua_State *, signal_array_t *, signal_id_t, int);
 
 void luaA_object_connect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_disconnect_signal(lua_State *, int, const char *, lua_CFunction);
 void luaA_object_connect_signal_from_stack(lua_State *, int, const char *, int);
 void luaA_object_disconnect_signal_from_stack(lua_State *, int, const char *, int);
 void luaA_object_emit_signal(lua_State *, int, const char *, int);
+void luaA_object_emit_signal_id(lua_State *, int, signal_id_t, int);
 
 int luaA_object_connect_signal_simple(lua_State *);
 int luaA_object_disconnect_signal_simple(lua_State *);
@@ -0,0 +1,161 @@
+/*
+ * common/signal.c - Signal name interning
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/signal.h"
+
+#define SIGNAL_INTERN_MIN_SIZE 256
+
+/** All signal names ever connected to or used with SIGNAL_ID().
+ * Ids are dense and start at 1, so they index names and listeners directly.
+ */
+static struct
+{
+    /** Open-addressing hash table of ids, 0 is an empty slot */
+    signal_id_t *slots;
+    int size;
+    /** Name of each id, index 0 is unused */
+    char **names;
+    /** Number of functions connected to each id, over all signal arrays */
+    unsigned int *listeners;
+    /** Number of ids handed out plus one, and the allocated length of names
+     * and listeners */
+    int count, capacity;
+} signal_intern_table = { .count = 1 };
+
+static int
+signal_intern_slot(const char *name, int size)
+{
+    return a_strhash((const unsigned char *) name) & (size - 1);
+}
+
+static void
+signal_intern_rehash(int size)
+{
+    p_delete(&signal_intern_table.slots);
+    signal_intern_table.slots = p_new(signal_id_t, size);
+    signal_intern_table.size = size;
+
+    for(signal_id_t id = 1; id < (signal_id_t) signal_intern_table.count; id++)
+    {
+        int i = signal_intern_slot(signal_intern_table.names[id], size);
+        while(signal_intern_table.slots[i])
+            i = (i + 1) & (size - 1);
+        signal_intern_table.slots[i] = id;
+    }
+}
+
+/** Find the slot holding a name or the empty slot where it belongs.
+ * \param name The signal name.
+ * \return The slot.
+ */
+static signal_id_t *
+signal_intern_find(const char *name)
+{
+    int mask = signal_intern_table.size - 1;
+    for(int i = signal_intern_slot(name, signal_intern_table.size);; i = (i + 1) & mask)
+    {
+        signal_id_t id = signal_intern_table.slots[i];
+        if(!id || !a_strcmp(signal_intern_table.names[id], name))
+            return &signal_intern_table.slots[i];
+    }
+}
+
+/** Get the id of a signal name, allocating a new id for unknown names.
+ * \param name The signal name.
+ * \return The id, never 0.
+ */
+signal_id_t
+signal_intern(const char *name)
+{
+    name = NONULL(name);
+
+    /* Keep the load factor below 1/2 */
+    if(signal_intern_table.count * 2 > signal_intern_table.size)
+        signal_intern_rehash(MAX(SIGNAL_INTERN_MIN_SIZE, signal_intern_table.size * 2));
+
+    signal_id_t *slot = signal_intern_find(name);
+    if(*slot)
+        return *slot;
+
+    if(signal_intern_table.count >= signal_intern_table.capacity)
+    {
+        int capacity = MAX(SIGNAL_INTERN_MIN_SIZE, signal_intern_table.capacity * 2);
+        p_realloc(&signal_intern_table.names, capacity);
+        p_realloc(&signal_intern_table.listeners, capacity);
+        for(int i = signal_intern_table.capacity; i < capacity; i++)
+        {
+            signal_intern_table.names[i] = NULL;
+            signal_intern_table.listeners[i] = 0;
+        }
+        signal_intern_table.capacity = capacity;
+    }
+
+    signal_id_t id = signal_intern_table.count++;
+    signal_intern_table.names[id] = a_strdup(name);
+    *slot = id;
+    return id;
+}
+
+/** Get the id of a signal name without allocating one.
+ * \param name The signal name.
+ * \return The id, or 0 if nothing ever connected to this signal.
+ */
+signal_id_t
+signal_lookup_id(const char *name)
+{
+    if(!signal_intern_table.size)
+        return 0;
+    return *signal_intern_find(NONULL(name));
+}
+
+/** Get the name of an interned signal.
+ * \param id The id.
+ * \return The name.
+ */
+const char *
+signal_id_name(signal_id_t id)
+{
+    if(id == 0 || id >= (signal_id_t) signal_intern_table.count)
+        return NULL;
+    return signal_intern_table.names[id];
+}
+
+/** Check if any signal array has functions connected to a signal.
+ * \param id The id.
+ * \return False if emitting this signal cannot call anything.
+ */
+bool
+signal_has_listeners(signal_id_t id)
+{
+    return id && signal_intern_table.listeners[id] > 0;
+}
+
+/** Update the number of functions connected to a signal.
+ * \param id The id.
+ * \param delta The number of functions connected (or disconnected if negative).
+ */
+void
+signal_count_listeners(signal_id_t id, int delta)
+{
+    signal_intern_table.listeners[id] += delta;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
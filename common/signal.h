@@ -26,9 +26,29 @@
 
 DO_ARRAY(const void *, cptr, DO_NOTHING)
 
+/** An interned signal name, see signal_intern() */
+typedef unsigned int signal_id_t;
+
+signal_id_t signal_intern(const char *);
+signal_id_t signal_lookup_id(const char *);
+const char *signal_id_name(signal_id_t);
+bool signal_has_listeners(signal_id_t);
+void signal_count_listeners(signal_id_t, int);
+
+/** Get the id of a constant signal name. The name is only interned the first
+ * time this is evaluated, afterwards the id comes from a static variable.
+ */
+#define SIGNAL_ID(name) \
+    ({ \
+        static signal_id_t __signal_id; \
+        if(!__signal_id) \
+            __signal_id = signal_intern(name); \
+        __signal_id; \
+    })
+
 typedef struct
 {
-    unsigned long id;
+    signal_id_t id;
     cptr_array_t sigfuncs;
 } signal_t;
 
@@ -42,14 +62,17 @@ signal_cmp(const void *a, const void *b)
 static inline void
 signal_wipe(signal_t *sig)
 {
+    signal_count_listeners(sig->id, - sig->sigfuncs.len);
     cptr_array_wipe(&sig->sigfuncs);
 }
 
 DO_BARRAY(signal_t, signal, signal_wipe, signal_cmp)
 
 static inline signal_t *
-signal_array_getbyid(signal_array_t *arr, unsigned long id)
+signal_array_getbyid(signal_array_t *arr, signal_id_t id)
 {
+    if(!id || arr->len == 0)
+        return NULL;
     signal_t sig = { .id = id };
     return signal_array_lookup(arr, &sig);
 }
@@ -57,31 +80,42 @@ signal_array_getbyid(signal_array_t *arr, unsigned long id)
 static inline signal_t *
 signal_array_getbyname(signal_array_t *arr, const char *name)
 {
-    signal_t sig = { .id = a_strhash((const unsigned char *) NONULL(name)) };
-    return signal_array_lookup(arr, &sig);
+    return signal_array_getbyid(arr, signal_lookup_id(name));
 }
 
 /** Connect a signal inside a signal array.
  * You are in charge of reference counting.
  * \param arr The signal array.
- * \param name The signal name.
+ * \param id The signal id.
  * \param ref The reference to add.
  */
 static inline void
-signal_connect(signal_array_t *arr, const char *name, const void *ref)
+signal_connect_id(signal_array_t *arr, signal_id_t id, const void *ref)
 {
-    unsigned long tok = a_strhash((const unsigned char *) name);
-    signal_t *sigfound = signal_array_getbyid(arr, tok);
+    signal_t *sigfound = signal_array_getbyid(arr, id);
+    signal_count_listeners(id, 1);
     if(sigfound)
         cptr_array_append(&sigfound->sigfuncs, ref);
     else
     {
-        signal_t sig = { .id = tok };
+        signal_t sig = { .id = id };
         cptr_array_append(&sig.sigfuncs, ref);
         signal_array_insert(arr, sig);
     }
 }
 
+/** Connect a signal inside a signal array.
+ * You are in charge of reference counting.
+ * \param arr The signal array.
+ * \param name The signal name.
+ * \param ref The reference to add.
+ */
+static inline void
+signal_connect(signal_array_t *arr, const char *name, const void *ref)
+{
+    signal_connect_id(arr, signal_intern(name), ref);
+}
+
 /** Disconnect a signal inside a signal array.
  * You are in charge of reference counting.
  * \param arr The signal array.
@@ -98,8 +132,12 @@ signal_disconnect(signal_array_t *arr, const char *name, const void *ref)
             if(ref == *func)
             {
                 cptr_array_remove(&sigfound->sigfuncs, func);
+                signal_count_listeners(sigfound->id, -1);
                 if(sigfound->sigfuncs.len == 0)
-                    signal_array_remove(arr, sigfound);
+                {
+                    signal_t sig = signal_array_remove(arr, sigfound);
+                    signal_wipe(&sig);
+                }
                 return true;
             }
     }
@@ -0,0 +1,375 @@
+/*
+ * spatialindex.c - rectangle to object index
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/spatialindex.h"
+
+/** Get the cell containing a coordinate, rounding towards minus infinity.
+ * Windows can be placed at negative coordinates.
+ */
+static inline int
+spatialindex_coord(int v)
+{
+    if(v >= 0)
+        return v / SPATIALINDEX_CELL_SIZE;
+    return -((-v - 1) / SPATIALINDEX_CELL_SIZE) - 1;
+}
+
+static inline spatialindex_cell_array_t *
+spatialindex_cell_get(spatialindex_t *idx, int cx, int cy)
+{
+    return &idx->cells[(cy - idx->cy0) * idx->cols + (cx - idx->cx0)];
+}
+
+static void
+spatialindex_link(spatialindex_t *idx, spatialindex_item_t *item)
+{
+    for(int cy = item->cy1; cy <= item->cy2; cy++)
+        for(int cx = item->cx1; cx <= item->cx2; cx++)
+            spatialindex_cell_array_append(spatialindex_cell_get(idx, cx, cy), item);
+}
+
+static void
+spatialindex_unlink(spatialindex_t *idx, spatialindex_item_t *item)
+{
+    for(int cy = item->cy1; cy <= item->cy2; cy++)
+        for(int cx = item->cx1; cx <= item->cx2; cx++)
+        {
+            spatialindex_cell_array_t *cell = spatialindex_cell_get(idx, cx, cy);
+            for(int i = 0; i < cell->len; i++)
+                if(cell->tab[i] == item)
+                {
+                    spatialindex_cell_array_take(cell, i);
+                    break;
+                }
+        }
+}
+
+/** Make the grid cover a range of cells. The existing cells are moved over as
+ * they are, so the order of items in them does not change.
+ */
+static void
+spatialindex_grow(spatialindex_t *idx, int cx1, int cy1, int cx2, int cy2)
+{
+    if(idx->cells)
+    {
+        if(cx1 >= idx->cx0 && cy1 >= idx->cy0
+           && cx2 < idx->cx0 + idx->cols && cy2 < idx->cy0 + idx->rows)
+            return;
+        cx1 = MIN(cx1, idx->cx0);
+        cy1 = MIN(cy1, idx->cy0);
+        cx2 = MAX(cx2, idx->cx0 + idx->cols - 1);
+        cy2 = MAX(cy2, idx->cy0 + idx->rows - 1);
+    }
+
+    spatialindex_t grown = {
+        .cx0 = cx1,
+        .cy0 = cy1,
+        .cols = cx2 - cx1 + 1,
+        .rows = cy2 - cy1 + 1,
+    };
+    grown.cells = p_new(spatialindex_cell_array_t, grown.cols * grown.rows);
+
+    for(int row = 0; row < idx->rows; row++)
+        for(int col = 0; col < idx->cols; col++)
+            *spatialindex_cell_get(&grown, idx->cx0 + col, idx->cy0 + row) =
+                idx->cells[row * idx->cols + col];
+
+    p_delete(&idx->cells);
+    idx->cells = grown.cells;
+    idx->cx0 = grown.cx0;
+    idx->cy0 = grown.cy0;
+    idx->cols = grown.cols;
+    idx->rows = grown.rows;
+}
+
+static spatialindex_item_t **
+spatialindex_lookup(spatialindex_t *idx, void *object)
+{
+    spatialindex_item_t key = { .object = object }, *keyp = &key;
+    return spatialindex_item_array_lookup(&idx->items, &keyp);
+}
+
+/** Free all memory used by an index.
+ * \param idx The index.
+ */
+void
+spatialindex_wipe(spatialindex_t *idx)
+{
+    foreach(item, idx->items)
+        p_delete(item);
+    spatialindex_item_array_wipe(&idx->items);
+    for(int i = 0; i < idx->cols * idx->rows; i++)
+        spatialindex_cell_array_wipe(&idx->cells[i]);
+    p_delete(&idx->cells);
+    p_clear(idx, 1);
+}
+
+/** Add an object to an index or move it to a new rectangle.
+ * \param idx The index.
+ * \param object The object.
+ * \param x X coordinate of the rectangle.
+ * \param y Y coordinate of the rectangle.
+ * \param width Width of the rectangle.
+ * \param height Height of the rectangle.
+ */
+void
+spatialindex_set(spatialindex_t *idx, void *object, int x, int y, int width, int height)
+{
+    spatialindex_item_t **found = spatialindex_lookup(idx, object);
+    spatialindex_item_t *item;
+
+    width = MAX(width, 0);
+    height = MAX(height, 0);
+
+    if(found)
+    {
+        item = *found;
+        if(item->x == x && item->y == y && item->width == width && item->height == height)
+            return;
+        spatialindex_unlink(idx, item);
+    }
+    else
+    {
+        item = p_new(spatialindex_item_t, 1);
+        item->object = object;
+        spatialindex_item_array_insert(&idx->items, item);
+    }
+
+    item->x = x;
+    item->y = y;
+    item->width = width;
+    item->height = height;
+    /* Register the closed rectangle, so that every corner of the item is in
+     * one of its cells */
+    item->cx1 = spatialindex_coord(x);
+    item->cy1 = spatialindex_coord(y);
+    item->cx2 = spatialindex_coord(x + width);
+    item->cy2 = spatialindex_coord(y + height);
+
+    spatialindex_grow(idx, item->cx1, item->cy1, item->cx2, item->cy2);
+    spatialindex_link(idx, item);
+}
+
+/** Remove an object from an index. Unknown objects are ignored.
+ * \param idx The index.
+ * \param object The object.
+ */
+void
+spatialindex_remove(spatialindex_t *idx, void *object)
+{
+    spatialindex_item_t **found = spatialindex_lookup(idx, object);
+    if(!found)
+        return;
+
+    spatialindex_item_t *item = *found;
+    spatialindex_unlink(idx, item);
+    spatialindex_item_array_remove(&idx->items, found);
+    p_delete(&item);
+}
+
+/** Get the items that might contain a point.
+ * \param idx The index.
+ * \param x X coordinate.
+ * \param y Y coordinate.
+ * \return The cell containing the point or NULL if nothing can be there. Not
+ * every item in the cell contains the point, see spatialindex_item_contains().
+ */
+spatialindex_cell_array_t *
+spatialindex_cell(spatialindex_t *idx, int x, int y)
+{
+    int cx = spatialindex_coord(x), cy = spatialindex_coord(y);
+
+    if(!idx->cells
+       || cx < idx->cx0 || cx >= idx->cx0 + idx->cols
+       || cy < idx->cy0 || cy >= idx->cy0 + idx->rows)
+        return NULL;
+
+    return spatialindex_cell_get(idx, cx, cy);
+}
+
+/** The state of a spatialindex_in_direction() query */
+typedef struct
+{
+    spatialindex_direction_t dir;
+    /** The source rectangle's position and the point distances are measured
+     * from */
+    int x, y;
+    double qx, qy;
+    spatialindex_filter_t filter;
+    spatialindex_before_t before;
+    void *data;
+    /** The nearest item so far and its squared distance */
+    spatialindex_item_t *best;
+    double best_dist;
+} spatialindex_query_t;
+
+/** Check if an item is in the direction of a query.
+ * \param q The query.
+ * \param item The item.
+ * \param px Set to the point of the item that distances are measured to.
+ * \param py Set to the point of the item that distances are measured to.
+ * \return True if the item is in the direction.
+ */
+static inline bool
+spatialindex_query_check(spatialindex_query_t *q, spatialindex_item_t *item, int *px, int *py)
+{
+    *px = item->x;
+    *py = item->y;
+
+    switch(q->dir)
+    {
+    case SPATIALINDEX_UP:
+        *py += item->height;
+        return q->y > item->y;
+    case SPATIALINDEX_DOWN:
+        return q->y < item->y;
+    case SPATIALINDEX_LEFT:
+        *px += item->width;
+        return q->x > item->x;
+    case SPATIALINDEX_RIGHT:
+        return q->x < item->x;
+    }
+    return false;
+}
+
+static inline void
+spatialindex_query_offer(spatialindex_query_t *q, spatialindex_item_t *item, int px, int py)
+{
+    if(q->filter && !q->filter(item->object, q->data))
+        return;
+
+    double dist = (px - q->qx) * (px - q->qx) + (py - q->qy) * (py - q->qy);
+    if(!q->best || dist < q->best_dist
+       || (dist == q->best_dist && q->before
+           && q->before(item->object, q->best->object, q->data)))
+    {
+        q->best = item;
+        q->best_dist = dist;
+    }
+}
+
+/** Find the nearest object in a direction, with the same rules as
+ * gears.geometry.rectangle.get_in_direction(): An object is in the direction
+ * if its top left corner is, and the distance is measured between the edge of
+ * the source rectangle facing the direction and the opposite edge of the
+ * object.
+ *
+ * The search looks at squares of cells of growing size around the source
+ * until nothing outside of the square can be nearer than what was found.
+ * \param idx The index.
+ * \param dir The direction.
+ * \param x X coordinate of the source rectangle.
+ * \param y Y coordinate of the source rectangle.
+ * \param width Width of the source rectangle.
+ * \param height Height of the source rectangle.
+ * \param filter If not NULL, only objects it returns true for are considered.
+ * \param before Breaks ties between objects at the same distance. If NULL, the
+ * object found first wins, which depends on how the index is laid out.
+ * \param data Passed to the filter and to before.
+ * \return The nearest object or NULL.
+ */
+void *
+spatialindex_in_direction(spatialindex_t *idx, spatialindex_direction_t dir,
+                          int x, int y, int width, int height,
+                          spatialindex_filter_t filter, spatialindex_before_t before,
+                          void *data)
+{
+    spatialindex_query_t q = {
+        .dir = dir,
+        .x = x,
+        .y = y,
+        .qx = dir == SPATIALINDEX_RIGHT ? x + width : x,
+        .qy = dir == SPATIALINDEX_DOWN ? y + height : y,
+        .filter = filter,
+        .before = before,
+        .data = data,
+    };
+    int px, py;
+
+    if(!idx->cells)
+        return NULL;
+
+    /* Walking the grid does not pay off for a handful of items */
+    if(idx->items.len <= SPATIALINDEX_LINEAR_MAX)
+    {
+        foreach(item, idx->items)
+            if(spatialindex_query_check(&q, *item, &px, &py))
+                spatialindex_query_offer(&q, *item, px, py);
+        return q.best ? q.best->object : NULL;
+    }
+
+    /* The part of the grid that can contain the points of candidates. Below
+     * and right of the source, these are their top left corners. */
+    int gx1 = idx->cx0, gy1 = idx->cy0;
+    int gx2 = idx->cx0 + idx->cols - 1, gy2 = idx->cy0 + idx->rows - 1;
+    if(dir == SPATIALINDEX_DOWN)
+        gy1 = MAX(gy1, spatialindex_coord(y));
+    else if(dir == SPATIALINDEX_RIGHT)
+        gx1 = MAX(gx1, spatialindex_coord(x));
+    if(gx1 > gx2 || gy1 > gy2)
+        return NULL;
+
+    int qcx = MAX(gx1, MIN(gx2, spatialindex_coord(q.qx)));
+    int qcy = MAX(gy1, MIN(gy2, spatialindex_coord(q.qy)));
+
+    for(int r = 0;; r++)
+    {
+        int x1 = qcx - r, x2 = qcx + r, y1 = qcy - r, y2 = qcy + r;
+
+        for(int cy = MAX(y1, gy1); cy <= MIN(y2, gy2); cy++)
+        {
+            /* The inner cells were visited in earlier rounds */
+            int step = (cy == y1 || cy == y2) ? 1 : x2 - x1;
+            for(int cx = x1; cx <= x2; cx += step)
+            {
+                if(cx < gx1 || cx > gx2)
+                    continue;
+
+                spatialindex_cell_array_t *cell = spatialindex_cell_get(idx, cx, cy);
+                foreach(item, *cell)
+                    /* Items are in several cells, only look at them in the
+                     * one containing their point */
+                    if(spatialindex_query_check(&q, *item, &px, &py)
+                       && spatialindex_coord(px) == cx && spatialindex_coord(py) == cy)
+                        spatialindex_query_offer(&q, *item, px, py);
+            }
+        }
+
+        if(x1 <= gx1 && y1 <= gy1 && x2 >= gx2 && y2 >= gy2)
+            break;
+
+        /* Everything not visited yet is outside of the square. Something
+         * on its border could still tie with the best item so far. */
+        if(q.best)
+        {
+            double margin = MIN(MIN(q.qx - (double) x1 * SPATIALINDEX_CELL_SIZE,
+                                    (x2 + 1.0) * SPATIALINDEX_CELL_SIZE - q.qx),
+                                MIN(q.qy - (double) y1 * SPATIALINDEX_CELL_SIZE,
+                                    (y2 + 1.0) * SPATIALINDEX_CELL_SIZE - q.qy));
+            if(margin >= 0 && margin * margin > q.best_dist)
+                break;
+        }
+    }
+
+    return q.best ? q.best->object : NULL;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,104 @@
+/*
+ * spatialindex.h - rectangle to object index header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_SPATIALINDEX_H
+#define AWESOME_COMMON_SPATIALINDEX_H
+
+#include "common/array.h"
+
+/** The width and height of a grid cell in pixels */
+#define SPATIALINDEX_CELL_SIZE 256
+/** Up to this many items, direction queries just look at all of them */
+#define SPATIALINDEX_LINEAR_MAX 64
+
+typedef enum
+{
+    SPATIALINDEX_UP,
+    SPATIALINDEX_DOWN,
+    SPATIALINDEX_LEFT,
+    SPATIALINDEX_RIGHT
+} spatialindex_direction_t;
+
+typedef struct
+{
+    /** The object this rectangle belongs to */
+    void *object;
+    /** The rectangle */
+    int x, y, width, height;
+    /** The range of cells the item is registered in (inclusive) */
+    int cx1, cy1, cx2, cy2;
+} spatialindex_item_t;
+
+static inline int
+spatialindex_item_cmp(const void *a, const void *b)
+{
+    void *x = (*(spatialindex_item_t * const *) a)->object;
+    void *y = (*(spatialindex_item_t * const *) b)->object;
+    return x > y ? 1 : (x < y ? -1 : 0);
+}
+
+DO_ARRAY(spatialindex_item_t *, spatialindex_cell, DO_NOTHING)
+DO_BARRAY(spatialindex_item_t *, spatialindex_item, DO_NOTHING, spatialindex_item_cmp)
+
+/** A uniform grid of cells, each listing the rectangles that touch it.
+ * The grid covers the bounding box of everything that was ever inserted and
+ * grows when needed. Within a cell, items keep the order they were inserted in.
+ */
+typedef struct
+{
+    /** All items, sorted by their object */
+    spatialindex_item_array_t items;
+    /** The cells, row by row */
+    spatialindex_cell_array_t *cells;
+    /** The coordinates of the first cell (in cells) and the grid's size */
+    int cx0, cy0, cols, rows;
+} spatialindex_t;
+
+/** Decides if a candidate of a query should be considered */
+typedef bool (*spatialindex_filter_t)(void *object, void *data);
+/** Decides if a candidate of a query is preferred over another one at the same
+ * distance */
+typedef bool (*spatialindex_before_t)(void *object, void *other, void *data);
+
+void spatialindex_wipe(spatialindex_t *);
+void spatialindex_set(spatialindex_t *, void *, int, int, int, int);
+void spatialindex_remove(spatialindex_t *, void *);
+spatialindex_cell_array_t * spatialindex_cell(spatialindex_t *, int, int);
+void * spatialindex_in_direction(spatialindex_t *, spatialindex_direction_t,
+                                 int, int, int, int,
+                                 spatialindex_filter_t, spatialindex_before_t,
+                                 void *);
+
+/** Is a point inside an item's rectangle?
+ * \param item The item.
+ * \param x X coordinate.
+ * \param y Y coordinate.
+ * \return True if the point is inside.
+ */
+static inline bool
+spatialindex_item_contains(spatialindex_item_t *item, int x, int y)
+{
+    return x >= item->x && x < item->x + item->width
+        && y >= item->y && y < item->y + item->height;
+}
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,150 @@
+/*
+ * windowindex.c - window id to object index
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/windowindex.h"
+
+#include <stdint.h>
+
+#define WINDOWINDEX_MIN_SIZE 64
+
+/** Get the preferred slot of a window.
+ * Window ids are allocated sequentially per X11 client, so scramble the bits
+ * (Fibonacci hashing) to spread consecutive ids over the table.
+ */
+static inline int
+windowindex_slot(windowindex_t *idx, xcb_window_t win)
+{
+    uint32_t h = (uint32_t) win * UINT32_C(2654435769);
+    return (h ^ (h >> 16)) & (idx->size - 1);
+}
+
+static void
+windowindex_resize(windowindex_t *idx, int size)
+{
+    windowindex_entry_t *old = idx->tab;
+    int old_size = idx->size;
+
+    idx->tab = p_new(windowindex_entry_t, size);
+    idx->size = size;
+    idx->len = 0;
+
+    for(int i = 0; i < old_size; i++)
+        if(old[i].window != XCB_NONE)
+            windowindex_insert(idx, old[i].window, old[i].role, old[i].object);
+
+    p_delete(&old);
+}
+
+/** Free all memory used by an index.
+ * \param idx The index.
+ */
+void
+windowindex_wipe(windowindex_t *idx)
+{
+    p_delete(&idx->tab);
+    idx->len = idx->size = 0;
+}
+
+/** Add a window to an index, replacing any previous entry for it.
+ * \param idx The index.
+ * \param win The window id, must not be XCB_NONE.
+ * \param role What the window is used for.
+ * \param object The object owning the window.
+ */
+void
+windowindex_insert(windowindex_t *idx, xcb_window_t win, window_role_t role, void *object)
+{
+    assert(win != XCB_NONE);
+
+    /* Keep the load factor below 3/4 */
+    if((idx->len + 1) * 4 > idx->size * 3)
+        windowindex_resize(idx, MAX(WINDOWINDEX_MIN_SIZE, idx->size * 2));
+
+    int mask = idx->size - 1;
+    for(int i = windowindex_slot(idx, win);; i = (i + 1) & mask)
+    {
+        windowindex_entry_t *entry = &idx->tab[i];
+        if(entry->window == XCB_NONE)
+            idx->len++;
+        else if(entry->window != win)
+            continue;
+        entry->window = win;
+        entry->role = role;
+        entry->object = object;
+        return;
+    }
+}
+
+/** Find the entry of a window.
+ * \param idx The index.
+ * \param win The window id.
+ * \return The entry or NULL if the window is unknown.
+ */
+windowindex_entry_t *
+windowindex_lookup(windowindex_t *idx, xcb_window_t win)
+{
+    if(idx->len == 0 || win == XCB_NONE)
+        return NULL;
+
+    int mask = idx->size - 1;
+    for(int i = windowindex_slot(idx, win);; i = (i + 1) & mask)
+    {
+        if(idx->tab[i].window == win)
+            return &idx->tab[i];
+        if(idx->tab[i].window == XCB_NONE)
+            return NULL;
+    }
+}
+
+/** Remove a window from an index. Unknown windows are ignored.
+ * \param idx The index.
+ * \param win The window id.
+ */
+void
+windowindex_remove(windowindex_t *idx, xcb_window_t win)
+{
+    windowindex_entry_t *entry = windowindex_lookup(idx, win);
+    if(!entry)
+        return;
+
+    int mask = idx->size - 1;
+    int hole = entry - idx->tab;
+
+    /* Shift following entries of the same probe sequence back into the hole so
+     * that lookups never have to skip over deleted slots. */
+    for(int i = (hole + 1) & mask; idx->tab[i].window != XCB_NONE; i = (i + 1) & mask)
+    {
+        int home = windowindex_slot(idx, idx->tab[i].window);
+        /* Is home cyclically in (hole, i]? Then this entry has to stay. */
+        bool stays = hole <= i
+            ? (hole < home && home <= i)
+            : (hole < home || home <= i);
+        if(stays)
+            continue;
+        idx->tab[hole] = idx->tab[i];
+        hole = i;
+    }
+
+    p_clear(&idx->tab[hole], 1);
+    idx->len--;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,85 @@
+/*
+ * windowindex.h - window id to object index header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_COMMON_WINDOWINDEX_H
+#define AWESOME_COMMON_WINDOWINDEX_H
+
+#include <xcb/xcb.h>
+
+#include "common/util.h"
+
+/** What a window is used for by the object owning it */
+typedef enum
+{
+    WINDOW_ROLE_NONE = 0,
+    /** The client's own window */
+    WINDOW_ROLE_CLIENT,
+    /** The frame window we reparent a client into */
+    WINDOW_ROLE_FRAME,
+    /** The window used for focusing clients that do not take input */
+    WINDOW_ROLE_NOFOCUS,
+    /** A (mapped) drawin's window */
+    WINDOW_ROLE_DRAWIN
+} window_role_t;
+
+typedef struct
+{
+    /** The window id, XCB_NONE for an empty slot */
+    xcb_window_t window;
+    /** What the window is used for */
+    window_role_t role;
+    /** The object owning the window */
+    void *object;
+} windowindex_entry_t;
+
+/** An open-addressing hash table mapping window ids to their owner.
+ * Collisions are resolved with linear probing, removal uses backward shifting
+ * so that no tombstones are needed.
+ */
+typedef struct
+{
+    windowindex_entry_t *tab;
+    /** Number of used slots and number of allocated slots (a power of two) */
+    int len, size;
+} windowindex_t;
+
+void windowindex_wipe(windowindex_t *);
+void windowindex_insert(windowindex_t *, xcb_window_t, window_role_t, void *);
+void windowindex_remove(windowindex_t *, xcb_window_t);
+windowindex_entry_t * windowindex_lookup(windowindex_t *, xcb_window_t);
+
+/** Get the object owning a window, but only if it has the given role.
+ * \param idx The index to search.
+ * \param win The window id.
+ * \param role The role the window has to have.
+ * \return The object or NULL.
+ */
+static inline void *
+windowindex_get(windowindex_t *idx, xcb_window_t win, window_role_t role)
+{
+    windowindex_entry_t *entry = windowindex_lookup(idx, win);
+    if(entry && entry->role == role)
+        return entry->object;
+    return NULL;
+}
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
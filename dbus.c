@@ -38,6 +38,7 @@
 
 #include "event.h"
 #include "luaa.h"
+#include "profile.h"
 
 static DBusConnection *dbus_connection_session = NULL;
 static DBusConnection *dbus_connection_system = NULL;
@@ -46,6 +47,105 @@ static GSource *system_source = NULL;
 
 static signal_array_t dbus_signals;
 
+/** Which messages an interface's handler wants */
+typedef struct
+{
+    char *interface;
+    /** Only these members are delivered, all if empty */
+    string_array_t members;
+    /** Pass containers as proxies that are decoded on first access */
+    bool lazy;
+} dbus_filter_t;
+
+static void
+dbus_filter_wipe(dbus_filter_t *filter)
+{
+    p_delete(&filter->interface);
+    string_array_wipe(&filter->members);
+}
+
+DO_ARRAY(dbus_filter_t, dbus_filter, dbus_filter_wipe)
+
+static dbus_filter_array_t dbus_filters;
+
+/** Counters for the messages received for an interface */
+typedef struct
+{
+    char *interface;
+    /** Number of messages received */
+    unsigned long messages;
+    /** Number of messages dropped without being decoded */
+    unsigned long filtered;
+    /** Size of the argument data converted to Lua values */
+    unsigned long bytes;
+    /** Time spent converting arguments in seconds */
+    double decode_time;
+} dbus_interface_stats_t;
+
+static void
+dbus_interface_stats_wipe(dbus_interface_stats_t *stats)
+{
+    p_delete(&stats->interface);
+}
+
+static int
+dbus_interface_stats_cmp(const void *a, const void *b)
+{
+    const dbus_interface_stats_t *x = a, *y = b;
+    return a_strcmp(x->interface, y->interface);
+}
+
+DO_BARRAY(dbus_interface_stats_t, dbus_interface_stats, dbus_interface_stats_wipe, dbus_interface_stats_cmp)
+
+static dbus_interface_stats_array_t dbus_stats;
+
+/** Bytes of argument data converted so far, see dbus_interface_stats_t */
+static unsigned long a_dbus_decoded_bytes;
+
+/** Get the counters of an interface, creating them if needed.
+ * \param interface The interface name, may be NULL.
+ * \return The counters.
+ */
+static dbus_interface_stats_t *
+a_dbus_interface_stats(const char *interface)
+{
+    dbus_interface_stats_t needle = { .interface = (char *) NONULL(interface) };
+    dbus_interface_stats_t *stats = dbus_interface_stats_array_lookup(&dbus_stats, &needle);
+
+    if(!stats)
+    {
+        needle.interface = a_strdup(needle.interface);
+        dbus_interface_stats_array_insert(&dbus_stats, needle);
+        stats = dbus_interface_stats_array_lookup(&dbus_stats, &needle);
+    }
+    return stats;
+}
+
+static dbus_filter_t *
+a_dbus_filter_getbyname(const char *interface)
+{
+    foreach(filter, dbus_filters)
+        if(A_STREQ(filter->interface, interface))
+            return filter;
+    return NULL;
+}
+
+/** Does the handler of an interface want a message?
+ * \param filter The interface's filter or NULL.
+ * \param member The message's member.
+ * \return True if the message should be decoded and delivered.
+ */
+static bool
+a_dbus_filter_accepts(dbus_filter_t *filter, const char *member)
+{
+    if(!filter || filter->members.len == 0)
+        return true;
+    foreach(m, filter->members)
+        if(A_STREQ(*m, member))
+            return true;
+    return false;
+}
+
 /** Clean up the D-Bus connection data members
  * \param dbus_connection The D-Bus connection to clean up
  * \param source The D-Bus source
@@ -66,51 +166,146 @@ a_dbus_cleanup_bus(DBusConnection *dbus_connection, GSource **source)
     dbus_connection_unref(dbus_connection);
 }
 
-/** Iterate through the D-Bus messages counting each or traverse each sub message.
+static int a_dbus_message_iter(lua_State *, DBusMessageIter *);
+
+/** Convert the value an iterator points to.
+ * Dict entries push their key and their value but only count as one.
  * \param L The Lua VM state.
  * \param iter The D-Bus message iterator pointer
- * \return The number of arguments in the iterator
+ * \return The number of values converted, 0 at the end of the message
  */
 static int
-a_dbus_message_iter(lua_State *L, DBusMessageIter *iter)
+a_dbus_message_iter_value(lua_State *L, DBusMessageIter *iter)
 {
     int nargs = 0;
 
-    do
+    switch(dbus_message_iter_get_arg_type(iter))
     {
-        switch(dbus_message_iter_get_arg_type(iter))
+      default:
+        lua_pushnil(L);
+        nargs++;
+        break;
+      case DBUS_TYPE_INVALID:
+        break;
+      case DBUS_TYPE_VARIANT:
         {
-          default:
-            lua_pushnil(L);
-            nargs++;
-            break;
-          case DBUS_TYPE_INVALID:
-            break;
-          case DBUS_TYPE_VARIANT:
+            DBusMessageIter subiter;
+            dbus_message_iter_recurse(iter, &subiter);
+            a_dbus_message_iter(L, &subiter);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_DICT_ENTRY:
+        {
+            DBusMessageIter subiter;
+
+            /* initialize a sub iterator */
+            dbus_message_iter_recurse(iter, &subiter);
+            /* create a new table to store the dict */
+            a_dbus_message_iter(L, &subiter);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_STRUCT:
+        {
+            DBusMessageIter subiter;
+            /* initialize a sub iterator */
+            dbus_message_iter_recurse(iter, &subiter);
+
+            int n = a_dbus_message_iter(L, &subiter);
+
+            /* create a new table to store all the value */
+            lua_createtable(L, n, 0);
+            /* move the table before array elements */
+            lua_insert(L, - n - 1);
+
+            for(int i = n; i > 0; i--)
+                lua_rawseti(L, - i - 1, i);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_ARRAY:
+        {
+            int array_type = dbus_message_iter_get_element_type(iter);
+
+            if(dbus_type_is_fixed(array_type))
             {
-                DBusMessageIter subiter;
-                dbus_message_iter_recurse(iter, &subiter);
-                a_dbus_message_iter(L, &subiter);
+                DBusMessageIter sub;
+                dbus_message_iter_recurse(iter, &sub);
+
+                switch(array_type)
+                {
+                  int datalen;
+#define DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
+                  case dbustype: \
+                    { \
+                        const type *data; \
+                        dbus_message_iter_get_fixed_array(&sub, &data, &datalen); \
+                        a_dbus_decoded_bytes += datalen * sizeof(type); \
+                        lua_createtable(L, datalen, 0); \
+                        for(int i = 0; i < datalen; i++) \
+                        { \
+                            pusher(L, data[i]); \
+                            lua_rawseti(L, -2, i + 1); \
+                        } \
+                    } \
+                    break;
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
+                  DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
+#undef DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT
+                  case DBUS_TYPE_BYTE:
+                    {
+                        const char *c;
+                        dbus_message_iter_get_fixed_array(&sub, &c, &datalen);
+                        a_dbus_decoded_bytes += datalen;
+                        lua_pushlstring(L, c, datalen);
+                    }
+                    break;
+                  case DBUS_TYPE_BOOLEAN:
+                    {
+                        const dbus_bool_t *b;
+                        dbus_message_iter_get_fixed_array(&sub, &b, &datalen);
+                        a_dbus_decoded_bytes += datalen * sizeof(*b);
+                        lua_createtable(L, datalen, 0);
+                        for(int i = 0; i < datalen; i++)
+                        {
+                            lua_pushboolean(L, b[i]);
+                            lua_rawseti(L, -2, i + 1);
+                        }
+                    }
+                    break;
+                }
             }
-            nargs++;
-            break;
-          case DBUS_TYPE_DICT_ENTRY:
+            else if(array_type == DBUS_TYPE_DICT_ENTRY)
             {
                 DBusMessageIter subiter;
-
                 /* initialize a sub iterator */
                 dbus_message_iter_recurse(iter, &subiter);
-                /* create a new table to store the dict */
-                a_dbus_message_iter(L, &subiter);
+
+                /* get the keys and the values
+                 * n is the number of entry in dict */
+                int n = a_dbus_message_iter(L, &subiter);
+
+                /* create a new table to store all the value */
+                lua_createtable(L, n, 0);
+                /* move the table before array elements */
+                lua_insert(L, - (n * 2) - 1);
+
+                for(int i = 0; i < n; i ++)
+                    lua_rawset(L, - (n * 2) - 1 + i * 2);
             }
-            nargs++;
-            break;
-          case DBUS_TYPE_STRUCT:
+            else
             {
                 DBusMessageIter subiter;
-                /* initialize a sub iterator */
+                /* prepare to dig into the array*/
                 dbus_message_iter_recurse(iter, &subiter);
 
+                /* now iterate over every element of the array */
                 int n = a_dbus_message_iter(L, &subiter);
 
                 /* create a new table to store all the value */
@@ -121,145 +316,198 @@ a_dbus_message_iter(lua_State *L, DBusMessageIter *iter)
                 for(int i = n; i > 0; i--)
                     lua_rawseti(L, - i - 1, i);
             }
-            nargs++;
-            break;
-          case DBUS_TYPE_ARRAY:
-            {
-                int array_type = dbus_message_iter_get_element_type(iter);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_BOOLEAN:
+        {
+            dbus_bool_t b;
+            dbus_message_iter_get_basic(iter, &b);
+            a_dbus_decoded_bytes += sizeof(b);
+            lua_pushboolean(L, b);
+        }
+        nargs++;
+        break;
+      case DBUS_TYPE_BYTE:
+        {
+            char c;
+            dbus_message_iter_get_basic(iter, &c);
+            a_dbus_decoded_bytes += 1;
+            lua_pushlstring(L, &c, 1);
+        }
+        nargs++;
+        break;
+#define DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
+      case dbustype: \
+        { \
+            type ui; \
+            dbus_message_iter_get_basic(iter, &ui); \
+            a_dbus_decoded_bytes += sizeof(ui); \
+            pusher(L, ui); \
+        } \
+        nargs++; \
+        break;
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
+      DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
+#undef DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT
+      case DBUS_TYPE_STRING:
+        {
+            char *s;
+            dbus_message_iter_get_basic(iter, &s);
+            a_dbus_decoded_bytes += a_strlen(s) + 1;
+            lua_pushstring(L, s);
+        }
+        nargs++;
+        break;
+    }
 
-                if(dbus_type_is_fixed(array_type))
-                {
-                    DBusMessageIter sub;
-                    dbus_message_iter_recurse(iter, &sub);
+    return nargs;
+}
 
-                    switch(array_type)
-                    {
-                      int datalen;
-#define DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
-                      case dbustype: \
-                        { \
-                            const type *data; \
-                            dbus_message_iter_get_fixed_array(&sub, &data, &datalen); \
-                            lua_createtable(L, datalen, 0); \
-                            for(int i = 0; i < datalen; i++) \
-                            { \
-                                pusher(L, data[i]); \
-                                lua_rawseti(L, -2, i + 1); \
-                            } \
-                        } \
-                        break;
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
-                      DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
-#undef DBUS_MSG_HANDLE_ARRAY_TYPE_NUMBER_OR_INT
-                      case DBUS_TYPE_BYTE:
-                        {
-                            const char *c;
-                            dbus_message_iter_get_fixed_array(&sub, &c, &datalen);
-                            lua_pushlstring(L, c, datalen);
-                        }
-                        break;
-                      case DBUS_TYPE_BOOLEAN:
-                        {
-                            const dbus_bool_t *b;
-                            dbus_message_iter_get_fixed_array(&sub, &b, &datalen);
-                            lua_createtable(L, datalen, 0);
-                            for(int i = 0; i < datalen; i++)
-                            {
-                                lua_pushboolean(L, b[i]);
-                                lua_rawseti(L, -2, i + 1);
-                            }
-                        }
-                        break;
-                    }
-                }
-                else if(array_type == DBUS_TYPE_DICT_ENTRY)
-                {
-                    DBusMessageIter subiter;
-                    /* initialize a sub iterator */
-                    dbus_message_iter_recurse(iter, &subiter);
+/** Iterate through the D-Bus messages counting each or traverse each sub message.
+ * \param L The Lua VM state.
+ * \param iter The D-Bus message iterator pointer
+ * \return The number of arguments in the iterator
+ */
+static int
+a_dbus_message_iter(lua_State *L, DBusMessageIter *iter)
+{
+    int nargs = 0;
 
-                    /* get the keys and the values
-                     * n is the number of entry in dict */
-                    int n = a_dbus_message_iter(L, &subiter);
+    do
+        nargs += a_dbus_message_iter_value(L, iter);
+    while(dbus_message_iter_next(iter));
 
-                    /* create a new table to store all the value */
-                    lua_createtable(L, n, 0);
-                    /* move the table before array elements */
-                    lua_insert(L, - (n * 2) - 1);
+    return nargs;
+}
 
-                    for(int i = 0; i < n; i ++)
-                        lua_rawset(L, - (n * 2) - 1 + i * 2);
-                }
-                else
-                {
-                    DBusMessageIter subiter;
-                    /* prepare to dig into the array*/
-                    dbus_message_iter_recurse(iter, &subiter);
+#define DBUS_LAZY_METATABLE "awesome.dbus.lazy"
 
-                    /* now iterate over every element of the array */
-                    int n = a_dbus_message_iter(L, &subiter);
+/** A container argument that is only converted when it is accessed */
+typedef struct
+{
+    /** The message, NULL once the container was converted */
+    DBusMessage *msg;
+    /** Points to the container inside the message */
+    DBusMessageIter iter;
+} dbus_lazy_t;
 
-                    /* create a new table to store all the value */
-                    lua_createtable(L, n, 0);
-                    /* move the table before array elements */
-                    lua_insert(L, - n - 1);
+/** Convert a lazy container if this was not done yet.
+ * The table is kept as the userdata's user value.
+ * \param L The Lua VM state.
+ * \param idx The index of the lazy container.
+ * \return The converted table is pushed onto the stack.
+ */
+static void
+a_dbus_lazy_decode(lua_State *L, int idx)
+{
+    dbus_lazy_t *lazy = luaL_checkudata(L, idx, DBUS_LAZY_METATABLE);
 
-                    for(int i = n; i > 0; i--)
-                        lua_rawseti(L, - i - 1, i);
-                }
-            }
-            nargs++;
-            break;
-          case DBUS_TYPE_BOOLEAN:
-            {
-                dbus_bool_t b;
-                dbus_message_iter_get_basic(iter, &b);
-                lua_pushboolean(L, b);
-            }
-            nargs++;
-            break;
-          case DBUS_TYPE_BYTE:
-            {
-                char c;
-                dbus_message_iter_get_basic(iter, &c);
-                lua_pushlstring(L, &c, 1);
-            }
-            nargs++;
-            break;
-#define DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(type, dbustype, pusher) \
-          case dbustype: \
-            { \
-                type ui; \
-                dbus_message_iter_get_basic(iter, &ui); \
-                pusher(L, ui); \
-            } \
-            nargs++; \
-            break;
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int16_t, DBUS_TYPE_INT16, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint16_t, DBUS_TYPE_UINT16, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int32_t, DBUS_TYPE_INT32, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint32_t, DBUS_TYPE_UINT32, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(int64_t, DBUS_TYPE_INT64, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(uint64_t, DBUS_TYPE_UINT64, lua_pushinteger)
-          DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT(double, DBUS_TYPE_DOUBLE, lua_pushnumber)
-#undef DBUS_MSG_HANDLE_TYPE_NUMBER_OR_INT
-          case DBUS_TYPE_STRING:
-            {
-                char *s;
-                dbus_message_iter_get_basic(iter, &s);
-                lua_pushstring(L, s);
-            }
-            nargs++;
-            break;
-        }
-    } while(dbus_message_iter_next(iter));
+    idx = luaA_absindex(L, idx);
+    if(lazy->msg)
+    {
+        dbus_interface_stats_t *stats =
+            a_dbus_interface_stats(dbus_message_get_interface(lazy->msg));
+        unsigned long bytes = a_dbus_decoded_bytes;
+        gint64 start = g_get_monotonic_time();
+
+        a_dbus_message_iter_value(L, &lazy->iter);
+        lua_pushvalue(L, -1);
+        luaA_setuservalue(L, idx);
+        dbus_message_unref(lazy->msg);
+        lazy->msg = NULL;
+
+        stats->bytes += a_dbus_decoded_bytes - bytes;
+        stats->decode_time += (g_get_monotonic_time() - start) / 1e6;
+        return;
+    }
+    luaA_getuservalue(L, idx);
+}
 
-    return nargs;
+static int
+luaA_dbus_lazy_index(lua_State *L)
+{
+    a_dbus_lazy_decode(L, 1);
+    lua_pushvalue(L, 2);
+    lua_rawget(L, -2);
+    return 1;
+}
+
+static int
+luaA_dbus_lazy_len(lua_State *L)
+{
+    a_dbus_lazy_decode(L, 1);
+    lua_pushinteger(L, luaA_rawlen(L, -1));
+    return 1;
+}
+
+static int
+luaA_dbus_lazy_pairs(lua_State *L)
+{
+    lua_getglobal(L, "next");
+    a_dbus_lazy_decode(L, 1);
+    lua_pushnil(L);
+    return 3;
+}
+
+static int
+luaA_dbus_lazy_gc(lua_State *L)
+{
+    dbus_lazy_t *lazy = luaL_checkudata(L, 1, DBUS_LAZY_METATABLE);
+    if(lazy->msg)
+        dbus_message_unref(lazy->msg);
+    lazy->msg = NULL;
+    return 0;
+}
+
+/** Push a lazy container for the argument an iterator points to.
+ * \param L The Lua VM state.
+ * \param msg The message containing the argument.
+ * \param iter Points to the argument, which has to be a struct or an array.
+ */
+static void
+a_dbus_lazy_push(lua_State *L, DBusMessage *msg, DBusMessageIter *iter)
+{
+    static const struct luaL_Reg meta[] =
+    {
+        { "__index", luaA_dbus_lazy_index },
+        { "__len", luaA_dbus_lazy_len },
+        { "__pairs", luaA_dbus_lazy_pairs },
+        { "__gc", luaA_dbus_lazy_gc },
+        { NULL, NULL }
+    };
+    dbus_lazy_t *lazy = lua_newuserdata(L, sizeof(*lazy));
+
+    lazy->msg = dbus_message_ref(msg);
+    /* Iterators are plain structs and stay valid as long as the message */
+    lazy->iter = *iter;
+    if(luaL_newmetatable(L, DBUS_LAZY_METATABLE))
+        luaA_setfuncs(L, meta);
+    lua_setmetatable(L, -2);
+}
+
+/** Should an argument be converted lazily? Only containers whose conversion
+ * builds tables are worth it.
+ * \param iter Points to the argument.
+ * \return True for structs and arrays that do not contain fixed size values.
+ */
+static bool
+a_dbus_is_lazy_type(DBusMessageIter *iter)
+{
+    switch(dbus_message_iter_get_arg_type(iter))
+    {
+      case DBUS_TYPE_STRUCT:
+        return true;
+      case DBUS_TYPE_ARRAY:
+        return !dbus_type_is_fixed(dbus_message_iter_get_element_type(iter));
+      default:
+        return false;
+    }
 }
 
 static bool
@@ -353,9 +601,21 @@ static void
 a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg)
 {
     const char *interface = dbus_message_get_interface(msg);
+    dbus_interface_stats_t *stats = a_dbus_interface_stats(interface);
+    dbus_filter_t *filter = a_dbus_filter_getbyname(interface);
     lua_State *L = globalconf_get_lua_State();
     int old_top = lua_gettop(L);
 
+    stats->messages++;
+
+    /* Do not convert anything if nobody is interested in the message */
+    if(!signal_array_getbyname(&dbus_signals, interface)
+       || !a_dbus_filter_accepts(filter, dbus_message_get_member(msg)))
+    {
+        stats->filtered++;
+        return;
+    }
+
     lua_createtable(L, 0, 5);
 
     switch(dbus_message_get_type(msg))
@@ -405,10 +665,28 @@ a_dbus_process_request(DBusConnection *dbus_connection, DBusMessage *msg)
     /* + 1 for the table above */
     DBusMessageIter iter;
     int nargs = 1;
+    unsigned long bytes = a_dbus_decoded_bytes;
+    gint64 start = g_get_monotonic_time();
 
-    if(dbus_message_iter_init(msg, &iter))
+    if(!dbus_message_iter_init(msg, &iter))
+        ;
+    else if(filter && filter->lazy)
+        do
+        {
+            if(a_dbus_is_lazy_type(&iter))
+            {
+                a_dbus_lazy_push(L, msg, &iter);
+                nargs++;
+            }
+            else
+                nargs += a_dbus_message_iter_value(L, &iter);
+        } while(dbus_message_iter_next(&iter));
+    else
         nargs += a_dbus_message_iter(L, &iter);
 
+    stats->bytes += a_dbus_decoded_bytes - bytes;
+    stats->decode_time += (g_get_monotonic_time() - start) / 1e6;
+
     if(dbus_message_get_no_reply(msg))
     {
         signal_t *sigfound = signal_array_getbyname(&dbus_signals, interface);
@@ -505,14 +783,18 @@ a_dbus_process_requests_on_bus(DBusConnection *dbus_connection, GSource **source
 static gboolean
 a_dbus_process_requests_session(gpointer data)
 {
+    int64_t start = profile_now();
     a_dbus_process_requests_on_bus(dbus_connection_session, &session_source);
+    profile_record(PROFILE_DBUS, start);
     return TRUE;
 }
 
 static gboolean
 a_dbus_process_requests_system(gpointer data)
 {
+    int64_t start = profile_now();
     a_dbus_process_requests_on_bus(dbus_connection_system, &system_source);
+    profile_record(PROFILE_DBUS, start);
     return TRUE;
 }
 
@@ -749,9 +1031,19 @@ luaA_dbus_remove_match(lua_State *L)
 }
 
 /** Add a signal receiver on the D-Bus.
+ *
+ * Messages are only converted to Lua values when a receiver for their
+ * interface exists. The optional `options` table can restrict this further:
+ *
+ * * `members`: A list of member names. Messages for other members of the
+ *   interface are dropped without being converted.
+ * * `lazy`: When true, struct and array arguments are passed as proxies that
+ *   are only converted when they are first indexed. Use `dbus.decode` to get
+ *   a plain table, e.g. for `ipairs` with Lua 5.1.
  *
  * @param interface A string with the interface name.
  * @param func The function to call.
+ * @tparam[opt] table options Filtering options, see above.
  * @return true on success, nil + error if the signal could not be connected
  * because another function is already connected.
  * @function connect_signal
@@ -761,6 +1053,8 @@ luaA_dbus_connect_signal(lua_State *L)
 {
     const char *name = luaL_checkstring(L, 1);
     luaA_checkfunction(L, 2);
+    if(!lua_isnoneornil(L, 3))
+        luaA_checktable(L, 3);
     signal_t *sig = signal_array_getbyname(&dbus_signals, name);
     if(sig) {
         luaA_warn(L, "cannot add signal %s on D-Bus, already existing", name);
@@ -768,6 +1062,27 @@ luaA_dbus_connect_signal(lua_State *L)
         lua_pushfstring(L, "cannot add signal %s on D-Bus, already existing", name);
         return 2;
     } else {
+        if(!lua_isnoneornil(L, 3))
+        {
+            dbus_filter_t filter = { .interface = a_strdup(name) };
+
+            lua_getfield(L, 3, "lazy");
+            filter.lazy = lua_toboolean(L, -1);
+            lua_pop(L, 1);
+
+            lua_getfield(L, 3, "members");
+            if(lua_istable(L, -1))
+                for(size_t i = 1; i <= luaA_rawlen(L, -1); i++)
+                {
+                    lua_rawgeti(L, -1, i);
+                    if(lua_isstring(L, -1))
+                        string_array_append(&filter.members, a_strdup(lua_tostring(L, -1)));
+                    lua_pop(L, 1);
+                }
+            lua_pop(L, 1);
+
+            dbus_filter_array_append(&dbus_filters, filter);
+        }
         signal_connect(&dbus_signals, name, luaA_object_ref(L, 2));
         lua_pushboolean(L, 1);
         return 1;
@@ -787,10 +1102,74 @@ luaA_dbus_disconnect_signal(lua_State *L)
     luaA_checkfunction(L, 2);
     const void *func = lua_topointer(L, 2);
     if (signal_disconnect(&dbus_signals, name, func))
+    {
         luaA_object_unref(L, func);
+        dbus_filter_t *filter = a_dbus_filter_getbyname(name);
+        if(filter)
+        {
+            dbus_filter_wipe(filter);
+            dbus_filter_array_remove(&dbus_filters, filter);
+        }
+    }
     return 0;
 }
 
+/** Get the plain table for a value received with the `lazy` option.
+ *
+ * @param value A value passed to a D-Bus receiver.
+ * @return The converted table for lazy containers, otherwise `value` itself.
+ * @function decode
+ */
+static int
+luaA_dbus_decode(lua_State *L)
+{
+    luaL_checkany(L, 1);
+    if(lua_getmetatable(L, 1))
+    {
+        luaL_getmetatable(L, DBUS_LAZY_METATABLE);
+        bool lazy = lua_rawequal(L, -1, -2);
+        lua_pop(L, 2);
+        if(lazy)
+        {
+            a_dbus_lazy_decode(L, 1);
+            return 1;
+        }
+    }
+    lua_settop(L, 1);
+    return 1;
+}
+
+/** Get statistics about the received messages.
+ *
+ * The returned table has an entry for every interface that messages were
+ * received for. Each is a table with `messages` (number of messages),
+ * `filtered` (how many of them were dropped without being converted because
+ * no receiver wanted them), `bytes` (size of the argument data that was
+ * converted) and `decode_time` (seconds spent converting arguments).
+ *
+ * @treturn table The statistics.
+ * @function stats
+ */
+static int
+luaA_dbus_stats(lua_State *L)
+{
+    lua_createtable(L, 0, dbus_stats.len);
+    foreach(stats, dbus_stats)
+    {
+        lua_createtable(L, 0, 4);
+        lua_pushinteger(L, stats->messages);
+        lua_setfield(L, -2, "messages");
+        lua_pushinteger(L, stats->filtered);
+        lua_setfield(L, -2, "filtered");
+        lua_pushinteger(L, stats->bytes);
+        lua_setfield(L, -2, "bytes");
+        lua_pushnumber(L, stats->decode_time);
+        lua_setfield(L, -2, "decode_time");
+        lua_setfield(L, -2, stats->interface);
+    }
+    return 1;
+}
+
 /** Emit a signal on the D-Bus.
  *
  * @param bus A string indicating if we are using system or session bus.
@@ -855,6 +1234,8 @@ const struct luaL_Reg awesome_dbus_lib[] =
     { "connect_signal", luaA_dbus_connect_signal },
     { "disconnect_signal", luaA_dbus_disconnect_signal },
     { "emit_signal", luaA_dbus_emit_signal },
+    { "decode", luaA_dbus_decode },
+    { "stats", luaA_dbus_stats },
     { "__index", luaA_default_index },
     { "__newindex", luaA_default_newindex },
     { NULL, NULL }
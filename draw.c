@@ -22,6 +22,7 @@
 #include "config.h"
 #include "draw.h"
 #include "globalconf.h"
+#include "common/iconcache.h"
 
 #include <langinfo.h>
 #include <errno.h>
@@ -50,20 +51,11 @@ cairo_surface_t *
 draw_surface_from_data(int width, int height, uint32_t *data)
 {
     unsigned long int len = width * height;
-    unsigned long int i;
     uint32_t *buffer = p_new(uint32_t, len);
     cairo_surface_t *surface;
 
     /* Cairo wants premultiplied alpha, meh :( */
-    for(i = 0; i < len; i++)
-    {
-        uint8_t a = (data[i] >> 24) & 0xff;
-        double alpha = a / 255.0;
-        uint8_t r = ((data[i] >> 16) & 0xff) * alpha;
-        uint8_t g = ((data[i] >>  8) & 0xff) * alpha;
-        uint8_t b = ((data[i] >>  0) & 0xff) * alpha;
-        buffer[i] = (a << 24) | (r << 16) | (g << 8) | b;
-    }
+    iconcache_premultiply(buffer, data, len);
 
     surface =
         cairo_image_surface_create_for_data((unsigned char *) buffer,
@@ -114,15 +106,11 @@ draw_surface_from_pixbuf(GdkPixbuf *buf)
                 uint8_t b = *row++;
                 *cairo++ = (r << 16) | (g << 8) | b;
             } else {
-                uint8_t r = *row++;
-                uint8_t g = *row++;
-                uint8_t b = *row++;
-                uint8_t a = *row++;
-                double alpha = a / 255.0;
-                r = r * alpha;
-                g = g * alpha;
-                b = b * alpha;
-                *cairo++ = (a << 24) | (r << 16) | (g << 8) | b;
+                uint32_t r = *row++;
+                uint32_t g = *row++;
+                uint32_t b = *row++;
+                uint32_t a = *row++;
+                *cairo++ = iconcache_premultiply_pixel((a << 24) | (r << 16) | (g << 8) | b);
             }
         }
         pixels += pix_stride;
@@ -25,12 +25,14 @@
 #include "objects/tag.h"
 #include "objects/selection_getter.h"
 #include "objects/drawin.h"
+#include "objects/drawable.h"
 #include "objects/selection_acquire.h"
 #include "objects/selection_watcher.h"
 #include "xwindow.h"
 #include "ewmh.h"
 #include "objects/client.h"
 #include "keygrabber.h"
+#include "mouse.h"
 #include "mousegrabber.h"
 #include "luaa.h"
 #include "systray.h"
@@ -48,6 +50,30 @@
 #include <xcb/xkb.h>
 #include <xcb/xfixes.h>
 
+/** Emit press or release on the objects matching an event.
+ * The matching objects have to be on top of the stack, followed by nargs
+ * arguments below them. Everything is popped.
+ * \param L The Lua VM state.
+ * \param name The signal to emit or NULL.
+ * \param item_matching The number of matching objects.
+ * \param nargs The number of arguments.
+ */
+static void
+event_emit_matching(lua_State *L, const char *name, int item_matching, int nargs)
+{
+    for(; item_matching > 0; item_matching--)
+    {
+        if(name)
+        {
+            for(int i = 0; i < nargs; i++)
+                lua_pushvalue(L, - nargs - item_matching);
+            luaA_object_emit_signal(L, - nargs - 1, name, nargs);
+        }
+        lua_pop(L, 1);
+    }
+    lua_pop(L, nargs);
+}
+
 #define DO_EVENT_HOOK_CALLBACK(type, xcbtype, xcbeventprefix, arraytype, match) \
     static void \
     event_##xcbtype##_callback(xcb_##xcbtype##_press_event_t *ev, \
@@ -68,36 +94,20 @@
                     luaA_object_push(L, *item); \
                 item_matching++; \
             } \
-        for(; item_matching > 0; item_matching--) \
+        switch(ev->response_type) \
         { \
-            switch(ev->response_type) \
-            { \
-              case xcbeventprefix##_PRESS: \
-                for(int i = 0; i < nargs; i++) \
-                    lua_pushvalue(L, - nargs - item_matching); \
-                luaA_object_emit_signal(L, - nargs - 1, "press", nargs); \
-                break; \
-              case xcbeventprefix##_RELEASE: \
-                for(int i = 0; i < nargs; i++) \
-                    lua_pushvalue(L, - nargs - item_matching); \
-                luaA_object_emit_signal(L, - nargs - 1, "release", nargs); \
-                break; \
-            } \
-            lua_pop(L, 1); \
+          case xcbeventprefix##_PRESS: \
+            event_emit_matching(L, "press", item_matching, nargs); \
+            break; \
+          case xcbeventprefix##_RELEASE: \
+            event_emit_matching(L, "release", item_matching, nargs); \
+            break; \
+          default: \
+            event_emit_matching(L, NULL, item_matching, nargs); \
+            break; \
         } \
-        lua_pop(L, nargs); \
     }
 
-static bool
-event_key_match(xcb_key_press_event_t *ev, keyb_t *k, void *data)
-{
-    assert(data);
-    xcb_keysym_t keysym = *(xcb_keysym_t *) data;
-    return (((k->keycode && ev->detail == k->keycode)
-             || (k->keysym && keysym == k->keysym))
-            && (k->modifiers == XCB_BUTTON_MASK_ANY || k->modifiers == ev->state));
-}
-
 static bool
 event_button_match(xcb_button_press_event_t *ev, button_t *b, void *data)
 {
@@ -106,7 +116,43 @@ event_button_match(xcb_button_press_event_t *ev, button_t *b, void *data)
 }
 
 DO_EVENT_HOOK_CALLBACK(button_t, button, XCB_BUTTON, button_array_t, event_button_match)
-DO_EVENT_HOOK_CALLBACK(keyb_t, key, XCB_KEY, key_array_t, event_key_match)
+
+/** Emit press or release on all keys that match a key event.
+ * \param ev The event.
+ * \param arr The keys to check.
+ * \param idx The lookup table for the keys.
+ * \param L The Lua VM state.
+ * \param oud The index of the object owning the keys, 0 for global keys.
+ * \param nargs The number of arguments to pass to the signal, below the keys.
+ * \param keysym The keysym of the event, ignoring modifiers.
+ */
+static void
+event_key_callback(xcb_key_press_event_t *ev, key_array_t *arr, key_index_t *idx,
+                   lua_State *L, int oud, int nargs, xcb_keysym_t keysym)
+{
+    int abs_oud = oud < 0 ? ((lua_gettop(L) + 1) + oud) : oud;
+    key_array_t *matches = key_index_match(idx, arr, ev->detail, keysym, ev->state);
+    int item_matching = matches->len;
+
+    foreach(item, *matches)
+        if(oud)
+            luaA_object_push_item(L, abs_oud, *item);
+        else
+            luaA_object_push(L, *item);
+
+    switch(ev->response_type)
+    {
+      case XCB_KEY_PRESS:
+        event_emit_matching(L, "press", item_matching, nargs);
+        break;
+      case XCB_KEY_RELEASE:
+        event_emit_matching(L, "release", item_matching, nargs);
+        break;
+      default:
+        event_emit_matching(L, NULL, item_matching, nargs);
+        break;
+    }
+}
 
 /** Handle an event with mouse grabber if needed
  * \param x The x coordinate.
@@ -144,26 +190,29 @@ event_handle_mousegrabber(int x, int y, uint16_t mask)
 static void
 event_emit_button(lua_State *L, xcb_button_press_event_t *ev)
 {
-    const char *name;
+    signal_id_t id;
     switch(XCB_EVENT_RESPONSE_TYPE(ev))
     {
     case XCB_BUTTON_PRESS:
-        name = "button::press";
+        id = SIGNAL_ID("button::press");
         break;
     case XCB_BUTTON_RELEASE:
-        name = "button::release";
+        id = SIGNAL_ID("button::release");
         break;
     default:
         fatal("Invalid event type");
     }
 
+    if(!signal_has_listeners(id))
+        return;
+
     /* Push the event's info */
     lua_pushinteger(L, ev->event_x);
     lua_pushinteger(L, ev->event_y);
     lua_pushinteger(L, ev->detail);
     luaA_pushmodifiers(L, ev->state);
     /* And emit the signal */
-    luaA_object_emit_signal(L, -5, name, 4);
+    luaA_object_emit_signal_id(L, -5, id, 4);
 }
 
 /** The button press event handler.
@@ -389,6 +438,7 @@ event_handle_configurerequest(xcb_configure_request_event_t *ev)
         }
 
         c->got_configure_request = true;
+        client_need_refresh(c);
 
         /* Request the changes to be applied */
         luaA_object_push(L, c);
@@ -509,7 +559,7 @@ event_drawable_under_mouse(lua_State *L, int ud)
     {
         /* Emit leave on previous drawable */
         luaA_object_push(L, globalconf.drawable_under_mouse);
-        luaA_object_emit_signal(L, -1, "mouse::leave", 0);
+        luaA_object_emit_signal_id(L, -1, SIGNAL_ID("mouse::leave"), 0);
         lua_pop(L, 1);
 
         /* Unref the previous drawable */
@@ -522,7 +572,7 @@ event_drawable_under_mouse(lua_State *L, int ud)
         globalconf.drawable_under_mouse = d;
 
         /* Emit enter */
-        luaA_object_emit_signal(L, ud, "mouse::enter", 0);
+        luaA_object_emit_signal_id(L, ud, SIGNAL_ID("mouse::enter"), 0);
     }
 }
 
@@ -541,12 +591,19 @@ event_handle_motionnotify(xcb_motion_notify_event_t *ev)
     if(event_handle_mousegrabber(ev->root_x, ev->root_y, ev->state))
         return;
 
+    /* Most of the time nothing listens to mouse::move, so do not even push
+     * the arguments */
+    bool emit_move = signal_has_listeners(SIGNAL_ID("mouse::move"));
+
     if((c = client_getbyframewin(ev->event)))
     {
         luaA_object_push(L, c);
-        lua_pushinteger(L, ev->event_x);
-        lua_pushinteger(L, ev->event_y);
-        luaA_object_emit_signal(L, -3, "mouse::move", 2);
+        if(emit_move)
+        {
+            lua_pushinteger(L, ev->event_x);
+            lua_pushinteger(L, ev->event_y);
+            luaA_object_emit_signal_id(L, -3, SIGNAL_ID("mouse::move"), 2);
+        }
 
         /* now check if a titlebar was "hit" */
         int x = ev->event_x, y = ev->event_y;
@@ -555,9 +612,12 @@ event_handle_motionnotify(xcb_motion_notify_event_t *ev)
         {
             luaA_object_push_item(L, -1, d);
             event_drawable_under_mouse(L, -1);
-            lua_pushinteger(L, x);
-            lua_pushinteger(L, y);
-            luaA_object_emit_signal(L, -3, "mouse::move", 2);
+            if(emit_move)
+            {
+                lua_pushinteger(L, x);
+                lua_pushinteger(L, y);
+                luaA_object_emit_signal_id(L, -3, SIGNAL_ID("mouse::move"), 2);
+            }
             lua_pop(L, 1);
         }
         lua_pop(L, 1);
@@ -568,9 +628,12 @@ event_handle_motionnotify(xcb_motion_notify_event_t *ev)
         luaA_object_push(L, w);
         luaA_object_push_item(L, -1, w->drawable);
         event_drawable_under_mouse(L, -1);
-        lua_pushinteger(L, ev->event_x);
-        lua_pushinteger(L, ev->event_y);
-        luaA_object_emit_signal(L, -3, "mouse::move", 2);
+        if(emit_move)
+        {
+            lua_pushinteger(L, ev->event_x);
+            lua_pushinteger(L, ev->event_y);
+            luaA_object_emit_signal_id(L, -3, SIGNAL_ID("mouse::move"), 2);
+        }
         lua_pop(L, 2);
     }
 }
@@ -610,7 +673,7 @@ event_handle_leavenotify(xcb_leave_notify_event_t *ev)
          */
         if(ev->detail != XCB_NOTIFY_DETAIL_INFERIOR) {
             luaA_object_push(L, c);
-            luaA_object_emit_signal(L, -1, "mouse::leave", 0);
+            luaA_object_emit_signal_id(L, -1, SIGNAL_ID("mouse::leave"), 0);
             lua_pop(L, 1);
         }
     } else if(ev->detail != XCB_NOTIFY_DETAIL_INFERIOR) {
@@ -669,7 +732,7 @@ event_handle_enternotify(xcb_enter_notify_event_t *ev)
          * other details mean that the client itself was really left.
          */
         if(ev->detail != XCB_NOTIFY_DETAIL_INFERIOR) {
-            luaA_object_emit_signal(L, -1, "mouse::enter", 0);
+            luaA_object_emit_signal_id(L, -1, SIGNAL_ID("mouse::enter"), 0);
         }
 
         drawable_t *d = client_get_drawable(c, ev->event_x, ev->event_y);
@@ -739,11 +802,9 @@ event_handle_expose(xcb_expose_event_t *ev)
     client_t *client;
 
     if((drawin = drawin_getbywin(ev->window)))
-        drawin_refresh_pixmap_partial(drawin,
-                                      ev->x, ev->y,
-                                      ev->width, ev->height);
+        window_expose((window_t *) drawin, ev->x, ev->y, ev->width, ev->height);
     if ((client = client_getbyframewin(ev->window)))
-        client_refresh_partial(client, ev->x, ev->y, ev->width, ev->height);
+        window_expose((window_t *) client, ev->x, ev->y, ev->width, ev->height);
 }
 
 /** The key press event handler.
@@ -776,10 +837,10 @@ event_handle_key(xcb_key_press_event_t *ev)
         if((c = client_getbywin(ev->event)) || (c = client_getbynofocuswin(ev->event)))
         {
             luaA_object_push(L, c);
-            event_key_callback(ev, &c->keys, L, -1, 1, &keysym);
+            event_key_callback(ev, &c->keys, &c->keys_index, L, -1, 1, keysym);
         }
         else
-            event_key_callback(ev, &globalconf.keys, L, 0, 0, &keysym);
+            event_key_callback(ev, &globalconf.keys, &globalconf.keys_index, L, 0, 0, keysym);
     }
 }
 
@@ -1093,6 +1154,9 @@ void event_handle(xcb_generic_event_t *event)
 {
     uint8_t response_type = XCB_EVENT_RESPONSE_TYPE(event);
 
+    /* Ignored enter and leave events still tell us where the pointer is */
+    mouse_track_event(event);
+
     if (should_ignore(event))
         return;
 
@@ -1138,9 +1202,128 @@ void event_handle(xcb_generic_event_t *event)
     EXTENSION_EVENT(shape, XCB_SHAPE_NOTIFY, event_handle_shape_notify);
     EXTENSION_EVENT(xkb, 0, event_handle_xkb_notify);
     EXTENSION_EVENT(xfixes, XCB_XFIXES_SELECTION_NOTIFY, event_handle_xfixes_selection_notify);
+    EXTENSION_EVENT(shm, XCB_SHM_COMPLETION, drawable_shm_completion);
 #undef EXTENSION_EVENT
 }
 
+/** Counters for event_coalesce() */
+static struct
+{
+    /** Number of batches of events and events in them */
+    unsigned long drains, events;
+    /** Number of ConfigureRequests that were merged into a later one */
+    unsigned long configure_requests;
+} coalesce_stats;
+
+/** Merge a ConfigureRequest into a later one for the same window. Values from
+ * the later request win, values only in the earlier one are kept.
+ * \param from The earlier request.
+ * \param to The later request.
+ */
+static void
+event_merge_configurerequest(const xcb_configure_request_event_t *from,
+                             xcb_configure_request_event_t *to)
+{
+    uint16_t missing = from->value_mask & ~to->value_mask;
+
+    if(missing & XCB_CONFIG_WINDOW_X)
+        to->x = from->x;
+    if(missing & XCB_CONFIG_WINDOW_Y)
+        to->y = from->y;
+    if(missing & XCB_CONFIG_WINDOW_WIDTH)
+        to->width = from->width;
+    if(missing & XCB_CONFIG_WINDOW_HEIGHT)
+        to->height = from->height;
+    if(missing & XCB_CONFIG_WINDOW_BORDER_WIDTH)
+        to->border_width = from->border_width;
+    if(missing & XCB_CONFIG_WINDOW_SIBLING)
+        to->sibling = from->sibling;
+    if(missing & XCB_CONFIG_WINDOW_STACK_MODE)
+        to->stack_mode = from->stack_mode;
+    to->value_mask |= from->value_mask;
+}
+
+/** Merge redundant events from one batch read from the X server.
+ *
+ * ConfigureRequests for the same window are merged into the last of them, so
+ * that Lua only sees one request::geometry. Merging stops at any event that
+ * might depend on the earlier requests having been handled, for example a
+ * MapRequest. Expose events do not need this, they only add to the window's
+ * exposed region, see window_expose(). Merged events are freed and replaced
+ * with NULL.
+ * \param events The events, in the order they were received.
+ * \param len The number of events.
+ */
+void
+event_coalesce(xcb_generic_event_t **events, int len)
+{
+    /* Index of the latest ConfigureRequest per window */
+    struct { xcb_window_t window; int configure; } seen[64];
+    int nseen = 0;
+
+    coalesce_stats.drains++;
+    coalesce_stats.events += len;
+
+    /* Go backwards so that every event is merged into the latest one */
+    for(int i = len - 1; i >= 0; i--)
+    {
+        uint8_t type = XCB_EVENT_RESPONSE_TYPE(events[i]);
+        xcb_window_t window;
+        int j;
+
+        if(type != XCB_CONFIGURE_REQUEST)
+        {
+            /* Events that do not change anything for these windows */
+            if(type != XCB_PROPERTY_NOTIFY && type != XCB_MOTION_NOTIFY
+               && type != XCB_EXPOSE)
+                for(j = 0; j < nseen; j++)
+                    seen[j].configure = -1;
+            continue;
+        }
+        window = ((xcb_configure_request_event_t *) events[i])->window;
+
+        for(j = 0; j < nseen; j++)
+            if(seen[j].window == window)
+                break;
+        if(j == nseen)
+        {
+            /* Too many windows involved, just do not merge the rest */
+            if(nseen == countof(seen))
+                continue;
+            seen[nseen].window = window;
+            seen[nseen].configure = -1;
+            nseen++;
+        }
+
+        if(seen[j].configure >= 0)
+        {
+            event_merge_configurerequest((void *) events[i],
+                                         (void *) events[seen[j].configure]);
+            p_delete(&events[i]);
+            coalesce_stats.configure_requests++;
+        }
+        else
+            seen[j].configure = i;
+    }
+}
+
+/** Push statistics about event_coalesce() onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+event_push_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, coalesce_stats.drains);
+    lua_setfield(L, -2, "drains");
+    lua_pushinteger(L, coalesce_stats.events);
+    lua_setfield(L, -2, "events");
+    lua_pushinteger(L, coalesce_stats.configure_requests);
+    lua_setfield(L, -2, "configure_requests");
+    return 1;
+}
+
 void event_init(void)
 {
     const xcb_query_extension_reply_t *reply;
@@ -1160,6 +1343,31 @@ void event_init(void)
     reply = xcb_get_extension_data(globalconf.connection, &xcb_xfixes_id);
     if (reply && reply->present)
         globalconf.event_base_xfixes = reply->first_event;
+
+    reply = xcb_get_extension_data(globalconf.connection, &xcb_shm_id);
+    if (reply && reply->present)
+        globalconf.event_base_shm = reply->first_event;
+}
+
+/** Push statistics about awesome_refresh() onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+event_push_refresh_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 5);
+    lua_pushinteger(L, globalconf.dirty.refreshes);
+    lua_setfield(L, -2, "refreshes");
+    lua_pushinteger(L, globalconf.dirty.visited_clients);
+    lua_setfield(L, -2, "clients");
+    lua_pushinteger(L, globalconf.dirty.visited_drawins);
+    lua_setfield(L, -2, "drawins");
+    lua_pushinteger(L, globalconf.dirty.last_clients);
+    lua_setfield(L, -2, "last_clients");
+    lua_pushinteger(L, globalconf.dirty.last_drawins);
+    lua_setfield(L, -2, "last_drawins");
+    return 1;
 }
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -24,6 +24,7 @@
 
 #include "banning.h"
 #include "globalconf.h"
+#include "profile.h"
 #include "stack.h"
 
 #include <xcb/xcb.h>
@@ -34,25 +35,43 @@ void luaA_emit_refresh(void);
 /* objects/drawin.c */
 void drawin_refresh(void);
 
+/* property.c */
+void property_refresh(void);
+
 /* objects/client.c */
 void client_refresh(void);
 void client_focus_refresh(void);
 void client_destroy_later(void);
 
+int event_push_refresh_stats(lua_State *);
+
 static inline int
 awesome_refresh(void)
 {
+    int64_t t = profile_now();
+
+    globalconf.dirty.refreshes++;
+    property_refresh();
+    t = profile_record(PROFILE_PROPERTY, t);
     luaA_emit_refresh();
+    t = profile_record(PROFILE_REFRESH_SIGNAL, t);
     drawin_refresh();
+    t = profile_record(PROFILE_DRAWINS, t);
     client_refresh();
+    t = profile_record(PROFILE_CLIENTS, t);
     banning_refresh();
+    t = profile_record(PROFILE_BANNING, t);
     stack_refresh();
+    t = profile_record(PROFILE_STACK, t);
     client_destroy_later();
+    profile_record(PROFILE_DESTROY, t);
     return xcb_flush(globalconf.connection);
 }
 
 void event_init(void);
 void event_handle(xcb_generic_event_t *);
+void event_coalesce(xcb_generic_event_t **, int);
+int event_push_stats(lua_State *);
 void event_drawable_under_mouse(lua_State *, int);
 
 #endif
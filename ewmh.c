@@ -23,6 +23,7 @@
 #include "objects/client.h"
 #include "objects/tag.h"
 #include "common/atoms.h"
+#include "common/iconcache.h"
 #include "xwindow.h"
 
 #include <sys/types.h>
@@ -578,27 +579,37 @@ ewmh_update_window_type(xcb_window_t window, uint32_t type)
                         window, _NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 32, 1, &type);
 }
 
+/** Send the GetProperty requests needed by ewmh_client_check_hints().
+ * \param w The client window.
+ * \return The cookies to pass to ewmh_client_check_hints().
+ */
+ewmh_hints_cookies_t
+ewmh_client_get_hints_unchecked(xcb_window_t w)
+{
+    ewmh_hints_cookies_t cookies;
+
+    cookies.desktop = xcb_get_property_unchecked(globalconf.connection, false, w,
+                                                 _NET_WM_DESKTOP, XCB_GET_PROPERTY_TYPE_ANY, 0, 1);
+
+    cookies.state = xcb_get_property_unchecked(globalconf.connection, false, w,
+                                               _NET_WM_STATE, XCB_ATOM_ATOM, 0, UINT32_MAX);
+
+    cookies.window_type = xcb_get_property_unchecked(globalconf.connection, false, w,
+                                                     _NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 0, UINT32_MAX);
+
+    return cookies;
+}
+
 void
-ewmh_client_check_hints(client_t *c)
+ewmh_client_check_hints(client_t *c, ewmh_hints_cookies_t cookies)
 {
     xcb_atom_t *state;
     void *data = NULL;
-    xcb_get_property_cookie_t c0, c1, c2;
     xcb_get_property_reply_t *reply;
     bool is_h_max = false;
     bool is_v_max = false;
 
-    /* Send the GetProperty requests which will be processed later */
-    c0 = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                    _NET_WM_DESKTOP, XCB_GET_PROPERTY_TYPE_ANY, 0, 1);
-
-    c1 = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                    _NET_WM_STATE, XCB_ATOM_ATOM, 0, UINT32_MAX);
-
-    c2 = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                    _NET_WM_WINDOW_TYPE, XCB_ATOM_ATOM, 0, UINT32_MAX);
-
-    reply = xcb_get_property_reply(globalconf.connection, c0, NULL);
+    reply = xcb_get_property_reply(globalconf.connection, cookies.desktop, NULL);
     if(reply && reply->value_len && (data = xcb_get_property_value(reply)))
     {
         ewmh_process_desktop(c, *(uint32_t *) data);
@@ -606,7 +617,7 @@ ewmh_client_check_hints(client_t *c)
 
     p_delete(&reply);
 
-    reply = xcb_get_property_reply(globalconf.connection, c1, NULL);
+    reply = xcb_get_property_reply(globalconf.connection, cookies.state, NULL);
     if(reply && (data = xcb_get_property_value(reply)))
     {
         state = (xcb_atom_t *) data;
@@ -643,7 +654,7 @@ ewmh_client_check_hints(client_t *c)
 
     p_delete(&reply);
 
-    reply = xcb_get_property_reply(globalconf.connection, c2, NULL);
+    reply = xcb_get_property_reply(globalconf.connection, cookies.window_type, NULL);
     if(reply && (data = xcb_get_property_value(reply)))
     {
         c->has_NET_WM_WINDOW_TYPE = true;
@@ -669,18 +680,37 @@ ewmh_client_check_hints(client_t *c)
     p_delete(&reply);
 }
 
+/** Send request to get the WM strut of a client.
+ * \param w The client window.
+ * \return The cookie to pass to ewmh_process_client_strut_reply().
+ */
+xcb_get_property_cookie_t
+ewmh_client_strut_get_unchecked(xcb_window_t w)
+{
+    return xcb_get_property_unchecked(globalconf.connection, false, w,
+                                      _NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 0, 12);
+}
+
 /** Process the WM strut of a client.
  * \param c The client.
  */
 void
 ewmh_process_client_strut(client_t *c)
+{
+    ewmh_process_client_strut_reply(c, ewmh_client_strut_get_unchecked(c->window));
+}
+
+/** Process the WM strut of a client from a reply.
+ * \param c The client.
+ * \param cookie The cookie from ewmh_client_strut_get_unchecked().
+ */
+void
+ewmh_process_client_strut_reply(client_t *c, xcb_get_property_cookie_t cookie)
 {
     void *data;
     xcb_get_property_reply_t *strut_r;
 
-    xcb_get_property_cookie_t strut_q = xcb_get_property_unchecked(globalconf.connection, false, c->window,
-                                                                   _NET_WM_STRUT_PARTIAL, XCB_ATOM_CARDINAL, 0, 12);
-    strut_r = xcb_get_property_reply(globalconf.connection, strut_q, NULL);
+    strut_r = xcb_get_property_reply(globalconf.connection, cookie, NULL);
 
     if(strut_r
        && strut_r->value_len
@@ -755,7 +785,7 @@ ewmh_window_icon_from_reply_next(uint32_t **data, uint32_t *data_end)
 
     icon_data = *data + 2;
     *data += 2 + data_len;
-    return draw_surface_from_data(width, height, icon_data);
+    return iconcache_get(width, height, icon_data);
 }
 
 static cairo_surface_array_t
@@ -781,6 +811,25 @@ ewmh_window_icon_from_reply(xcb_get_property_reply_t *r)
     return result;
 }
 
+/** Push statistics about the icon cache onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on the stack.
+ */
+int
+ewmh_icon_push_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, iconcache_stats.lookups);
+    lua_setfield(L, -2, "lookups");
+    lua_pushinteger(L, iconcache_stats.hits);
+    lua_setfield(L, -2, "hits");
+    lua_pushinteger(L, iconcache_stats.entries);
+    lua_setfield(L, -2, "entries");
+    lua_pushinteger(L, iconcache_stats.bytes);
+    lua_setfield(L, -2, "bytes");
+    return 1;
+}
+
 /** Get NET_WM_ICON.
  * \param cookie The cookie.
  * \return An array of icons.
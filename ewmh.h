@@ -30,6 +30,12 @@
 typedef struct client_t client_t;
 typedef struct cairo_surface_array_t cairo_surface_array_t;
 
+/** Pending requests for the EWMH hints of a client */
+typedef struct
+{
+    xcb_get_property_cookie_t desktop, state, window_type;
+} ewmh_hints_cookies_t;
+
 void ewmh_init(void);
 void ewmh_init_lua(void);
 void ewmh_update_net_numbers_of_desktop(void);
@@ -37,13 +43,17 @@ int ewmh_update_net_current_desktop(lua_State *);
 void ewmh_update_net_desktop_names(void);
 int ewmh_process_client_message(xcb_client_message_event_t *);
 void ewmh_update_net_client_list_stacking(void);
-void ewmh_client_check_hints(client_t *);
+ewmh_hints_cookies_t ewmh_client_get_hints_unchecked(xcb_window_t);
+void ewmh_client_check_hints(client_t *, ewmh_hints_cookies_t);
 void ewmh_client_update_desktop(client_t *);
+xcb_get_property_cookie_t ewmh_client_strut_get_unchecked(xcb_window_t);
 void ewmh_process_client_strut(client_t *);
+void ewmh_process_client_strut_reply(client_t *, xcb_get_property_cookie_t);
 void ewmh_update_strut(xcb_window_t, strut_t *);
 void ewmh_update_window_type(xcb_window_t window, uint32_t type);
 xcb_get_property_cookie_t ewmh_window_icon_get_unchecked(xcb_window_t);
 cairo_surface_array_t ewmh_window_icon_get_reply(xcb_get_property_cookie_t);
+int ewmh_icon_push_stats(lua_State *);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
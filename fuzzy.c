@@ -0,0 +1,421 @@
+/*
+ * fuzzy.c - ranked fuzzy search
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/** Search long lists of names as they are typed.
+ *
+ * An index is built once from a list of names, for example the applications
+ * of the menubar or the executables in `$PATH`. Searching it only looks at the
+ * names that contain the characters of the query, so it stays fast for tens
+ * of thousands of names.
+ *
+ * Names that start with the query are ranked first, then names that contain
+ * it and then names that contain its characters in the same order, like
+ * "ffx" in "firefox". Within each group, names with a higher weight (for
+ * example how often they were used) come first and then names in the order
+ * they were added in. The case of ASCII letters is ignored.
+ *
+ * @usage
+ * local index = fuzzy.new()
+ * for _, entry in ipairs(entries) do
+ *     index:add(entry.name, entry.cmdline, entry)
+ * end
+ * index:set_weight("Firefox", 12)
+ * local best = index:search("fire", 10)
+ *
+ * @author awesome developers
+ * @copyright 2026 awesome developers
+ * @module fuzzy
+ */
+
+#include "fuzzy.h"
+#include "luaa.h"
+#include "common/fuzzyindex.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#define FUZZY_INDEX_METATABLE "awesome.fuzzy.index"
+
+/** A directory from `$PATH` and the executables in it */
+typedef struct
+{
+    char *path;
+    /** The modification time when the directory was read */
+    struct timespec mtime;
+    string_array_t names;
+} fuzzy_directory_t;
+
+static void
+fuzzy_directory_wipe(fuzzy_directory_t *dir)
+{
+    p_delete(&dir->path);
+    string_array_wipe(&dir->names);
+}
+
+DO_ARRAY(fuzzy_directory_t, fuzzy_directory, fuzzy_directory_wipe)
+
+typedef struct
+{
+    fuzzyindex_t index;
+    /** Whether this index contains the executables from `$PATH` */
+    bool executables;
+    /** The value of `$PATH` that directories were taken from */
+    char *path;
+    fuzzy_directory_array_t directories;
+} fuzzy_index_t;
+
+static struct
+{
+    /** Number of searches */
+    unsigned long searches;
+    /** Number of results returned by them */
+    unsigned long results;
+    /** Number of directories that were read for executables indices */
+    unsigned long rescans;
+} fuzzy_stats;
+
+static fuzzy_index_t *
+luaA_checkfuzzyindex(lua_State *L, int idx)
+{
+    return luaL_checkudata(L, idx, FUZZY_INDEX_METATABLE);
+}
+
+/** Read the executables in a directory.
+ * \param dir The directory.
+ */
+static void
+fuzzy_directory_read(fuzzy_directory_t *dir)
+{
+    DIR *d = opendir(dir->path);
+    struct dirent *ent;
+
+    string_array_wipe(&dir->names);
+    string_array_init(&dir->names);
+    fuzzy_stats.rescans++;
+    if(!d)
+        return;
+
+    while((ent = readdir(d)))
+    {
+        struct stat st;
+
+        if(A_STREQ(ent->d_name, ".") || A_STREQ(ent->d_name, ".."))
+            continue;
+        /* Like compgen -A command, this follows symlinks */
+        if(fstatat(dirfd(d), ent->d_name, &st, 0) == 0
+           && S_ISREG(st.st_mode) && (st.st_mode & (S_IXUSR | S_IXGRP | S_IXOTH)))
+            string_array_append(&dir->names, a_strdup(ent->d_name));
+    }
+    closedir(d);
+}
+
+static int
+fuzzy_strcmp(const void *a, const void *b)
+{
+    return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+/** Bring an executables index up to date with `$PATH`. Only directories
+ * whose modification time changed since they were last read are read again.
+ * \param fi The index.
+ */
+static void
+fuzzy_executables_refresh(fuzzy_index_t *fi)
+{
+    const char *path = NONULL(getenv("PATH"));
+    bool changed = false;
+
+    if(!fi->path || !A_STREQ(fi->path, path))
+    {
+        const char *start = path;
+
+        fuzzy_directory_array_wipe(&fi->directories);
+        fuzzy_directory_array_init(&fi->directories);
+        p_delete(&fi->path);
+        fi->path = p_dup(path, a_strlen(path) + 1);
+        do
+        {
+            const char *end = strchr(start, ':');
+            if(!end)
+                end = start + strlen(start);
+            if(end > start)
+            {
+                fuzzy_directory_t dir = { .path = p_dup(start, end - start + 1) };
+                dir.path[end - start] = '\0';
+                fuzzy_directory_array_append(&fi->directories, dir);
+            }
+            start = *end ? end + 1 : end;
+        } while(*start);
+        changed = true;
+    }
+
+    foreach(dir, fi->directories)
+    {
+        struct stat st;
+
+        if(stat(dir->path, &st) != 0)
+            p_clear(&st, 1);
+        if(st.st_mtim.tv_sec == dir->mtime.tv_sec
+           && st.st_mtim.tv_nsec == dir->mtime.tv_nsec)
+            continue;
+        dir->mtime = st.st_mtim;
+        fuzzy_directory_read(dir);
+        changed = true;
+    }
+
+    if(!changed)
+        return;
+
+    /* The same name can be in several directories, but one entry is enough,
+     * so sort all names and skip duplicates */
+    string_array_t names = { 0 };
+    foreach(dir, fi->directories)
+        string_array_splice(&names, names.len, 0, dir->names.tab, dir->names.len);
+    qsort(names.tab, names.len, sizeof(char *), fuzzy_strcmp);
+
+    fuzzyindex_wipe(&fi->index);
+    for(int i = 0; i < names.len; i++)
+        if(i == 0 || !A_STREQ(names.tab[i - 1], names.tab[i]))
+            fuzzyindex_add(&fi->index, names.tab[i], NULL, 0);
+
+    /* The strings still belong to the directories */
+    p_delete(&names.tab);
+}
+
+/** Add a name to an index.
+ *
+ * @tparam string name The name.
+ * @tparam[opt] string cmdline A second string that is searched as well, for
+ *   example the command line of an application.
+ * @param[opt=name] value What `search` returns for this name.
+ * @method add
+ */
+static int
+luaA_fuzzy_index_add(lua_State *L)
+{
+    fuzzy_index_t *fi = luaA_checkfuzzyindex(L, 1);
+    const char *name = luaL_checkstring(L, 2);
+    const char *cmdline = luaL_optstring(L, 3, NULL);
+
+    if(fi->executables)
+        return luaL_error(L, "cannot add names to an index of executables");
+
+    int pos = fuzzyindex_add(&fi->index, name, cmdline, 0);
+    luaA_getuservalue(L, 1);
+    lua_pushvalue(L, lua_isnoneornil(L, 4) ? 2 : 4);
+    lua_rawseti(L, -2, pos + 1);
+    return 0;
+}
+
+/** Set the weight of a name. Names with a higher weight are ranked first
+ * among names that match equally well. All weights start at 0.
+ *
+ * @tparam string name The name as it was added.
+ * @tparam number weight The new weight, for example how often the name was
+ *   used.
+ * @method set_weight
+ */
+static int
+luaA_fuzzy_index_set_weight(lua_State *L)
+{
+    fuzzy_index_t *fi = luaA_checkfuzzyindex(L, 1);
+    const char *name = luaL_checkstring(L, 2);
+    int weight = luaL_checkinteger(L, 3);
+
+    if(fi->executables)
+        return luaL_error(L, "cannot set weights in an index of executables");
+
+    fuzzyindex_set_weight(&fi->index, name, weight);
+    return 0;
+}
+
+/** Remove all names from an index.
+ *
+ * @method clear
+ */
+static int
+luaA_fuzzy_index_clear(lua_State *L)
+{
+    fuzzy_index_t *fi = luaA_checkfuzzyindex(L, 1);
+
+    fuzzyindex_wipe(&fi->index);
+    fuzzy_directory_array_wipe(&fi->directories);
+    fuzzy_directory_array_init(&fi->directories);
+    p_delete(&fi->path);
+    lua_newtable(L);
+    luaA_setuservalue(L, 1);
+    return 0;
+}
+
+/** Search an index.
+ *
+ * An empty query matches everything in the order it was added in.
+ *
+ * @tparam string query What to search for.
+ * @tparam[opt] integer max The maximum number of results, all of them by
+ *   default.
+ * @tparam[opt="subsequence"] string match The worst match to include:
+ *   "prefix" for names starting with the query, "substring" for names
+ *   containing it or "subsequence" for names containing its characters in
+ *   order.
+ * @treturn table The values of the matching names, best first.
+ * @method search
+ */
+static int
+luaA_fuzzy_index_search(lua_State *L)
+{
+    static const char *const matches[] = { "subsequence", "substring", "prefix", NULL };
+    fuzzy_index_t *fi = luaA_checkfuzzyindex(L, 1);
+    const char *query = luaL_checkstring(L, 2);
+    int max = luaL_optinteger(L, 3, 0);
+    fuzzyindex_match_t match = FUZZYINDEX_SUBSEQUENCE + luaL_checkoption(L, 4, "subsequence", matches);
+    int_array_t results = { 0 };
+
+    if(fi->executables)
+        fuzzy_executables_refresh(fi);
+
+    fuzzyindex_search(&fi->index, query, MAX(max, 0), match, &results);
+    fuzzy_stats.searches++;
+    fuzzy_stats.results += results.len;
+
+    lua_createtable(L, results.len, 0);
+    luaA_getuservalue(L, 1);
+    for(int i = 0; i < results.len; i++)
+    {
+        if(fi->executables)
+            lua_pushstring(L, fi->index.entries.tab[results.tab[i]].key);
+        else
+            lua_rawgeti(L, -1, results.tab[i] + 1);
+        lua_rawseti(L, -3, i + 1);
+    }
+    lua_pop(L, 1);
+
+    int_array_wipe(&results);
+    return 1;
+}
+
+static int
+luaA_fuzzy_index_len(lua_State *L)
+{
+    fuzzy_index_t *fi = luaA_checkfuzzyindex(L, 1);
+
+    if(fi->executables)
+        fuzzy_executables_refresh(fi);
+    lua_pushinteger(L, fi->index.entries.len);
+    return 1;
+}
+
+static int
+luaA_fuzzy_index_gc(lua_State *L)
+{
+    fuzzy_index_t *fi = luaA_checkfuzzyindex(L, 1);
+
+    fuzzyindex_wipe(&fi->index);
+    fuzzy_directory_array_wipe(&fi->directories);
+    p_delete(&fi->path);
+    return 0;
+}
+
+static const struct luaL_Reg fuzzy_index_meta[] =
+{
+    { "add", luaA_fuzzy_index_add },
+    { "set_weight", luaA_fuzzy_index_set_weight },
+    { "clear", luaA_fuzzy_index_clear },
+    { "search", luaA_fuzzy_index_search },
+    { "__len", luaA_fuzzy_index_len },
+    { "__gc", luaA_fuzzy_index_gc },
+    { NULL, NULL }
+};
+
+static void
+luaA_fuzzy_push_index(lua_State *L, bool executables)
+{
+    fuzzy_index_t *fi = lua_newuserdata(L, sizeof(*fi));
+
+    p_clear(fi, 1);
+    fi->executables = executables;
+    lua_newtable(L);
+    luaA_setuservalue(L, -2);
+    if(luaL_newmetatable(L, FUZZY_INDEX_METATABLE))
+    {
+        luaA_setfuncs(L, fuzzy_index_meta);
+        lua_pushvalue(L, -1);
+        lua_setfield(L, -2, "__index");
+    }
+    lua_setmetatable(L, -2);
+}
+
+/** Create a new empty index.
+ *
+ * @treturn fuzzy_index The new index.
+ * @function new
+ */
+static int
+luaA_fuzzy_new(lua_State *L)
+{
+    luaA_fuzzy_push_index(L, false);
+    return 1;
+}
+
+/** Create an index of the executables in `$PATH`.
+ *
+ * Each search checks whether `$PATH` or any of its directories changed and
+ * only reads the changed directories again. The values of the index are the
+ * names of the executables.
+ *
+ * @treturn fuzzy_index The new index.
+ * @function executables
+ */
+static int
+luaA_fuzzy_executables(lua_State *L)
+{
+    luaA_fuzzy_push_index(L, true);
+    return 1;
+}
+
+/** Push statistics about searches onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on the stack.
+ */
+int
+fuzzy_push_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, fuzzy_stats.searches);
+    lua_setfield(L, -2, "searches");
+    lua_pushinteger(L, fuzzy_stats.results);
+    lua_setfield(L, -2, "results");
+    lua_pushinteger(L, fuzzy_stats.rescans);
+    lua_setfield(L, -2, "rescans");
+    return 1;
+}
+
+const struct luaL_Reg awesome_fuzzy_lib[] =
+{
+    { "new", luaA_fuzzy_new },
+    { "executables", luaA_fuzzy_executables },
+    { "__index", luaA_default_index },
+    { "__newindex", luaA_default_newindex },
+    { NULL, NULL }
+};
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
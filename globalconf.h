@@ -41,6 +41,8 @@
 #include "objects/key.h"
 #include "common/xembed.h"
 #include "common/buffer.h"
+#include "common/windowindex.h"
+#include "common/spatialindex.h"
 
 #define ROOT_WINDOW_EVENT_MASK \
     (const uint32_t []) { \
@@ -50,6 +52,8 @@
       | XCB_EVENT_MASK_STRUCTURE_NOTIFY \
       | XCB_EVENT_MASK_BUTTON_PRESS \
       | XCB_EVENT_MASK_BUTTON_RELEASE \
+      | XCB_EVENT_MASK_POINTER_MOTION \
+      | XCB_EVENT_MASK_POINTER_MOTION_HINT \
       | XCB_EVENT_MASK_FOCUS_CHANGE \
       | XCB_EVENT_MASK_PROPERTY_CHANGE \
     }
@@ -75,6 +79,8 @@ ARRAY_TYPE(drawin_t *, drawin)
 ARRAY_TYPE(xproperty_t, xproperty)
 DO_ARRAY(sequence_pair_t, sequence_pair, DO_NOTHING)
 DO_ARRAY(xcb_window_t, window, DO_NOTHING)
+/** A set of tags, as a bitmap indexed by tag_t.id */
+DO_ARRAY(uint32_t, tagset, DO_NOTHING)
 
 /** Main configuration structure */
 typedef struct
@@ -99,6 +105,8 @@ typedef struct
     screen_t *primary_screen;
     /** Root window key bindings */
     key_array_t keys;
+    /** Lookup table for keys */
+    key_index_t keys_index;
     /** Root window mouse bindings */
     button_array_t buttons;
     /** Atom for WM_Sn */
@@ -121,12 +129,19 @@ typedef struct
     bool have_xkb;
     /** Check for XFixes extension */
     bool have_xfixes;
+    /** Check for MIT-SHM extension (cleared if attaching a segment fails) */
+    bool have_shm;
     uint8_t event_base_shape;
     uint8_t event_base_xkb;
     uint8_t event_base_randr;
     uint8_t event_base_xfixes;
+    uint8_t event_base_shm;
     /** Clients list */
     client_array_t clients;
+    /** Index of the windows of clients and drawins, by window id */
+    windowindex_t windows;
+    /** Index of the frames of clients that are not banned, by position */
+    spatialindex_t client_areas;
     /** Embedded windows */
     xembed_window_array_t embedded;
     /** Stack client history */
@@ -157,6 +172,17 @@ typedef struct
     } focus;
     /** Drawins */
     drawin_array_t drawins;
+    /** Objects with changes that awesome_refresh() has to apply */
+    struct
+    {
+        client_array_t clients;
+        drawin_array_t drawins;
+        /** Number of refreshes done */
+        unsigned long refreshes;
+        /** Number of objects visited by all refreshes and by the last one */
+        unsigned long visited_clients, visited_drawins;
+        int last_clients, last_drawins;
+    } dirty;
     /** The startup notification display struct */
     SnDisplay *sndisplay;
     /** Latest timestamp we got from the X server */
@@ -192,6 +218,10 @@ typedef struct
     bool need_lazy_banning;
     /** Tag list */
     tag_array_t tags;
+    /** Tags that are both activated and selected */
+    tagset_array_t selected_tags;
+    /** Tag ids that are currently in use */
+    tagset_array_t tag_ids;
     /** List of registered xproperties */
     xproperty_array_t xproperties;
     /* xkb context */
@@ -151,6 +151,24 @@ function focus.history.previous()
     end
 end
 
+-- Get the nearest visible client of a screen in a direction. The C core keeps
+-- an index of the client positions for this. Only when ties have to be broken
+-- by stacking order, all clients are compared here.
+local function get_in_direction(dir, s, source, stacked)
+    if not stacked then
+        return capi.client.in_direction(source, dir, s)
+    end
+
+    local cltbl = client.visible(s, true)
+    local geomtbl = {}
+    for i,cl in ipairs(cltbl) do
+        geomtbl[i] = cl:geometry()
+    end
+    local geometry = type(source) == "table" and source or source:geometry()
+    local target = grect.get_in_direction(dir, geomtbl, geometry)
+    return target and cltbl[target]
+end
+
 --- Focus a client by the given direction.
 --
 -- @tparam string dir The direction, can be either
@@ -161,18 +179,12 @@ end
 function focus.bydirection(dir, c, stacked)
     local sel = c or capi.client.focus
     if sel then
-        local cltbl = client.visible(sel.screen, stacked)
-        local geomtbl = {}
-        for i,cl in ipairs(cltbl) do
-            geomtbl[i] = cl:geometry()
-        end
-
-        local target = grect.get_in_direction(dir, geomtbl, sel:geometry())
+        local target = get_in_direction(dir, sel.screen, sel, stacked)
 
         -- If we found a client to focus, then do it.
         if target then
-            cltbl[target]:emit_signal("request::activate",
-                                      "client.focus.bydirection", {raise=false})
+            target:emit_signal("request::activate",
+                               "client.focus.bydirection", {raise=false})
         end
     end
 end
@@ -194,17 +206,13 @@ function focus.global_bydirection(dir, c, stacked)
     if sel == capi.client.focus then
         screen.focus_bydirection(dir, scr)
         if scr ~= get_screen(screen.focused()) then
-            local cltbl = client.visible(screen.focused(), stacked)
-            local geomtbl = {}
-            for i,cl in ipairs(cltbl) do
-                geomtbl[i] = cl:geometry()
-            end
-            local target = grect.get_in_direction(dir, geomtbl, scr.geometry)
+            local target = get_in_direction(dir, screen.focused(),
+                                            scr.geometry, stacked)
 
             if target then
-                cltbl[target]:emit_signal("request::activate",
-                                          "client.focus.global_bydirection",
-                                          {raise=false})
+                target:emit_signal("request::activate",
+                                   "client.focus.global_bydirection",
+                                   {raise=false})
             end
         end
     end
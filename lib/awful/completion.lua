@@ -12,12 +12,16 @@
 local gfs = require("gears.filesystem")
 
 -- Grab environment we need
+local capi = {
+    fuzzy = fuzzy,
+}
 local io = io
 local os = os
 local table = table
 local math = math
 local print = print
 local pairs = pairs
+local ipairs = ipairs
 local string = string
 
 local gears_debug = require("gears.debug")
@@ -61,64 +65,111 @@ end
 
 completion.default_shell = nil
 
---- Use shell completion system to complete commands and filenames.
--- @tparam string command The command line.
--- @tparam number cur_pos The cursor position.
--- @tparam number ncomp The element number to complete.
--- @tparam[opt=based on SHELL] string shell The shell to use for completion.
---   Supports "bash" and "zsh".
--- @treturn string The new command.
--- @treturn number The new cursor position.
--- @treturn table The table with all matches.
-function completion.shell(command, cur_pos, ncomp, shell)
-    local wstart = 1
-    local wend = 1
-    local words = {}
-    local cword_index = 0
-    local cword_start = 0
-    local cword_end = 0
-    local i = 1
-    local comptype = "file"
+--- Get the shell to complete with.
+-- @tparam[opt] string shell The shell that was asked for.
+-- @treturn string "bash" or "zsh".
+local function get_shell(shell)
+    if shell then
+        return shell
+    end
+    if not completion.default_shell then
+        local env_shell = os.getenv('SHELL')
+        if not env_shell then
+            gears_debug.print_warning('SHELL not set in environment, falling back to bash.')
+            completion.default_shell = 'bash'
+        elseif env_shell:match('zsh$') then
+            completion.default_shell = 'zsh'
+        else
+            completion.default_shell = 'bash'
+        end
+    end
+    return completion.default_shell
+end
 
-    -- do nothing if we are on a letter, i.e. not at len + 1 or on a space
-    if cur_pos ~= #command + 1 and command:sub(cur_pos, cur_pos) ~= " " then
-        return command, cur_pos
-    elseif #command == 0 then
-        return command, cur_pos
+-- Index of the executables in $PATH, created on first use
+local executables = nil
+
+-- The aliases, builtins, functions and keywords of each shell, listed on first
+-- use
+local shell_commands = {}
+
+--- Get the command names a shell knows besides the executables in $PATH.
+-- The shell does not read the user's startup files for this, so these are
+-- mostly its builtins and keywords. They do not change, so the shell only runs
+-- once.
+-- @tparam string shell "bash" or "zsh".
+-- @treturn table The command names.
+local function get_shell_commands(shell)
+    if shell_commands[shell] then
+        return shell_commands[shell]
     end
 
-    while wend <= #command do
-        wend = command:find(" ", wstart)
-        if not wend then wend = #command + 1 end
-        table.insert(words, command:sub(wstart, wend - 1))
-        if cur_pos >= wstart and cur_pos <= wend + 1 then
-            cword_start = wstart
-            cword_end = wend
-            cword_index = i
+    local shell_cmd
+    if shell == 'zsh' then
+        shell_cmd = "/usr/bin/env zsh -c 'print -ln -- "..
+            "\"${(k)aliases[@]}\" \"${(k)builtins[@]}\" \"${(k)functions[@]}\" "..
+            "\"${(k)reswords[@]}\"'"
+    else
+        shell_cmd = "/usr/bin/env bash -c 'compgen -A alias -A builtin -A function -A keyword'"
+    end
+
+    local names = {}
+    local c, err = io.popen(shell_cmd)
+    if c then
+        while true do
+            local line = c:read("*line")
+            if not line then break end
+            table.insert(names, line)
         end
-        wstart = wend + 1
-        i = i + 1
+        c:close()
+    else
+        print(err)
     end
+    shell_commands[shell] = names
+    return names
+end
 
-    if cword_index == 1 then
-        comptype = "command"
+--- Complete a command name without running a shell. The executables in $PATH
+-- are looked up in an index and merged with the shell's own commands.
+-- @tparam string word The beginning of the command name.
+-- @tparam string shell "bash" or "zsh".
+-- @treturn table|nil The sorted matches, which may be empty, or nil if the
+--   shell has to complete the word itself.
+local function complete_command(word, shell)
+    -- Paths and home directories are left to the shell
+    if not capi.fuzzy or word:find("[/~]") then
+        return nil
     end
+    executables = executables or capi.fuzzy.executables()
 
-    local shell_cmd
-    if not shell then
-        if not completion.default_shell then
-            local env_shell = os.getenv('SHELL')
-            if not env_shell then
-                gears_debug.print_warning('SHELL not set in environment, falling back to bash.')
-                completion.default_shell = 'bash'
-            elseif env_shell:match('zsh$') then
-                completion.default_shell = 'zsh'
-            else
-                completion.default_shell = 'bash'
-            end
+    local output, seen = {}, {}
+    local function add(name)
+        -- The index ignores case, the shell does not
+        if not seen[name] and gstring.startswith(name, word) then
+            seen[name] = true
+            table.insert(output, bash_escape(name))
         end
-        shell = completion.default_shell
     end
+    for _, name in ipairs(executables:search(word, nil, "prefix")) do
+        add(name)
+    end
+    for _, name in ipairs(get_shell_commands(shell)) do
+        add(name)
+    end
+    table.sort(output)
+    return output
+end
+
+--- Run the shell to complete a word.
+-- @tparam string command The command line.
+-- @tparam number cur_pos The cursor position.
+-- @tparam table words The words of the command line.
+-- @tparam number cword_index The index of the word to complete.
+-- @tparam string comptype "command" or "file".
+-- @tparam string shell The shell to use for completion.
+-- @treturn table The sorted matches.
+local function shell_complete(command, cur_pos, words, cword_index, comptype, shell)
+    local shell_cmd
     if shell == 'zsh' then
         if comptype == "file" then
             -- NOTE: ${~:-"..."} turns on GLOB_SUBST, useful for expansion of
@@ -167,6 +218,59 @@ function completion.shell(command, cur_pos, ncomp, shell)
     else
         print(err)
     end
+    return output
+end
+
+--- Use shell completion system to complete commands and filenames.
+-- @tparam string command The command line.
+-- @tparam number cur_pos The cursor position.
+-- @tparam number ncomp The element number to complete.
+-- @tparam[opt=based on SHELL] string shell The shell to use for completion.
+--   Supports "bash" and "zsh".
+-- @treturn string The new command.
+-- @treturn number The new cursor position.
+-- @treturn table The table with all matches.
+function completion.shell(command, cur_pos, ncomp, shell)
+    local wstart = 1
+    local wend = 1
+    local words = {}
+    local cword_index = 0
+    local cword_start = 0
+    local cword_end = 0
+    local i = 1
+    local comptype = "file"
+
+    -- do nothing if we are on a letter, i.e. not at len + 1 or on a space
+    if cur_pos ~= #command + 1 and command:sub(cur_pos, cur_pos) ~= " " then
+        return command, cur_pos
+    elseif #command == 0 then
+        return command, cur_pos
+    end
+
+    while wend <= #command do
+        wend = command:find(" ", wstart)
+        if not wend then wend = #command + 1 end
+        table.insert(words, command:sub(wstart, wend - 1))
+        if cur_pos >= wstart and cur_pos <= wend + 1 then
+            cword_start = wstart
+            cword_end = wend
+            cword_index = i
+        end
+        wstart = wend + 1
+        i = i + 1
+    end
+
+    if cword_index == 1 then
+        comptype = "command"
+    end
+
+    -- Command names are completed without running the shell each time. It
+    -- only completes arguments and paths.
+    shell = get_shell(shell)
+    local output = comptype == "command" and complete_command(words[cword_index], shell)
+    if not output then
+        output = shell_complete(command, cur_pos, words, cword_index, comptype, shell)
+    end
 
     -- no completion, return
     if #output == 0 then
@@ -10,7 +10,6 @@
 local setmetatable = setmetatable
 local ipairs = ipairs
 local capi = { key = key, root = root, awesome = awesome }
-local gmath = require("gears.math")
 local gtable = require("gears.table")
 
 local key = { mt = {}, hotkeys = {} }
@@ -95,13 +94,8 @@ function key.execute(mod, k)
 end
 
 --- Create a new key to use as binding.
--- This function is useful to create several keys from one, because it will use
--- the ignore_modifier variable to create several keys with and without the
--- ignored modifiers activated.
--- For example if you want to ignore CapsLock in your keybinding (which is
--- ignored by default by this function), creating a key binding with this
--- function will return 2 key objects: one with CapsLock on, and another one
--- with CapsLock off.
+-- The modifiers in `awful.key.ignore_modifiers` are ignored when matching the
+-- key, so that for example a binding still works while Caps Lock is active.
 -- @see key.key
 -- @tparam table mod A list of modifier keys.  Valid modifiers are: Any, Mod1,
 --   Mod2, Mod3, Mod4, Mod5, Shift, Lock and Control.
@@ -117,16 +111,14 @@ function key.new(mod, _key, press, release, data)
         release=nil
     end
     local ret = {}
-    local subsets = gmath.subsets(key.ignore_modifiers)
-    for _, set in ipairs(subsets) do
-        ret[#ret + 1] = capi.key({ modifiers = gtable.join(mod, set),
-                                   key = _key })
-        if press then
-            ret[#ret]:connect_signal("press", function(_, ...) press(...) end)
-        end
-        if release then
-            ret[#ret]:connect_signal("release", function(_, ...) release(...) end)
-        end
+    ret[1] = capi.key({ modifiers = mod,
+                        ignore_modifiers = key.ignore_modifiers,
+                        key = _key })
+    if press then
+        ret[1]:connect_signal("press", function(_, ...) press(...) end)
+    end
+    if release then
+        ret[1]:connect_signal("release", function(_, ...) release(...) end)
     end
 
     -- append custom userdata (like description) to a hotkey
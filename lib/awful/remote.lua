@@ -1,6 +1,12 @@
 ---------------------------------------------------------------------------
 --- Remote control module allowing usage of awesome-client.
 --
+-- Besides `Eval`, which is used by awesome-client, the interface has a `Stats`
+-- method that returns the main loop statistics from `awesome.stats` as text:
+--
+--    dbus-send --session --dest=org.awesomewm.awful --print-reply / \
+--        org.awesomewm.awful.Remote.Stats
+--
 -- @author Julien Danjou &lt;julien@danjou.info&gt;
 -- @copyright 2009 Julien Danjou
 -- @module awful.remote
@@ -14,7 +20,31 @@ local ipairs = ipairs
 local table = table
 local unpack = unpack or table.unpack -- luacheck: globals unpack (compatibility with Lua 5.1)
 local dbus = dbus
+local awesome = awesome
 local type = type
+local pairs = pairs
+local string = string
+
+--- Format the main loop statistics from `awesome.stats()` as text.
+-- @treturn string One line per phase, section and callback.
+local function mainloop_report()
+    local stats = awesome.stats().mainloop
+    local lines = { "mode: " .. stats.mode }
+    for _, kind in ipairs({ "phases", "sections", "callbacks" }) do
+        local names = {}
+        for name in pairs(stats[kind]) do
+            table.insert(names, name)
+        end
+        table.sort(names)
+        for _, name in ipairs(names) do
+            local entry = stats[kind][name]
+            table.insert(lines, string.format("%s %s: count=%d total=%.6f max=%.6f histogram=%s",
+                kind, name, entry.count, entry.total, entry.max,
+                table.concat(entry.histogram, ",")))
+        end
+    end
+    return table.concat(lines, "\n")
+end
 
 if dbus then
     dbus.connect_signal("org.awesomewm.awful.Remote", function(data, code)
@@ -42,6 +72,8 @@ if dbus then
                 end
             end
             return unpack(retvals)
+        elseif data.member == "Stats" then
+            return "s", mainloop_report()
         end
     end)
 end
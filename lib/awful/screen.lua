@@ -74,11 +74,14 @@ end
 -- @tparam number y The y coordinate
 -- @treturn ?number The screen index
 function screen.getbycoord(x, y)
-    local s, sgeos = capi.screen.primary, {}
-    for scr in capi.screen do
-        sgeos[scr] = scr.geometry
+    local s = capi.screen.at(x, y)
+    if not s then
+        local sgeos = {}
+        for scr in capi.screen do
+            sgeos[scr] = scr.geometry
+        end
+        s = grect.get_closest_by_coord(sgeos, x, y) or capi.screen.primary
     end
-    s = grect.get_closest_by_coord(sgeos, x, y) or s
     return s and s.index
 end
 
@@ -423,7 +423,8 @@ function spawn.with_line_callback(cmd, callbacks)
 end
 
 --- Asynchronously spawn a program and capture its output.
--- (wraps `spawn.with_line_callback`).
+-- The output is collected by awesome's core and handed over in one piece once
+-- the program exited and closed its output streams.
 -- @tparam string|table cmd The command.
 -- @tab callback Function with the following arguments
 --   @tparam string callback.stdout Output on stdout.
@@ -431,45 +432,28 @@ end
 --   @tparam string callback.exitreason Exit reason ("exit" or "signal").
 --   @tparam integer callback.exitcode Exit code (exit code or signal number,
 --     depending on "exitreason").
+-- @tparam[opt] integer max_bytes Only keep this many bytes of each stream.
+--   Further output is read and discarded. A stream that reached this limit
+--   does not get a newline added at its end.
 -- @treturn[1] Integer the PID of the forked process.
 -- @treturn[2] string Error message.
 -- @see spawn.with_line_callback
-function spawn.easy_async(cmd, callback)
-    local stdout = ''
-    local stderr = ''
-    local exitcode, exitreason
-    local function parse_stdout(str)
-        stdout = stdout .. str .. "\n"
-    end
-    local function parse_stderr(str)
-        stderr = stderr .. str .. "\n"
-    end
-    local function done_callback()
-        return callback(stdout, stderr, exitreason, exitcode)
-    end
-    local exit_callback_fired = false
-    local output_done_callback_fired = false
-    local function exit_callback(reason, code)
-        exitcode = code
-        exitreason = reason
-        exit_callback_fired = true
-        if output_done_callback_fired then
-            return done_callback()
+function spawn.easy_async(cmd, callback, max_bytes)
+    -- Like with_line_callback, every line ends with a newline. Output that was
+    -- cut off is left as it is, so that it stays within max_bytes.
+    local function terminate(output)
+        if output ~= "" and output:sub(-1) ~= "\n"
+           and not (max_bytes and #output >= max_bytes) then
+            return output .. "\n"
         end
+        return output
     end
-    local function output_done_callback()
-        output_done_callback_fired = true
-        if exit_callback_fired then
-            return done_callback()
-        end
+    local function exit_callback(reason, code, stdout, stderr)
+        return callback(terminate(stdout), terminate(stderr), reason, code)
     end
-    return spawn.with_line_callback(
-        cmd, {
-        stdout=parse_stdout,
-        stderr=parse_stderr,
-        exit=exit_callback,
-        output_done=output_done_callback
-    })
+    local pid = capi.awesome.spawn(cmd, false, false, false, false,
+            exit_callback, nil, max_bytes or true)
+    return pid
 end
 
 --- Call `spawn.easy_async` with a shell.
@@ -481,11 +465,13 @@ end
 --   @tparam string callback.exitreason Exit reason ("exit" or "signal").
 --   @tparam integer callback.exitcode Exit code (exit code or signal number,
 --     depending on "exitreason").
+-- @tparam[opt] integer max_bytes Only keep this many bytes of each stream.
+--   See `spawn.easy_async`.
 -- @treturn[1] Integer the PID of the forked process.
 -- @treturn[2] string Error message.
 -- @see spawn.with_line_callback
-function spawn.easy_async_with_shell(cmd, callback)
-    return spawn.easy_async({ util.shell, "-c", cmd or "" }, callback)
+function spawn.easy_async_with_shell(cmd, callback, max_bytes)
+    return spawn.easy_async({ util.shell, "-c", cmd or "" }, callback, max_bytes)
 end
 
 --- Read lines from a Gio input stream
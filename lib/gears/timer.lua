@@ -51,6 +51,7 @@
 
 local capi = { awesome = awesome }
 local ipairs = ipairs
+local math = math
 local pairs = pairs
 local setmetatable = setmetatable
 local table = table
@@ -83,27 +84,152 @@ local gdebug = require("gears.debug")
 
 local timer = { mt = {} }
 
+--- The default slack of timers in seconds.
+-- Timers are not fired at exactly their deadline, but at the next multiple of
+-- their slack. This lets timers with unrelated start times share wakeups: all
+-- timers that become due within the same slack interval are fired together in
+-- a single batch from a single GLib source. A timer's slack is additionally
+-- limited to a tenth of its timeout so that short timers stay accurate. Set
+-- this to 0 to get one wakeup per timer.
+-- @tfield[opt=0.05] number gears.timer.slack
+timer.slack = 0.05
+
+-- The scheduled batches, indexed by their deadline in milliseconds of
+-- monotonic time
+local wheel = {}
+
+local stats = {
+    wakeups = 0,
+    fired = 0,
+    batch_time = 0,
+    last_batch_time = 0,
+    max_batch_time = 0,
+}
+
+local function now()
+    return glib.get_monotonic_time() / 1e6
+end
+
+-- The shims used by the documentation examples do not profile anything
+local function profile_record(section, seconds)
+    if capi.awesome.profile_record then
+        capi.awesome.profile_record(section, seconds)
+    end
+end
+
+local function count_batches()
+    local ret = 0
+    for _ in pairs(wheel) do
+        ret = ret + 1
+    end
+    return ret
+end
+
+local schedule
+
+local function fire_batch(key)
+    local batch = wheel[key]
+    wheel[key] = nil
+    -- The source is removed by returning false below, unschedule() must not
+    -- remove it while it is being dispatched
+    batch.firing = true
+    local start = now()
+
+    stats.wakeups = stats.wakeups + 1
+    for _, t in ipairs(batch.timers) do
+        -- Timers that were stopped (or restarted) after they were added to
+        -- this batch no longer belong to it
+        if t.data.batch == batch then
+            t.data.batch = nil
+            batch.count = batch.count - 1
+            t.data.drift = now() - t.data.ideal
+            stats.fired = stats.fired + 1
+            protected_call(t.emit_signal, t, "timeout")
+            -- Reschedule unless the callback stopped or restarted the timer
+            if t.data.started and not t.data.batch then
+                local ideal = t.data.ideal + t.data.interval
+                -- Do not try to catch up on missed timeouts
+                if ideal < now() then
+                    ideal = now() + t.data.interval
+                end
+                schedule(t, ideal)
+            end
+        end
+    end
+
+    local elapsed = now() - start
+    stats.batch_time = stats.batch_time + elapsed
+    stats.last_batch_time = elapsed
+    stats.max_batch_time = math.max(stats.max_batch_time, elapsed)
+    profile_record("timers", elapsed)
+    return false
+end
+
+--- Add a timer to the batch belonging to its next deadline.
+-- @tparam timer t The timer.
+-- @tparam number ideal When the timer should fire if there was no slack.
+schedule = function(t, ideal)
+    local slack = math.min(t.data.slack or timer.slack, t.data.interval / 10)
+    local deadline = ideal
+    if slack > 0 then
+        deadline = math.ceil(ideal / slack) * slack
+    end
+    local key = math.ceil(deadline * 1000)
+
+    local batch = wheel[key]
+    if not batch then
+        local delay = math.max(0, key - math.floor(now() * 1000))
+        batch = { key = key, timers = {}, count = 0 }
+        batch.source_id = glib.timeout_add(glib.PRIORITY_DEFAULT, delay, function()
+            return fire_batch(key)
+        end)
+        wheel[key] = batch
+    end
+
+    table.insert(batch.timers, t)
+    batch.count = batch.count + 1
+    t.data.batch = batch
+    t.data.ideal = ideal
+end
+
+--- Remove a timer from the batch it is scheduled in.
+-- @tparam timer t The timer.
+local function unschedule(t)
+    local batch = t.data.batch
+    if not batch then
+        return
+    end
+    t.data.batch = nil
+    batch.count = batch.count - 1
+    if batch.count == 0 and not batch.firing then
+        glib.source_remove(batch.source_id)
+        -- A new batch may have been scheduled for the same deadline
+        if wheel[batch.key] == batch then
+            wheel[batch.key] = nil
+        end
+    end
+end
+
 --- Start the timer.
 function timer:start()
-    if self.data.source_id ~= nil then
+    if self.data.started then
         gdebug.print_error(traceback("timer already started"))
         return
     end
-    self.data.source_id = glib.timeout_add(glib.PRIORITY_DEFAULT, self.data.timeout * 1000, function()
-        protected_call(self.emit_signal, self, "timeout")
-        return true
-    end)
+    self.data.started = true
+    self.data.interval = self.data.timeout
+    schedule(self, now() + self.data.interval)
     self:emit_signal("start")
 end
 
 --- Stop the timer.
 function timer:stop()
-    if self.data.source_id == nil then
+    if not self.data.started then
         gdebug.print_error(traceback("timer not started"))
         return
     end
-    glib.source_remove(self.data.source_id)
-    self.data.source_id = nil
+    unschedule(self)
+    self.data.started = false
     self:emit_signal("stop")
 end
 
@@ -111,7 +237,7 @@ end
 -- This is equivalent to stopping the timer if it is running and then starting
 -- it.
 function timer:again()
-    if self.data.source_id ~= nil then
+    if self.data.started then
         self:stop()
     end
     self:start()
@@ -126,12 +252,27 @@ end
 -- @property timeout
 -- @param number
 
+--- The slack of this timer in seconds.
+-- When not set, `gears.timer.slack` is used. Changes take effect the next
+-- time the timer is scheduled.
+-- @property slack
+-- @param number
+
+--- How late the timer fired the last time, in seconds.
+-- This is the difference between when the timer's timeout signal was emitted
+-- and when it would have been emitted without any slack and without any delay
+-- from other batched timers.
+-- @property drift
+-- @param number
+
 local timer_instance_mt = {
     __index = function(self, property)
         if property == "timeout" then
             return self.data.timeout
         elseif property == "started" then
-            return self.data.source_id ~= nil
+            return self.data.started == true
+        elseif property == "slack" or property == "drift" then
+            return self.data[property]
         end
 
         return timer[property]
@@ -141,6 +282,8 @@ local timer_instance_mt = {
         if property == "timeout" then
             self.data.timeout = tonumber(value)
             self:emit_signal("property::timeout")
+        elseif property == "slack" then
+            self.data.slack = tonumber(value)
         end
     end
 }
@@ -153,13 +296,15 @@ local timer_instance_mt = {
 -- @tparam[opt=nil] function args.callback Callback function to connect to the
 --  "timeout" signal.
 -- @tparam[opt=false] boolean args.single_shot Run only once then stop.
+-- @tparam[opt=gears.timer.slack] number args.slack How much later than its
+--  timeout the timer may fire so that it can share a wakeup with other timers.
 -- @treturn timer
 -- @function gears.timer
 function timer.new(args)
     args = args or {}
     local ret = object()
 
-    ret.data = { timeout = 0 } --TODO v5 rename to ._private
+    ret.data = { timeout = 0, drift = 0 } --TODO v5 rename to ._private
     setmetatable(ret, timer_instance_mt)
 
     for k, v in pairs(args) do
@@ -226,6 +371,27 @@ function timer.weak_start_new(timeout, callback)
     end)
 end
 
+--- Get statistics about the timer wheel.
+-- The returned table has the following fields:
+--
+-- * `wakeups`: How many batches were fired.
+-- * `fired`: How many timeouts were emitted by these batches.
+-- * `pending`: The number of currently scheduled batches, which is the number
+--   of GLib sources used by timers.
+-- * `batch_time`: The total time spent in batches in seconds.
+-- * `last_batch_time`: The time the most recent batch took in seconds.
+-- * `max_batch_time`: The time the slowest batch took in seconds.
+--
+-- @treturn table The statistics.
+-- @function gears.timer.stats
+function timer.stats()
+    local ret = { pending = count_batches() }
+    for k, v in pairs(stats) do
+        ret[k] = v
+    end
+    return ret
+end
+
 local delayed_calls = {}
 
 --- Run all pending delayed calls now. This function should best not be used at
@@ -233,10 +399,15 @@ local delayed_calls = {}
 -- prematurely.
 -- @function gears.timer.run_delayed_calls_now
 function timer.run_delayed_calls_now()
+    if #delayed_calls == 0 then
+        return
+    end
+    local start = now()
     for _, callback in ipairs(delayed_calls) do
         protected_call(unpack(callback))
     end
     delayed_calls = {}
+    profile_record("delayed_calls", now() - start)
 end
 
 --- Call the given function at the end of the current main loop iteration
@@ -29,6 +29,7 @@ local surface = require("gears.surface")
 local timer = require("gears.timer")
 local debug = require("gears.debug")
 local root = root
+local awesome = awesome
 
 local wallpaper = { mt = {} }
 
@@ -269,6 +270,65 @@ function wallpaper.fit(surf, s, background)
     end
 end
 
+-- Callbacks of pending asynchronous wallpapers, indexed by request id
+local async_callbacks = {}
+
+--- Set a wallpaper from an image without blocking awesome.
+-- Loading and scaling the image is done in a separate thread and the current
+-- wallpaper stays visible until the new one is ready. Unlike the other
+-- functions in this module, the image is not drawn on top of a pending
+-- wallpaper from @{prepare_context}.
+-- @tparam table args
+-- @param args.image The image to set. Either a file name or a cairo image
+--   surface, which must not be changed until the wallpaper is set.
+-- @param[opt] args.screen The screen whose wallpaper should be set. The default
+--   is all screens.
+-- @tparam[opt="maximized"] string args.mode How to place the image: One of
+--   "maximized", "fit", "centered" or "tiled", see the functions with the same
+--   name.
+-- @param[opt] args.background The background color, handled via gears.color.
+--   It must not be a surface.
+-- @tparam[opt=false] boolean args.ignore_aspect See @{maximized}.
+-- @tparam[opt] table args.offset A table with entries x and y, see
+--   @{maximized} and @{tiled}.
+-- @tparam[opt=1] number args.scale See @{centered}.
+-- @tparam[opt] function callback Called with `true` when the wallpaper was
+--   set or `false` and an error message.
+-- @see gears.color
+function wallpaper.async(args, callback)
+    local s = get_screen(args.screen)
+    local geom = s and s.geometry or root_geometry()
+    local image = args.image
+    local background = args.background
+    if args.mode == "fit" or args.mode == "centered" then
+        background = background or "#000000"
+    end
+
+    local id = root.wallpaper_async {
+        path = type(image) == "string" and image or nil,
+        surface = type(image) ~= "string" and image and image._native or nil,
+        mode = args.mode,
+        background = background and color(background)._native,
+        x = geom.x, y = geom.y, width = geom.width, height = geom.height,
+        ignore_aspect = args.ignore_aspect,
+        offset_x = args.offset and args.offset.x,
+        offset_y = args.offset and args.offset.y,
+        scale = args.scale,
+    }
+    async_callbacks[id] = callback or false
+    return id
+end
+
+awesome.connect_signal("wallpaper_ready", function(id, success, err)
+    local callback = async_callbacks[id]
+    async_callbacks[id] = nil
+    if callback then
+        callback(success, err)
+    elseif not success then
+        debug.print_warning("Setting wallpaper failed: " .. tostring(err))
+    end
+end)
+
 return wallpaper
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -13,6 +13,7 @@
 local beautiful = require("beautiful")
 local gfs = require("gears.filesystem")
 local GLib = require("lgi").GLib
+local Gio = require("lgi").Gio
 local index_theme = require("menubar.index_theme")
 
 local ipairs = ipairs
@@ -77,6 +78,13 @@ local icon_theme = { mt = {} }
 
 local index_theme_cache = {}
 
+-- The icon files of each theme, see get_dir_index()
+local dir_index_cache = {}
+
+-- How long (in microseconds) the icon files of a theme are trusted before the
+-- modification times of its directories are compared again
+local DIR_INDEX_CHECK_INTERVAL = 2 * 1000 * 1000
+
 --- Class constructor of `icon_theme`
 -- @deprecated menubar.icon_theme.new
 -- @tparam string icon_theme_name Internal name of icon theme
@@ -103,6 +111,15 @@ icon_theme.new = function(icon_theme_name, base_directories)
     end
     self.index_theme = index_theme_cache[self.icon_theme_name][cache_key]
 
+    -- Share the index of icon files with all instances for the same theme.
+    if not dir_index_cache[self.icon_theme_name] then
+        dir_index_cache[self.icon_theme_name] = {}
+    end
+    if not dir_index_cache[self.icon_theme_name][cache_key] then
+        dir_index_cache[self.icon_theme_name][cache_key] = {}
+    end
+    self.dir_index = dir_index_cache[self.icon_theme_name][cache_key]
+
     return setmetatable(self, { __index = icon_theme })
 end
 
@@ -144,43 +161,101 @@ local directory_size_distance = function(self, subdirectory, icon_size)
     return 0xffffffff -- Any large number will do.
 end
 
-local lookup_icon = function(self, icon_name, icon_size)
-    local checked_already = {}
+local get_dir_mtime = function(path)
+    local info = Gio.File.new_for_path(path):query_info(
+        "time::modified,time::modified-usec", Gio.FileQueryInfoFlags.NONE)
+    if not info then
+        return ""
+    end
+    return tostring(info:get_attribute_uint64("time::modified")) .. "." ..
+           tostring(info:get_attribute_uint32("time::modified-usec"))
+end
+
+-- List the icon files in all subdirectories of the theme. Every icon name maps
+-- to its files in the order the lookup has to try them in: by subdirectory,
+-- then base directory, then extension.
+local build_dir_index = function(self)
+    local ext_order = {}
+    for i, ext in ipairs(self.extensions) do
+        ext_order[ext] = i
+    end
+
+    local icons, dirs = {}, {}
     for _, subdir in ipairs(self.index_theme:get_subdirectories()) do
         for _, basedir in ipairs(self.base_directories) do
-            for _, ext in ipairs(self.extensions) do
-                if directory_matches_size(self, subdir, icon_size) then
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
-                    if gfs.file_readable(filename) then
-                        return filename
-                    else
-                        checked_already[filename] = true
+            local path = string.format("%s/%s/%s", basedir, self.icon_theme_name, subdir)
+            -- Get the modification time first, so that changes while the
+            -- directory is listed are noticed later.
+            table.insert(dirs, { path = path, mtime = get_dir_mtime(path) })
+
+            local found = {}
+            local enum = Gio.File.new_for_path(path):enumerate_children(
+                "standard::name,standard::type", Gio.FileQueryInfoFlags.NONE)
+            if enum then
+                for info in function() return enum:next_file() end do
+                    local name, ext = info:get_name():match("^(.+)%.(%w+)$")
+                    if ext_order[ext] and info:get_file_type() == "REGULAR" then
+                        table.insert(found, { name = name, ext = ext })
                     end
                 end
+                enum:close()
+            end
+            table.sort(found, function(a, b) return ext_order[a.ext] < ext_order[b.ext] end)
+
+            for _, file in ipairs(found) do
+                icons[file.name] = icons[file.name] or {}
+                table.insert(icons[file.name], {
+                    subdir = subdir,
+                    filename = string.format("%s/%s.%s", path, file.name, file.ext)
+                })
             end
         end
     end
+    return icons, dirs
+end
+
+-- Get the icon files of the theme. They are listed once and listed again when
+-- one of the directories was modified since.
+local get_dir_index = function(self)
+    local index = self.dir_index
+    local now = GLib.get_monotonic_time()
+    if index.icons and now < index.checked + DIR_INDEX_CHECK_INTERVAL then
+        return index.icons
+    end
+
+    local valid = index.icons ~= nil
+    for _, dir in ipairs(valid and index.dirs or {}) do
+        if get_dir_mtime(dir.path) ~= dir.mtime then
+            valid = false
+            break
+        end
+    end
+    if not valid then
+        index.icons, index.dirs = build_dir_index(self)
+    end
+    index.checked = now
+    return index.icons
+end
+
+local lookup_icon = function(self, icon_name, icon_size)
+    local files = get_dir_index(self)[icon_name]
+    if not files then
+        return nil
+    end
+
+    for _, file in ipairs(files) do
+        if directory_matches_size(self, file.subdir, icon_size) then
+            return file.filename
+        end
+    end
 
     local minimal_size = 0xffffffff -- Any large number will do.
     local closest_filename = nil
-    for _, subdir in ipairs(self.index_theme:get_subdirectories()) do
-        local dist = directory_size_distance(self, subdir, icon_size)
+    for _, file in ipairs(files) do
+        local dist = directory_size_distance(self, file.subdir, icon_size)
         if dist < minimal_size then
-            for _, basedir in ipairs(self.base_directories) do
-                for _, ext in ipairs(self.extensions) do
-                    local filename = string.format("%s/%s/%s/%s.%s",
-                                                   basedir, self.icon_theme_name, subdir,
-                                                   icon_name, ext)
-                    if not checked_already[filename] then
-                        if gfs.file_readable(filename) then
-                            closest_filename = filename
-                            minimal_size = dist
-                        end
-                    end
-                end
-            end
+            closest_filename = file.filename
+            minimal_size = dist
         end
     end
     return closest_filename
@@ -22,6 +22,7 @@
 -- Grab environment we need
 local capi = {
     client = client,
+    fuzzy = fuzzy,
     mouse = mouse,
     screen = screen
 }
@@ -120,6 +121,9 @@ local previous_item = nil
 local current_category = nil
 local shownitems = nil
 local instance = nil
+-- Index of menubar.menu_entries for searching them by name and cmdline
+local entry_index = nil
+local indexed_entries = nil
 
 local common_args = { w = wibox.layout.fixed.horizontal(),
                       data = setmetatable({}, { __mode = 'kv' }) }
@@ -196,6 +200,9 @@ local function perform_action(o)
         -- increase count
         local curname = shownitems[current_item].name
         count_table[curname] = (count_table[curname] or 0) + 1
+        if entry_index then
+            entry_index:set_weight(curname, count_table[curname])
+        end
         -- write updated count table to cache file
         write_count_table(count_table)
         -- Let awful.prompt execute dummy exec_callback and
@@ -245,25 +252,68 @@ local function get_current_page(all_items, query, scr)
     return current_page
 end
 
+--- Find the menu entries matching a query by their name and cmdline.
+-- The fuzzy index ranks prefix matches before other matches of the query and
+-- entries that only contain its characters in order last, each by the weights
+-- from count_table. Without awesome's C API, like in the unit tests, the
+-- entries are matched one by one and subsequences are not found.
+-- @tparam string query The query.
+-- @tparam string pattern The query as a Lua pattern.
+-- @tparam table count_table The usage counts of the entries by name.
+-- @treturn table The matching entries.
+local function search_entries(query, pattern, count_table)
+    if not capi.fuzzy then
+        local prefix_matches, matches = {}, {}
+        for _, v in ipairs(menubar.menu_entries) do
+            if string.match(v.name, "^" .. pattern) then
+                table.insert(prefix_matches, v)
+            elseif string.match(v.name, pattern) or string.match(v.cmdline, pattern) then
+                table.insert(matches, v)
+            end
+        end
+        local function compare_counts(a, b)
+            return (tonumber(count_table[a.name]) or 0) > (tonumber(count_table[b.name]) or 0)
+        end
+        table.sort(prefix_matches, compare_counts)
+        table.sort(matches, compare_counts)
+        for _, v in ipairs(matches) do
+            table.insert(prefix_matches, v)
+        end
+        return prefix_matches
+    end
+
+    if indexed_entries ~= menubar.menu_entries then
+        indexed_entries = menubar.menu_entries
+        entry_index = capi.fuzzy.new()
+        for _, v in ipairs(indexed_entries) do
+            entry_index:add(v.name, v.cmdline, v)
+        end
+        for name, count in pairs(count_table) do
+            entry_index:set_weight(name, tonumber(count) or 0)
+        end
+    end
+    return entry_index:search(query)
+end
+
 --- Update the menubar according to the command entered by user.
 -- @tparam number|screen scr Screen
 local function menulist_update(scr)
     local query = instance.query or ""
+    for _, v in ipairs(shownitems or {}) do
+        v.focused = false
+    end
     shownitems = {}
     local pattern = gstring.query_to_pattern(query)
 
-    -- All entries are added to a list that will be sorted
-    -- according to the priority (first) and weight (second) of its
-    -- entries.
-    -- If categories are used in the menu, we add the entries matching
-    -- the current query with high priority as to ensure they are
-    -- displayed first. Afterwards the non-category entries are added.
+    -- If categories are used in the menu, we add the categories matching
+    -- the current query first and sort them according to their priority
+    -- (first) and weight (second). Afterwards the non-category entries are
+    -- added in the order ranked by search_entries().
     -- All entries are weighted according to the number of times they
     -- have been executed previously (stored in count_table).
     local count_table = load_count_table()
     local command_list = {}
 
-    local PRIO_NONE = 0
     local PRIO_CATEGORY_MATCH = 2
 
     -- Add the categories
@@ -298,39 +348,6 @@ local function menulist_update(scr)
         end
     end
 
-    -- Add the applications according to their name and cmdline
-    for _, v in ipairs(menubar.menu_entries) do
-        v.focused = false
-        if not current_category or v.category == current_category then
-
-            -- check if the query matches either the name or the commandline
-            -- of some entry
-            if string.match(v.name, pattern)
-                or string.match(v.cmdline, pattern) then
-
-                v.weight = 0
-                v.prio = PRIO_NONE
-
-                -- get use count from count_table if present
-                -- and use it as weight
-                if string.len(pattern) > 0 and count_table[v.name] ~= nil then
-                    v.weight = tonumber(count_table[v.name])
-                end
-
-                -- check for prefix match
-                if string.match(v.name, "^" .. pattern)
-                    or string.match(v.cmdline, "^" .. pattern) then
-                    -- increase default priority
-                    v.prio = PRIO_NONE + 1
-                else
-                    v.prio = PRIO_NONE
-                end
-
-                table.insert (command_list, v)
-            end
-        end
-    end
-
     local function compare_counts(a, b)
         if a.prio == b.prio then
             return a.weight > b.weight
@@ -340,6 +357,13 @@ local function menulist_update(scr)
 
     -- sort command_list by weight (highest first)
     table.sort(command_list, compare_counts)
+
+    for _, v in ipairs(search_entries(query, pattern, count_table)) do
+        if not current_category or v.category == current_category then
+            table.insert(command_list, v)
+        end
+    end
+
     -- copy into showitems
     shownitems = command_list
 
@@ -75,55 +75,78 @@ local function get_category_name_and_usage_by_type(app_type)
     end
 end
 
+--- Turn parsed .desktop files into menu entries.
+-- @tparam table programs For each menu dir, the list of its parsed .desktop
+--   files.
+-- @treturn table The menu entries.
+local function get_menu_entries(programs)
+    local result = {}
+    local unique_entries = {}
+
+    for i = 1, #menu_gen.all_menu_dirs do
+        for _, entry in ipairs(programs[i]) do
+            -- Check whether to include program in the menu
+            if entry.show and entry.Name and entry.cmdline then
+                local unique_key = entry.Name .. '\0' .. entry.cmdline
+                if not unique_entries[unique_key] then
+                    local target_category = nil
+                    -- Check if the program falls into at least one of the
+                    -- usable categories. Set target_category to be the id
+                    -- of the first category it finds.
+                    if entry.categories then
+                        for _, category in pairs(entry.categories) do
+                            local cat_key, cat_use =
+                            get_category_name_and_usage_by_type(category)
+                            if cat_key and cat_use then
+                                target_category = cat_key
+                                break
+                            end
+                        end
+                    end
+
+                    local name = utils.rtrim(entry.Name) or ""
+                    local cmdline = utils.rtrim(entry.cmdline) or ""
+                    local icon = entry.icon_path or nil
+                    table.insert(result, { name = name,
+                                 cmdline = cmdline,
+                                 icon = icon,
+                                 category = target_category })
+                    unique_entries[unique_key] = true
+                end
+            end
+        end
+    end
+
+    return result
+end
+
 --- Generate an array of all visible menu entries.
+--
+-- With `menubar.utils.persistent_cache`, the callback is called right away
+-- with the cached entries if all menu directories are cached. After that, the
+-- background check calls it once more for every menu directory that changed,
+-- each time with all entries known so far.
 -- @tparam function callback Will be fired when all menu entries were parsed
 -- with the resulting list of menu entries as argument.
 -- @tparam table callback.entries All menu entries.
 function menu_gen.generate(callback)
+    -- Icon lookups are cached as well
+    utils.load_cache()
+
     -- Update icons for category entries
     menu_gen.lookup_category_icons()
 
-    local result = {}
-    local unique_entries = {}
+    local programs = {}
     local dirs_parsed = 0
 
-    for _, dir in ipairs(menu_gen.all_menu_dirs) do
-        utils.parse_dir(dir, function(entries)
-            entries = entries or {}
-            for _, entry in ipairs(entries) do
-                -- Check whether to include program in the menu
-                if entry.show and entry.Name and entry.cmdline then
-                    local unique_key = entry.Name .. '\0' .. entry.cmdline
-                    if not unique_entries[unique_key] then
-                        local target_category = nil
-                        -- Check if the program falls into at least one of the
-                        -- usable categories. Set target_category to be the id
-                        -- of the first category it finds.
-                        if entry.categories then
-                            for _, category in pairs(entry.categories) do
-                                local cat_key, cat_use =
-                                get_category_name_and_usage_by_type(category)
-                                if cat_key and cat_use then
-                                    target_category = cat_key
-                                    break
-                                end
-                            end
-                        end
-
-                        local name = utils.rtrim(entry.Name) or ""
-                        local cmdline = utils.rtrim(entry.cmdline) or ""
-                        local icon = entry.icon_path or nil
-                        table.insert(result, { name = name,
-                                     cmdline = cmdline,
-                                     icon = icon,
-                                     category = target_category })
-                        unique_entries[unique_key] = true
-                    end
-                end
+    for i, dir in ipairs(menu_gen.all_menu_dirs) do
+        utils.parse_dir_cached(dir, function(entries)
+            if not programs[i] then
+                dirs_parsed = dirs_parsed + 1
             end
-            dirs_parsed = dirs_parsed + 1
+            programs[i] = entries or {}
             if dirs_parsed == #menu_gen.all_menu_dirs then
-                callback(result)
+                callback(get_menu_entries(programs))
             end
         end)
     end
@@ -12,6 +12,7 @@ local ipairs = ipairs
 local string = string
 local screen = screen
 local gfs = require("gears.filesystem")
+local gtimer = require("gears.timer")
 local theme = require("beautiful")
 local lgi = require("lgi")
 local gio = lgi.Gio
@@ -41,6 +42,11 @@ local default_icon = nil
 --- Name of the WM for the OnlyShowIn entry in the .desktop file.
 utils.wm_name = "awesome"
 
+--- Keep parsed .desktop files and icon lookups in a file below
+-- $XDG_CACHE_HOME, so that the next start does not have to read them again.
+-- The cached entries are checked for changes in the background.
+utils.persistent_cache = true
+
 -- Maps keys in desktop entries to suitable getter function.
 -- The order of entries is as in the spec.
 -- https://standards.freedesktop.org/desktop-entry-spec/latest/ar01s05.html
@@ -240,6 +246,16 @@ function utils.lookup_icon_uncached(icon_file)
     end
 end
 
+--- Version of the cache file format. Bump this whenever the format or the
+-- meaning of its fields changes.
+local cache_version = 1
+
+-- The contents of the cache file, nil if it was not loaded yet
+local cache = nil
+local cache_dirty = false
+-- Callbacks of utils.parse_dir_cached() waiting for the background check
+local cache_pending = nil
+
 local lookup_icon_cache = {}
 --- Lookup an icon in different folders of the filesystem (cached).
 -- @param icon Short or full name of the icon.
@@ -247,6 +263,10 @@ local lookup_icon_cache = {}
 function utils.lookup_icon(icon)
     if not lookup_icon_cache[icon] and lookup_icon_cache[icon] ~= false then
         lookup_icon_cache[icon] = utils.lookup_icon_uncached(icon)
+        if cache and icon and lookup_icon_cache[icon] ~= nil then
+            cache.icons[icon] = lookup_icon_cache[icon]
+            cache_dirty = true
+        end
     end
     return lookup_icon_cache[icon] or default_icon
 end
@@ -345,13 +365,26 @@ function utils.parse_desktop_file(file)
     return program
 end
 
---- Parse a directory with .desktop files recursively.
--- @tparam string dir_path The directory path.
--- @tparam function callback Will be fired when all the files were parsed
--- with the resulting list of menu entries as argument.
--- @tparam table callback.programs Paths of found .desktop files.
-function utils.parse_dir(dir_path, callback)
+local mtime_query = "time::modified,time::modified-usec"
+
+--- Get the modification time of a file as a string.
+-- @param info The GFileInfo, queried with the time::modified attributes.
+-- @treturn string The modification time, "0" if unknown.
+local function get_mtime(info)
+    if not info then
+        return "0"
+    end
+    return tostring(info:get_attribute_uint64("time::modified")) .. "." ..
+           tostring(info:get_attribute_uint32("time::modified-usec"))
+end
 
+--- Parse a directory with .desktop files recursively. This has to be called
+-- from a Gio.Async context.
+-- @tparam string dir_path The directory path.
+-- @tparam[opt] table mtimes Filled with the modification times of all
+--   directories that were looked at, by path.
+-- @treturn table The parsed .desktop files.
+local function async_parse_dir(dir_path, mtimes)
     local function get_readable_path(file)
         return file:get_path() or file:get_uri()
     end
@@ -359,6 +392,7 @@ function utils.parse_dir(dir_path, callback)
     local function parser(file, programs)
         -- Except for "NONE" there is also NOFOLLOW_SYMLINKS
         local query = gio.FILE_ATTRIBUTE_STANDARD_NAME .. "," .. gio.FILE_ATTRIBUTE_STANDARD_TYPE
+            .. "," .. mtime_query
         local enum, err = file:async_enumerate_children(query, gio.FileQueryInfoFlags.NONE)
         if not enum then
             gdebug.print_warning(get_readable_path(file) .. ": " .. tostring(err))
@@ -385,6 +419,9 @@ function utils.parse_dir(dir_path, callback)
                         end
                     end
                 elseif file_type == 'DIRECTORY' then
+                    if mtimes and file_child:get_path() then
+                        mtimes[file_child:get_path()] = get_mtime(info)
+                    end
                     parser(file_child, programs)
                 end
             end
@@ -395,13 +432,272 @@ function utils.parse_dir(dir_path, callback)
         enum:async_close()
     end
 
+    local result = {}
+    local dir = gio.File.new_for_path(dir_path)
+    if mtimes then
+        mtimes[dir_path] = get_mtime(dir:async_query_info(mtime_query, gio.FileQueryInfoFlags.NONE))
+    end
+    parser(dir, result)
+    return result
+end
+
+--- Parse a directory with .desktop files recursively.
+-- @tparam string dir_path The directory path.
+-- @tparam function callback Will be fired when all the files were parsed
+-- with the resulting list of menu entries as argument.
+-- @tparam table callback.programs Paths of found .desktop files.
+function utils.parse_dir(dir_path, callback)
     gio.Async.start(do_protected_call)(function()
-        local result = {}
-        parser(gio.File.new_for_path(dir_path), result)
-        call_callback(callback, result)
+        call_callback(callback, async_parse_dir(dir_path))
     end)
 end
 
+-- The persistent cache. Its file contains one record per line, with fields
+-- separated by tabs:
+--
+--     awesome-menubar-cache <version>
+--     settings <wm_name> <terminal> <icon theme> <language>
+--     mtime <menu dir> <directory> <modification time>
+--     entry <menu dir> <file> <show> <Name> <cmdline> <icon_path> <categories>
+--     icon_dir <directory> <modification time>
+--     icon <name> <lookup_icon() result>
+--
+-- Each menu dir is valid as long as the modification times of all directories
+-- below it are the same. Icon lookups are valid as long as the directories
+-- they were looked up in did not change.
+
+local cache_escapes = { ["\\"] = "\\\\", ["\t"] = "\\t", ["\n"] = "\\n" }
+local cache_unescapes = { ["\\"] = "\\", t = "\t", n = "\n" }
+
+local function cache_encode(value)
+    if value == nil or value == false then
+        return "\\N"
+    end
+    return (tostring(value):gsub("[\\\t\n]", cache_escapes))
+end
+
+local function cache_decode(field)
+    if field == "\\N" then
+        return nil
+    end
+    return (field:gsub("\\(.)", cache_unescapes))
+end
+
+local function get_cache_path()
+    return gfs.get_cache_dir() .. "menubar_cache"
+end
+
+--- Get the settings that the cached entries depend on.
+local function get_cache_settings()
+    local fields = { "settings", utils.wm_name, utils.terminal,
+                     theme.icon_theme or "", glib.get_language_names()[1] or "" }
+    for i, field in ipairs(fields) do
+        fields[i] = cache_encode(field)
+    end
+    return table.concat(fields, "\t")
+end
+
+--- Read the cache file.
+-- @treturn table The cached menu dirs and icon lookups, empty if the file does
+--   not exist or was written by another version or with other settings.
+local function read_cache()
+    local result = { dirs = {}, icon_dirs = {}, icons = {} }
+
+    local f = io.open(get_cache_path(), "r")
+    if not f then
+        return result
+    end
+    local content = f:read("*a")
+    f:close()
+
+    local header, settings, body = content:match("^([^\n]*)\n([^\n]*)\n(.*)$")
+    if header ~= "awesome-menubar-cache\t" .. cache_version
+            or settings ~= get_cache_settings() then
+        return result
+    end
+
+    for line in body:gmatch("[^\n]+") do
+        -- Fields can be nil, so do not use table.insert()
+        local fields, n = {}, 0
+        for field in (line .. "\t"):gmatch("(.-)\t") do
+            n = n + 1
+            fields[n] = cache_decode(field)
+        end
+
+        local kind, dir = fields[1], fields[2]
+        if (kind == "mtime" or kind == "entry") and not result.dirs[dir] then
+            result.dirs[dir] = { mtimes = {}, programs = {} }
+        end
+        if kind == "mtime" then
+            result.dirs[dir].mtimes[fields[3]] = fields[4]
+        elseif kind == "entry" then
+            local categories = nil
+            if fields[8] then
+                categories = {}
+                for category in fields[8]:gmatch("[^;]+") do
+                    table.insert(categories, category)
+                end
+            end
+            table.insert(result.dirs[dir].programs, {
+                file = fields[3],
+                show = fields[4] == "1",
+                Name = fields[5],
+                cmdline = fields[6],
+                icon_path = fields[7],
+                categories = categories,
+            })
+        elseif kind == "icon_dir" then
+            table.insert(result.icon_dirs, { path = dir, mtime = fields[3] })
+        elseif kind == "icon" then
+            result.icons[dir] = fields[3] or false
+        end
+    end
+
+    return result
+end
+
+--- Write the cache file. It is replaced atomically, so that a concurrent
+-- start never sees half of it.
+local function write_cache()
+    local lines = { "awesome-menubar-cache\t" .. cache_version, get_cache_settings() }
+    local function add(...)
+        local fields = { ... }
+        for i = 1, select("#", ...) do
+            fields[i] = cache_encode(fields[i])
+        end
+        table.insert(lines, table.concat(fields, "\t", 1, select("#", ...)))
+    end
+
+    for dir, cached in pairs(cache.dirs) do
+        for path, mtime in pairs(cached.mtimes) do
+            add("mtime", dir, path, mtime)
+        end
+        for _, program in ipairs(cached.programs) do
+            add("entry", dir, program.file, program.show and "1" or "0",
+                program.Name, program.cmdline, program.icon_path,
+                program.categories and table.concat(program.categories, ";"))
+        end
+    end
+    for _, icon_dir in ipairs(cache.icon_dirs) do
+        add("icon_dir", icon_dir.path, icon_dir.mtime)
+    end
+    for name, path in pairs(cache.icons) do
+        add("icon", name, path)
+    end
+
+    local path = get_cache_path()
+    local f = io.open(path .. ".tmp", "w")
+    if not f then
+        return
+    end
+    f:write(table.concat(lines, "\n"), "\n")
+    f:close()
+    os.rename(path .. ".tmp", path)
+    cache_dirty = false
+end
+
+--- Load the persistent cache if this was not done yet. Afterwards,
+-- `lookup_icon` answers from the cache. `menubar.menu_gen.generate` calls
+-- this.
+function utils.load_cache()
+    if cache or not utils.persistent_cache then
+        return
+    end
+    cache = read_cache()
+    for name, path in pairs(cache.icons) do
+        lookup_icon_cache[name] = path
+    end
+end
+
+--- Check the cached icon lookups and menu dirs for changes and parse the
+-- changed menu dirs again. This has to be called from a Gio.Async context.
+local function async_refresh_cache()
+    local function mtime_of(path)
+        return get_mtime(gio.File.new_for_path(path):async_query_info(mtime_query,
+                                                                     gio.FileQueryInfoFlags.NONE))
+    end
+
+    -- Icons are looked up in the same list of directories as before and none
+    -- of them got new files, so the same icons would be found again.
+    local icon_dirs = {}
+    local icons_changed = #get_icon_lookup_path() ~= #cache.icon_dirs
+    for i, path in ipairs(get_icon_lookup_path()) do
+        icon_dirs[i] = { path = path, mtime = mtime_of(path) }
+        local cached = cache.icon_dirs[i]
+        if not cached or cached.path ~= path or cached.mtime ~= icon_dirs[i].mtime then
+            icons_changed = true
+        end
+    end
+    if icons_changed then
+        cache.icon_dirs = icon_dirs
+        cache.icons = {}
+        lookup_icon_cache = {}
+        -- Parsed entries contain the icons that were found
+        cache.dirs = {}
+        cache_dirty = true
+    end
+
+    local pending = cache_pending
+    cache_pending = nil
+    for dir, callbacks in pairs(pending) do
+        local cached = cache.dirs[dir]
+        local changed = not cached
+        for path, mtime in pairs(cached and cached.mtimes or {}) do
+            if mtime_of(path) ~= mtime then
+                changed = true
+                break
+            end
+        end
+        if changed then
+            local mtimes = {}
+            cache.dirs[dir] = { mtimes = mtimes, programs = async_parse_dir(dir, mtimes) }
+            cache_dirty = true
+            for _, callback in ipairs(callbacks) do
+                call_callback(callback, cache.dirs[dir].programs)
+            end
+        end
+    end
+
+    if cache_dirty then
+        write_cache()
+    end
+end
+
+--- Parse a directory with .desktop files recursively, using the persistent
+-- cache.
+--
+-- If the directory is in the cache, the callback is called right away with
+-- the cached entries. These only contain the `file`, `show`, `Name`,
+-- `cmdline`, `icon_path` and `categories` fields. In the background, the
+-- cache is checked for changes and the callback is called again with newly
+-- parsed entries if the directory changed or was not cached. So it is called
+-- at most twice, and only once if the directory was not cached. Without
+-- `utils.persistent_cache`, this is the same as `utils.parse_dir`.
+-- @tparam string dir_path The directory path.
+-- @tparam function callback Will be fired with the list of menu entries as
+--   argument.
+-- @tparam table callback.programs The parsed .desktop files.
+function utils.parse_dir_cached(dir_path, callback)
+    if not utils.persistent_cache then
+        return utils.parse_dir(dir_path, callback)
+    end
+
+    utils.load_cache()
+    if cache.dirs[dir_path] then
+        callback(cache.dirs[dir_path].programs)
+    end
+
+    -- Check all directories of one menu_gen.generate() together
+    if not cache_pending then
+        cache_pending = {}
+        gtimer.delayed_call(function()
+            gio.Async.start(do_protected_call)(async_refresh_cache)
+        end)
+    end
+    cache_pending[dir_path] = cache_pending[dir_path] or {}
+    table.insert(cache_pending[dir_path], callback)
+end
+
 function utils.compute_textbox_width(textbox, s)
     gdebug.deprecate("Use 'width, _ = textbox:get_preferred_size(s)' directly.", {deprecated_in=4})
     s = screen[s or mouse.screen]
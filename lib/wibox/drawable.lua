@@ -62,6 +62,43 @@ local function get_widget_context(self)
     return context
 end
 
+-- Incremented whenever the wallpaper changes
+local wallpaper_generation = 0
+
+-- Get the wallpaper slice below a drawable, combined with its background.
+-- This is cached per drawable until the wallpaper, the background or the
+-- drawable's geometry change, so that repainting the background is a single
+-- copy of the dirty area instead of reading from the root window's pixmap.
+local function get_background(self, target, x, y, width, height)
+    local cache = self._background_cache
+    if cache and cache.generation == wallpaper_generation
+            and cache.x == x and cache.y == y
+            and cache.width == width and cache.height == height then
+        return cache.surface
+    end
+
+    local result = target:create_similar(cairo.Content.COLOR_ALPHA, width, height)
+    local cr = cairo.Context(result)
+    local wallpaper = surface.load_silently(capi.root.wallpaper(), false)
+    cr.operator = cairo.Operator.SOURCE
+    if wallpaper then
+        cr:set_source_surface(wallpaper, -x, -y)
+    else
+        cr:set_source_rgb(0, 0, 0)
+    end
+    cr:paint()
+    cr.operator = cairo.Operator.OVER
+    cr:set_source(self.background_color)
+    cr:paint()
+
+    self._background_cache = {
+        surface = result,
+        generation = wallpaper_generation,
+        x = x, y = y, width = width, height = height
+    }
+    return result
+end
+
 local function do_redraw(self)
     if not self.drawable.valid then return end
     if self._forced_screen and not self._forced_screen.valid then return end
@@ -114,29 +151,23 @@ local function do_redraw(self)
         local rect = self._dirty_area:get_rectangle(i)
         cr:rectangle(rect.x, rect.y, rect.width, rect.height)
     end
+    local damage = self._dirty_area:get_extents()
     self._dirty_area = cairo.Region.create()
     cr:clip()
 
     -- Draw the background
     cr:save()
 
-    if not capi.awesome.composite_manager_running then
-        -- This is pseudo-transparency: We draw the wallpaper in the background
-        local wallpaper = surface.load_silently(capi.root.wallpaper(), false)
-        cr.operator = cairo.Operator.SOURCE
-        if wallpaper then
-            cr:set_source_surface(wallpaper, -x, -y)
-        else
-            cr:set_source_rgb(0, 0, 0)
-        end
-        cr:paint()
-        cr.operator = cairo.Operator.OVER
+    cr.operator = cairo.Operator.SOURCE
+    if not capi.awesome.composite_manager_running and self._redraw_on_move then
+        -- This is pseudo-transparency: The wallpaper below us with the
+        -- (translucent) background on top, which only changes rarely
+        cr:set_source_surface(get_background(self, surf, x, y, width, height), 0, 0)
     else
-        -- This is true transparency: We draw a translucent background
-        cr.operator = cairo.Operator.SOURCE
+        -- This is true transparency or an opaque background which hides the
+        -- wallpaper anyway
+        cr:set_source(self.background_color)
     end
-
-    cr:set_source(self.background_color)
     cr:paint()
 
     cr:restore()
@@ -160,7 +191,8 @@ local function do_redraw(self)
         self._widget_hierarchy:draw(context, cr)
     end
 
-    self.drawable:refresh()
+    -- Only the damaged part has to be uploaded to the X server
+    self.drawable:refresh(damage.x, damage.y, damage.width, damage.height)
 
     assert(cr.status == "SUCCESS", "Cairo context entered error state: " .. cr.status)
 end
@@ -263,6 +295,7 @@ function drawable:set_bg(c)
     end
 
     self.background_color = c
+    self._background_cache = nil
     self._do_complete_repaint()
 end
 
@@ -403,7 +436,10 @@ function drawable.new(d, widget_context_skeleton, drawable_name)
     end
 
     -- Do a full redraw if the surface changes (the new surface has no content yet)
-    d:connect_signal("property::surface", ret._do_complete_repaint)
+    d:connect_signal("property::surface", function()
+        ret._background_cache = nil
+        ret._do_complete_repaint()
+    end)
 
     -- Do a normal redraw when the drawable moves. This will likely do nothing
     -- in most cases, but it makes us do a complete repaint when we are moved to
@@ -485,6 +521,7 @@ end
 
 -- Redraw all drawables when the wallpaper changes
 capi.awesome.connect_signal("wallpaper_changed", function()
+    wallpaper_generation = wallpaper_generation + 1
     for d in pairs(visible_drawables) do
         d:_do_complete_repaint()
     end
@@ -18,6 +18,67 @@ local hierarchy = {}
 
 local widgets_to_count = setmetatable({}, { __mode = "k" })
 
+--- The maximum number of bytes used by cached layers of cacheable widgets.
+-- When more memory is needed, the least recently used layers are dropped.
+-- @see wibox.widget.base.widget.set_cacheable
+hierarchy.layer_cache_limit = 32 * 1024 * 1024
+
+-- Cached layers by hierarchy. Weak, so that layers of hierarchies that are no
+-- longer used go away with them.
+local layers = setmetatable({}, { __mode = "k" })
+local layer_clock = 0
+local layer_stats = { hits = 0, misses = 0, evictions = 0 }
+
+--- Get statistics about the layer cache.
+-- @treturn table A table with the fields `count` (number of cached layers),
+--   `bytes` (memory used by them), `hits` (draws that reused a layer),
+--   `misses` (draws that had to render a layer) and `evictions` (layers
+--   dropped because of `layer_cache_limit`).
+function hierarchy.layer_stats()
+    local count, bytes = 0, 0
+    for _, layer in pairs(layers) do
+        count, bytes = count + 1, bytes + layer.bytes
+    end
+    return {
+        count = count,
+        bytes = bytes,
+        hits = layer_stats.hits,
+        misses = layer_stats.misses,
+        evictions = layer_stats.evictions,
+    }
+end
+
+-- Drop the cached layers of a hierarchy and of all its parents, since their
+-- layers contain this hierarchy's drawing.
+local function invalidate_layers(h)
+    while h do
+        layers[h] = nil
+        h = h._parent
+    end
+end
+
+-- Drop least recently used layers until `needed` more bytes fit into the limit.
+local function evict_layers(needed)
+    local bytes = 0
+    for _, layer in pairs(layers) do
+        bytes = bytes + layer.bytes
+    end
+    while bytes + needed > hierarchy.layer_cache_limit do
+        local oldest_h, oldest
+        for h, layer in pairs(layers) do
+            if not oldest or layer.last_used < oldest.last_used then
+                oldest_h, oldest = h, layer
+            end
+        end
+        if not oldest then
+            return
+        end
+        layers[oldest_h] = nil
+        bytes = bytes - oldest.bytes
+        layer_stats.evictions = layer_stats.evictions + 1
+    end
+end
+
 --- Add a widget to the list of widgets for which hierarchies should count their
 -- occurrences. Note that for correct operations, the widget must not yet be
 -- visible in any hierarchy.
@@ -52,9 +113,11 @@ local function hierarchy_new(redraw_callback, layout_callback, callback_arg)
     }
 
     function result._redraw()
+        invalidate_layers(result)
         redraw_callback(result, callback_arg)
     end
     function result._layout()
+        invalidate_layers(result)
         local h = result
         while h do
             h._need_update = true
@@ -93,6 +156,7 @@ function hierarchy_update(self, context, widget, width, height, region, matrix_t
     end
 
     self._need_update = false
+    layers[self] = nil
 
     local old_x, old_y, old_width, old_height
     local old_widget = self._widget
@@ -296,6 +360,85 @@ local function empty_clip(cr)
     return width == 0 or height == 0
 end
 
+-- Draw a hierarchy's widget and its children, without any opacity handling.
+local function draw_content(self, context, cr, widget)
+    local function call(func, extra_arg1, extra_arg2)
+        if not func then return end
+        if not extra_arg2 then
+            protected_call(func, widget, context, cr, self:get_size())
+        else
+            protected_call(func, widget, context, extra_arg1, extra_arg2, cr, self:get_size())
+        end
+    end
+
+    -- Draw the widget
+    cr:save()
+    cr:rectangle(0, 0, self:get_size())
+    cr:clip()
+    call(widget.draw)
+    cr:restore()
+
+    -- Draw its children (We already clipped to the draw extents above)
+    call(widget.before_draw_children)
+    for i, wi in ipairs(self:get_children()) do
+        call(widget.before_draw_child, i, wi:get_widget())
+        wi:draw(context, cr)
+        call(widget.after_draw_child, i, wi:get_widget())
+    end
+    call(widget.after_draw_children)
+end
+
+-- Get the cached layer of a cacheable widget, rendering it if needed. Returns
+-- nil if the hierarchy cannot be cached, because its pixels would not line up
+-- with the device's pixels.
+local function get_layer(self, context)
+    local m = self:get_matrix_to_device()
+    if m.xx ~= 1 or m.yy ~= 1 or m.xy ~= 0 or m.yx ~= 0
+            or m.x0 ~= math.floor(m.x0) or m.y0 ~= math.floor(m.y0) then
+        return nil
+    end
+
+    local x, y, width, height = self:get_draw_extents()
+    local x1, y1 = math.floor(x), math.floor(y)
+    width, height = math.ceil(x + width) - x1, math.ceil(y + height) - y1
+    if width <= 0 or height <= 0 then
+        return nil
+    end
+
+    local layer = layers[self]
+    if layer and layer.width == width and layer.height == height and
+            layer.x == x1 and layer.y == y1 and layer.dpi == context.dpi then
+        layer_stats.hits = layer_stats.hits + 1
+    else
+        local surface = cairo.ImageSurface(cairo.Format.ARGB32, width, height)
+        local bytes = width * height * 4
+        layers[self] = nil
+        evict_layers(bytes)
+        if bytes > hierarchy.layer_cache_limit then
+            return nil
+        end
+
+        local cr = cairo.Context(surface)
+        cr:translate(-x1, -y1)
+        draw_content(self, context, cr, self:get_widget())
+        surface:flush()
+
+        layer = {
+            surface = surface,
+            bytes = bytes,
+            x = x1, y = y1,
+            width = width, height = height,
+            dpi = context.dpi,
+        }
+        layers[self] = layer
+        layer_stats.misses = layer_stats.misses + 1
+    end
+
+    layer_clock = layer_clock + 1
+    layer.last_used = layer_clock
+    return layer
+end
+
 --- Draw a hierarchy to some cairo context.
 -- This function draws the widgets in this widget hierarchy to the given cairo
 -- context. The context's clip is used to skip parts that aren't visible.
@@ -317,41 +460,27 @@ function hierarchy:draw(context, cr)
     -- Draw if needed
     if not empty_clip(cr) then
         local opacity = widget:get_opacity()
-        local function call(func, extra_arg1, extra_arg2)
-            if not func then return end
-            if not extra_arg2 then
-                protected_call(func, widget, context, cr, self:get_size())
-            else
-                protected_call(func, widget, context, extra_arg1, extra_arg2, cr, self:get_size())
-            end
-        end
+        local layer = widget._private.cacheable and get_layer(self, context)
 
-        -- Prepare opacity handling
-        if opacity ~= 1 then
-            cr:push_group()
-        end
-
-        -- Draw the widget
-        cr:save()
-        cr:rectangle(0, 0, self:get_size())
-        cr:clip()
-        call(widget.draw)
-        cr:restore()
-
-        -- Draw its children (We already clipped to the draw extents above)
-        call(widget.before_draw_children)
-        for i, wi in ipairs(self:get_children()) do
-            call(widget.before_draw_child, i, wi:get_widget())
-            wi:draw(context, cr)
-            call(widget.after_draw_child, i, wi:get_widget())
-        end
-        call(widget.after_draw_children)
-
-        -- Apply opacity
-        if opacity ~= 1 then
-            cr:pop_group_to_source()
+        if layer then
+            -- Reuse what the widget drew before
+            cr:set_source_surface(layer.surface, layer.x, layer.y)
             cr.operator = cairo.Operator.OVER
             cr:paint_with_alpha(opacity)
+        else
+            -- Prepare opacity handling
+            if opacity ~= 1 then
+                cr:push_group()
+            end
+
+            draw_content(self, context, cr, widget)
+
+            -- Apply opacity
+            if opacity ~= 1 then
+                cr:pop_group_to_source()
+                cr.operator = cairo.Operator.OVER
+                cr:paint_with_alpha(opacity)
+            end
         end
     end
 
@@ -68,6 +68,29 @@ function base.widget:get_opacity()
     return self._private.opacity
 end
 
+--- Set whether the widget's drawing may be cached.
+-- A cacheable widget is drawn together with its children into an offscreen
+-- surface, which is reused until the widget or one of its children emits
+-- `widget::redraw_needed` or the layout changes. Only enable this for widgets
+-- that draw the same thing until they request a redraw and that only draw
+-- with the default `OVER` operator.
+-- @tparam boolean b Whether the widget may be cached.
+-- @see wibox.hierarchy.layer_cache_limit
+-- @function set_cacheable
+function base.widget:set_cacheable(b)
+    if b ~= self._private.cacheable then
+        self._private.cacheable = b
+        self:emit_signal("widget::redraw_needed")
+    end
+end
+
+--- Is the widget's drawing cached?
+-- @treturn boolean
+-- @function get_cacheable
+function base.widget:get_cacheable()
+    return self._private.cacheable or false
+end
+
 --- Set the widget's forced width.
 -- @tparam[opt] number width With `nil` the default mechanism of calling the
 --   `:fit` method is used.
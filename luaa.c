@@ -45,6 +45,9 @@
 #include "common/version.h"
 #include "config.h"
 #include "event.h"
+#include "ewmh.h"
+#include "fuzzy.h"
+#include "mouse.h"
 #include "objects/client.h"
 #include "objects/drawable.h"
 #include "objects/drawin.h"
@@ -54,9 +57,12 @@
 #include "objects/selection_transfer.h"
 #include "objects/selection_watcher.h"
 #include "objects/tag.h"
+#include "profile.h"
 #include "property.h"
+#include "sampler.h"
 #include "selection.h"
 #include "spawn.h"
+#include "stack.h"
 #include "systray.h"
 #include "xkb.h"
 #include "xrdb.h"
@@ -75,9 +81,11 @@
 #ifdef WITH_DBUS
 extern const struct luaL_Reg awesome_dbus_lib[];
 #endif
+extern const struct luaL_Reg awesome_fuzzy_lib[];
 extern const struct luaL_Reg awesome_keygrabber_lib[];
 extern const struct luaL_Reg awesome_mousegrabber_lib[];
 extern const struct luaL_Reg awesome_root_lib[];
+extern const struct luaL_Reg awesome_sampler_lib[];
 extern const struct luaL_Reg awesome_mouse_methods[];
 extern const struct luaL_Reg awesome_mouse_meta[];
 
@@ -129,6 +137,14 @@ extern const struct luaL_Reg awesome_mouse_meta[];
  * @signal wallpaper_changed
  */
 
+/** A wallpaper requested with `root.wallpaper_async` was set or failed.
+ *
+ * @tparam integer id The id returned by `root.wallpaper_async`.
+ * @tparam boolean success Whether the wallpaper was changed.
+ * @tparam[opt] string error Why the request failed.
+ * @signal wallpaper_ready
+ */
+
 /** Keyboard map has changed.
  *
  * This signal is sent after the new keymap has been loaded. It is used in
@@ -286,6 +302,92 @@ luaA_sync(lua_State *L)
     return 0;
 }
 
+/** Get statistics about awesome's internals. This is meant for debugging and
+ * for benchmarks; the contents of the table may change between versions.
+ *
+ * The table has the following fields:
+ *
+ * * *stack*: `restacks` (number of restacks done), `requests` (number of X11
+ *   requests sent for restacking in total), `last_requests` (number of X11
+ *   requests sent during the last restack) and `last_windows` (number of
+ *   windows that the last restack had to order).
+ * * *property*: `notifies` (number of PropertyNotify events for client
+ *   properties), `coalesced` (how many of them were merged into an update
+ *   that was already pending), `fetched` (number of properties requested from
+ *   the X server) and `batches` (number of batches these requests were sent
+ *   in).
+ * * *icon*: `lookups` (number of `_NET_WM_ICON` images that were converted or
+ *   looked up), `hits` (how many of them were already in the icon cache),
+ *   `entries` (number of distinct icons in use) and `bytes` (memory used by
+ *   their pixels, including a copy of the raw data to check hits against).
+ * * *sampler*: `ticks` (number of samples taken), `reads` (number of files in
+ *   `/proc` and `/sys` read for them) and `subscribers` (number of active
+ *   subscriptions).
+ * * *fuzzy*: `searches` (number of searches in `fuzzy` indices), `results`
+ *   (number of results they returned) and `rescans` (number of directories
+ *   read for indices of executables).
+ * * *refresh*: `refreshes` (number of main loop iterations that applied
+ *   pending changes), `clients` and `drawins` (number of objects these
+ *   refreshes had to look at because something about them changed) and
+ *   `last_clients` and `last_drawins` (the same for the last refresh).
+ * * *events*: `drains` (number of batches of X11 events handled together),
+ *   `events` (number of events in them) and `configure_requests` (number of
+ *   ConfigureRequests that were merged into a later one for the same window).
+ * * *expose*: `events` (number of Expose events for clients and drawins) and
+ *   `copies` (number of CopyArea requests sent to repaint the exposed areas).
+ * * *pointer*: `queries` (number of QueryPointer requests sent for
+ *   `mouse.screen`, `mouse.coords` and `mouse.object_under_pointer`) and
+ *   `cached` (number of such reads answered from the pointer position tracked
+ *   from events instead).
+ * * *mainloop*: `mode` (see `awesome.set_profile_mode`) and the tables
+ *   `phases`, `sections` and `callbacks`. `phases` has the durations of whole
+ *   main loop `iteration`s (without sleeping), X11 `events` handling, GLib
+ *   `sources` (timers, D-Bus, spawn IO, ...), the part of those spent in
+ *   `dbus` message handlers and `spawn` output and exit callbacks, and the
+ *   stages of each refresh: `property`, `refresh` (the Lua signal handlers),
+ *   `drawins`, `clients`, `banning`, `stack` and `destroy`. `sections` has times reported with
+ *   `awesome.profile_record`, for example `delayed_calls` and `timers`.
+ *   `callbacks` has the times of Lua functions called from C by where they
+ *   are defined, but only in detailed mode. Each entry has `count`, `total`
+ *   and `max` (in seconds) and a `histogram` where `histogram[i]` counts the
+ *   durations below 2^(i-1) microseconds that are not in an earlier bucket.
+ * * *startup*: `windows` (number of windows that already existed and were
+ *   managed at startup), `time` (seconds that took) and
+ *   `estimated_round_trips` (the round trips to the X server needed for it,
+ *   as counted from where the code waits for replies, not measured).
+ *
+ * @treturn table A table with statistics.
+ * @function stats
+ */
+static int
+luaA_awesome_stats(lua_State *L)
+{
+    lua_newtable(L);
+    stack_push_stats(L);
+    lua_setfield(L, -2, "stack");
+    property_push_stats(L);
+    lua_setfield(L, -2, "property");
+    ewmh_icon_push_stats(L);
+    lua_setfield(L, -2, "icon");
+    sampler_push_stats(L);
+    lua_setfield(L, -2, "sampler");
+    fuzzy_push_stats(L);
+    lua_setfield(L, -2, "fuzzy");
+    event_push_refresh_stats(L);
+    lua_setfield(L, -2, "refresh");
+    event_push_stats(L);
+    lua_setfield(L, -2, "events");
+    window_push_expose_stats(L);
+    lua_setfield(L, -2, "expose");
+    mouse_push_stats(L);
+    lua_setfield(L, -2, "pointer");
+    profile_push_stats(L);
+    lua_setfield(L, -2, "mainloop");
+    awesome_push_startup_stats(L);
+    lua_setfield(L, -2, "startup");
+    return 1;
+}
+
 /** Translate a GdkPixbuf to a cairo image surface..
  *
  * @param pixbuf The pixbuf as a light user datum.
@@ -970,6 +1072,10 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
         { "xrdb_get_value", luaA_xrdb_get_value},
         { "kill", luaA_kill},
         { "sync", luaA_sync},
+        { "stats", luaA_awesome_stats},
+        { "set_profile_mode", luaA_set_profile_mode },
+        { "profile_record", luaA_profile_record },
+        { "profile_reset", luaA_profile_reset },
         { NULL, NULL }
     };
 
@@ -1009,6 +1115,14 @@ luaA_init(xdgHandle* xdg, string_array_t *searchpath)
     luaA_registerlib(L, "mousegrabber", awesome_mousegrabber_lib);
     lua_pop(L, 1); /* luaA_registerlib() leaves the table on stack */
 
+    /* Export sampler lib */
+    luaA_registerlib(L, "sampler", awesome_sampler_lib);
+    lua_pop(L, 1); /* luaA_registerlib() leaves the table on stack */
+
+    /* Export fuzzy lib */
+    luaA_registerlib(L, "fuzzy", awesome_fuzzy_lib);
+    lua_pop(L, 1); /* luaA_registerlib() leaves the table on stack */
+
     /* Export mouse */
     luaA_openlib(L, "mouse", awesome_mouse_methods, awesome_mouse_meta);
 
@@ -70,9 +70,39 @@
 #include "objects/drawin.h"
 #include "objects/screen.h"
 
+#include <xcb/xcb_event.h>
+
 static int miss_index_handler    = LUA_REFNIL;
 static int miss_newindex_handler = LUA_REFNIL;
 
+/** What we know about the pointer without asking the X server */
+typedef enum
+{
+    /** Nothing, the pointer has to be queried */
+    POINTER_UNKNOWN,
+    /** Position and buttons are exact: The pointer is in a window which
+     * reports all motion to us */
+    POINTER_EXACT,
+    /** The pointer is somewhere inside of a client's window, the position is
+     * where it was last seen */
+    POINTER_IN_CLIENT
+} pointer_state_t;
+
+/** The pointer state tracked from the events we receive anyway */
+static struct
+{
+    pointer_state_t state;
+    int16_t x, y;
+    uint16_t mask;
+    /** The client for POINTER_IN_CLIENT */
+    client_t *client;
+    /** Will the root window report the next motion with a hint event? */
+    bool root_hint_armed;
+    /** Number of QueryPointer requests sent and number of reads answered
+     * from the tracked state instead */
+    unsigned long queries, cached;
+} pointer;
+
 /**
  * The `screen` under the cursor
  * @property screen
@@ -115,6 +145,158 @@ mouse_query_pointer(xcb_window_t window, int16_t *x, int16_t *y, xcb_window_t *c
     return true;
 }
 
+/** Update the tracked pointer state.
+ * \param window The window the pointer was seen in.
+ * \param child The child of window that contains the pointer, or XCB_NONE.
+ * \param x The pointer's x coordinate relative to the root window.
+ * \param y The pointer's y coordinate relative to the root window.
+ * \param mask The buttons state.
+ */
+static void
+mouse_track(xcb_window_t window, xcb_window_t child, int16_t x, int16_t y, uint16_t mask)
+{
+    client_t *c;
+
+    pointer.x = x;
+    pointer.y = y;
+    pointer.mask = mask;
+    pointer.client = NULL;
+    pointer.state = POINTER_UNKNOWN;
+
+    if(window == globalconf.screen->root && child != XCB_NONE)
+    {
+        /* Only the top-level window is known, so we do not know if the
+         * pointer is on a titlebar or inside the client */
+        if(drawin_getbywin(child))
+            pointer.state = POINTER_EXACT;
+        else if((c = client_getbyframewin(child)))
+        {
+            pointer.state = POINTER_IN_CLIENT;
+            pointer.client = c;
+        }
+    }
+    else if(window == globalconf.screen->root)
+    {
+        /* Motion on the root window is only reported with a hint, and only
+         * if we asked for the pointer since the last hint. */
+        if(pointer.root_hint_armed)
+            pointer.state = POINTER_EXACT;
+    }
+    else if(drawin_getbywin(window))
+    {
+        /* Children of drawins are systray icons */
+        if(child == XCB_NONE)
+            pointer.state = POINTER_EXACT;
+    }
+    else if((c = client_getbyframewin(window)))
+    {
+        /* The frame reports motion over titlebars and borders, but not inside
+         * of the client window */
+        if(child == XCB_NONE)
+            pointer.state = POINTER_EXACT;
+        else
+        {
+            pointer.state = POINTER_IN_CLIENT;
+            pointer.client = c;
+        }
+    }
+    else if((c = client_getbywin(window)))
+    {
+        pointer.state = POINTER_IN_CLIENT;
+        pointer.client = c;
+    }
+}
+
+/** Keep the tracked pointer state current. This has to see all events, even
+ * those that are otherwise ignored.
+ * \param event The event.
+ */
+void
+mouse_track_event(xcb_generic_event_t *event)
+{
+    switch(XCB_EVENT_RESPONSE_TYPE(event))
+    {
+      case XCB_MOTION_NOTIFY:
+        {
+            xcb_motion_notify_event_t *ev = (void *) event;
+            if(ev->detail == XCB_MOTION_HINT)
+            {
+                /* The pointer moves over the root window */
+                pointer.root_hint_armed = false;
+                pointer.state = POINTER_UNKNOWN;
+            }
+            else if(!ev->same_screen)
+                pointer.state = POINTER_UNKNOWN;
+            else
+                mouse_track(ev->event, ev->child, ev->root_x, ev->root_y, ev->state);
+        }
+        break;
+      case XCB_BUTTON_PRESS:
+      case XCB_BUTTON_RELEASE:
+        {
+            xcb_button_press_event_t *ev = (void *) event;
+            /* ev->state is the state before the event. Only buttons 1 to 5
+             * have a bit in it; other buttons do not change it. */
+            uint16_t state = ev->state;
+            if(ev->detail >= 1 && ev->detail <= 5)
+            {
+                uint16_t change = XCB_BUTTON_MASK_1 << (ev->detail - 1);
+                if(XCB_EVENT_RESPONSE_TYPE(ev) == XCB_BUTTON_PRESS)
+                    state |= change;
+                else
+                    state &= ~change;
+            }
+            if(!ev->same_screen)
+                pointer.state = POINTER_UNKNOWN;
+            else
+                mouse_track(ev->event, ev->child, ev->root_x, ev->root_y, state);
+        }
+        break;
+      case XCB_ENTER_NOTIFY:
+      case XCB_LEAVE_NOTIFY:
+        {
+            xcb_enter_notify_event_t *ev = (void *) event;
+            /* During a grab by someone else, we do not see any motion. When
+             * leaving a window, the pointer is now somewhere else; the enter
+             * event for that window follows. */
+            if(ev->mode == XCB_NOTIFY_MODE_GRAB
+               /* Bit 1 is same-screen, bit 0 is focus */
+               || !(ev->same_screen_focus & 0x02)
+               || (XCB_EVENT_RESPONSE_TYPE(ev) == XCB_LEAVE_NOTIFY
+                   && ev->detail != XCB_NOTIFY_DETAIL_INFERIOR))
+                pointer.state = POINTER_UNKNOWN;
+            else
+                mouse_track(ev->event, ev->child, ev->root_x, ev->root_y, ev->state);
+        }
+        break;
+    }
+}
+
+/** Forget about a client that the pointer might be in.
+ * \param c The client that is going away.
+ */
+void
+mouse_forget_client(client_t *c)
+{
+    if(pointer.client == c)
+    {
+        pointer.client = NULL;
+        pointer.state = POINTER_UNKNOWN;
+    }
+}
+
+/** Forget where the pointer is if it is in a client that is being moved.
+ * The client's geometry changes right away, but the pointer stays where the
+ * client was until the server applied the move and sent crossing events.
+ * \param c The client that is being moved or resized.
+ */
+void
+mouse_client_moved(client_t *c)
+{
+    if(pointer.state == POINTER_IN_CLIENT && pointer.client == c)
+        pointer.state = POINTER_UNKNOWN;
+}
+
 /** Get the pointer position on the screen.
  * \param x This will be set to the Pointer-x-coordinate relative to window.
  * \param y This will be set to the Pointer-y-coordinate relative to window.
@@ -126,8 +308,76 @@ static bool
 mouse_query_pointer_root(int16_t *x, int16_t *y, xcb_window_t *child, uint16_t *mask)
 {
     xcb_window_t root = globalconf.screen->root;
+    xcb_window_t child_window;
+    uint16_t mask_state;
+
+    pointer.queries++;
+    if(!mouse_query_pointer(root, x, y, &child_window, &mask_state))
+    {
+        pointer.state = POINTER_UNKNOWN;
+        return false;
+    }
+
+    /* QueryPointer re-enables motion hints on the root window */
+    pointer.root_hint_armed = true;
+    mouse_track(root, child_window, *x, *y, mask_state);
+
+    if(child)
+        *child = child_window;
+    if(mask)
+        *mask = mask_state;
+    return true;
+}
+
+/** Get the pointer position on the screen, from the tracked state if it is
+ * exact.
+ * \param x This will be set to the Pointer-x-coordinate.
+ * \param y This will be set to the Pointer-y-coordinate.
+ * \param mask This will be set to the current buttons state.
+ * \return True on success, false if an error occurred.
+ */
+static bool
+mouse_get_pointer(int16_t *x, int16_t *y, uint16_t *mask)
+{
+    if(pointer.state != POINTER_EXACT)
+        return mouse_query_pointer_root(x, y, NULL, mask);
 
-    return mouse_query_pointer(root, x, y, child, mask);
+    pointer.cached++;
+    *x = pointer.x;
+    *y = pointer.y;
+    if(mask)
+        *mask = pointer.mask;
+    return true;
+}
+
+/** Get the screen containing the pointer from the tracked state.
+ * \return The screen or NULL if the pointer has to be queried.
+ */
+static screen_t *
+mouse_get_cached_screen(void)
+{
+    if(pointer.state == POINTER_EXACT)
+    {
+        pointer.cached++;
+        return screen_getbycoord(pointer.x, pointer.y);
+    }
+
+    if(pointer.state == POINTER_IN_CLIENT)
+    {
+        /* The pointer is somewhere in the client. If that is completely on one
+         * screen, the pointer is on it, too. */
+        area_t geom = pointer.client->geometry;
+        int x2 = geom.x + geom.width - 1, y2 = geom.y + geom.height - 1;
+        screen_t *s = screen_getbycoord(geom.x, geom.y);
+        if(screen_coord_in_screen(s, geom.x, geom.y) && screen_coord_in_screen(s, x2, y2)
+           && screen_getbycoord(x2, y2) == s)
+        {
+            pointer.cached++;
+            return s;
+        }
+    }
+
+    return NULL;
 }
 
 /** Set the pointer position.
@@ -164,6 +414,13 @@ luaA_mouse_index(lua_State *L)
             return luaA_default_index(L);
     }
 
+    screen_t *screen = mouse_get_cached_screen();
+    if (screen)
+    {
+        luaA_object_push(L, screen);
+        return 1;
+    }
+
     if (!mouse_query_pointer_root(&mouse_x, &mouse_y, NULL, NULL))
     {
         /* Nothing ever handles mouse.screen being nil. Lying is better than
@@ -201,6 +458,7 @@ luaA_mouse_newindex(lua_State *L)
 
     screen = luaA_checkscreen(L, 3);
     mouse_warp_pointer(globalconf.screen->root, screen->geometry.x, screen->geometry.y);
+    pointer.state = POINTER_UNKNOWN;
     return 0;
 }
 
@@ -248,7 +506,7 @@ luaA_mouse_coords(lua_State *L)
         luaA_checktable(L, 1);
         bool ignore_enter_notify = (lua_gettop(L) == 2 && luaA_checkboolean(L, 2));
 
-        if(!mouse_query_pointer_root(&mouse_x, &mouse_y, NULL, &mask))
+        if(!mouse_get_pointer(&mouse_x, &mouse_y, &mask))
             return 0;
 
         x = round(luaA_getopt_number_range(L, 1, "x", mouse_x, MIN_X11_COORDINATE, MAX_X11_COORDINATE));
@@ -258,6 +516,7 @@ luaA_mouse_coords(lua_State *L)
             client_ignore_enterleave_events();
 
         mouse_warp_pointer(globalconf.screen->root, x, y);
+        pointer.state = POINTER_UNKNOWN;
 
         if(ignore_enter_notify)
             client_restore_enterleave_events();
@@ -265,12 +524,43 @@ luaA_mouse_coords(lua_State *L)
         lua_pop(L, 1);
     }
 
-    if(!mouse_query_pointer_root(&mouse_x, &mouse_y, NULL, &mask))
+    if(!mouse_get_pointer(&mouse_x, &mouse_y, &mask))
         return 0;
 
     return luaA_mouse_pushstatus(L, mouse_x, mouse_y, mask);
 }
 
+/** Forget what is known about the pointer without asking the X server.
+ *
+ * `mouse.screen` and `mouse.coords` are answered from the events awesome
+ * receives when possible. After calling this function, the next access asks
+ * the X server instead. This is only needed if something else moved the
+ * pointer in a way awesome cannot notice.
+ *
+ * @function sync
+ */
+static int
+luaA_mouse_sync(lua_State *L)
+{
+    pointer.state = POINTER_UNKNOWN;
+    return 0;
+}
+
+/** Push statistics about the pointer tracking.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+mouse_push_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 2);
+    lua_pushinteger(L, pointer.queries);
+    lua_setfield(L, -2, "queries");
+    lua_pushinteger(L, pointer.cached);
+    lua_setfield(L, -2, "cached");
+    return 1;
+}
+
 /** Get the client or any object which is under the pointer.
  *
  * @treturn client.object|nil A client or nil.
@@ -320,6 +610,7 @@ const struct luaL_Reg awesome_mouse_methods[] =
     { "__index", luaA_mouse_index },
     { "__newindex", luaA_mouse_newindex },
     { "coords", luaA_mouse_coords },
+    { "sync", luaA_mouse_sync },
     { "object_under_pointer", luaA_mouse_object_under_pointer },
     { "set_index_miss_handler", luaA_mouse_set_index_miss_handler},
     { "set_newindex_miss_handler", luaA_mouse_set_newindex_miss_handler},
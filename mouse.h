@@ -26,8 +26,14 @@
 #include <xcb/xcb.h>
 #include <lua.h>
 
+typedef struct client_t client_t;
+
 bool mouse_query_pointer(xcb_window_t, int16_t *, int16_t *, xcb_window_t *, uint16_t *);
 int luaA_mouse_pushstatus(lua_State *, int, int, uint16_t);
+void mouse_track_event(xcb_generic_event_t *);
+void mouse_forget_client(client_t *);
+void mouse_client_moved(client_t *);
+int mouse_push_stats(lua_State *);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -89,9 +89,11 @@
 
 #include "objects/client.h"
 #include "common/atoms.h"
+#include "common/iconcache.h"
 #include "common/xutil.h"
 #include "event.h"
 #include "ewmh.h"
+#include "mouse.h"
 #include "objects/drawable.h"
 #include "objects/screen.h"
 #include "objects/tag.h"
@@ -415,6 +417,10 @@
  *     cr:set_source_surface(s, 0, 0)
  *     cr:paint()
  *
+ * Clients with the same icon share its surface inside of awesome. Lua always
+ * gets a copy of such a surface, so drawing on it does not change the icon of
+ * any client.
+ *
  * **Signal:**
  *
  *  * *property::icon*
@@ -955,6 +961,7 @@ typedef enum {
 static area_t titlebar_get_area(client_t *c, client_titlebar_t bar);
 static drawable_t *titlebar_get_drawable(lua_State *L, client_t *c, int cl_idx, client_titlebar_t bar);
 static void client_resize_do(client_t *c, area_t geometry);
+static void client_refresh_exposed(client_t *c);
 static void client_set_maximized_common(lua_State *L, int cidx, bool s, const char* type, const int val);
 
 /** Collect a client.
@@ -965,6 +972,8 @@ static void
 client_wipe(client_t *c)
 {
     key_array_wipe(&c->keys);
+    key_index_wipe(&c->keys_index);
+    tagset_array_wipe(&c->tags);
     xcb_icccm_get_wm_protocols_reply_wipe(&c->protocols);
     cairo_surface_array_wipe(&c->icons);
     p_delete(&c->machine);
@@ -1003,7 +1012,7 @@ client_set_urgent(lua_State *L, int cidx, bool urgent)
         if(c->prop != value) \
         { \
             c->prop = value; \
-            luaA_object_emit_signal(L, cidx, "property::" #prop, 0); \
+            luaA_object_emit_signal_id(L, cidx, SIGNAL_ID("property::" #prop), 0); \
         } \
     }
 DO_CLIENT_SET_PROPERTY(group_window)
@@ -1025,7 +1034,7 @@ DO_CLIENT_SET_PROPERTY(skip_taskbar)
         } \
         p_delete(&c->prop); \
         c->prop = value; \
-        luaA_object_emit_signal(L, cidx, "property::" #signal, 0); \
+        luaA_object_emit_signal_id(L, cidx, SIGNAL_ID("property::" #signal), 0); \
     }
 #define DO_CLIENT_SET_STRING_PROPERTY(prop) \
         DO_CLIENT_SET_STRING_PROPERTY2(prop, prop)
@@ -1101,11 +1110,7 @@ client_on_selected_tags(client_t *c)
     if(c->sticky)
         return true;
 
-    foreach(tag, globalconf.tags)
-        if(tag_get_selected(*tag) && is_client_tagged(c, *tag))
-            return true;
-
-    return false;
+    return tagset_intersects(&c->tags, &globalconf.selected_tags);
 }
 
 /** Get a client by its window.
@@ -1115,21 +1120,13 @@ client_on_selected_tags(client_t *c)
 client_t *
 client_getbywin(xcb_window_t w)
 {
-    foreach(c, globalconf.clients)
-        if((*c)->window == w)
-            return *c;
-
-    return NULL;
+    return windowindex_get(&globalconf.windows, w, WINDOW_ROLE_CLIENT);
 }
 
 client_t *
 client_getbynofocuswin(xcb_window_t w)
 {
-    foreach(c, globalconf.clients)
-        if((*c)->nofocus_window == w)
-            return *c;
-
-    return NULL;
+    return windowindex_get(&globalconf.windows, w, WINDOW_ROLE_NOFOCUS);
 }
 
 /** Get a client by its frame window.
@@ -1139,11 +1136,7 @@ client_getbynofocuswin(xcb_window_t w)
 client_t *
 client_getbyframewin(xcb_window_t w)
 {
-    foreach(c, globalconf.clients)
-        if((*c)->frame_window == w)
-            return *c;
-
-    return NULL;
+    return windowindex_get(&globalconf.windows, w, WINDOW_ROLE_FRAME);
 }
 
 /** Unfocus a client (internal).
@@ -1194,6 +1187,34 @@ void client_ban_unfocus(client_t *c)
         client_unfocus(c);
 }
 
+/** Update a client's entry in globalconf.client_areas. Only clients that are
+ * not banned, i.e. whose frame is mapped, are in there.
+ * \param c The client.
+ */
+static void
+client_areas_update(client_t *c)
+{
+    if(c->isbanned)
+        spatialindex_remove(&globalconf.client_areas, c);
+    else
+        spatialindex_set(&globalconf.client_areas, c,
+                         c->geometry.x, c->geometry.y,
+                         c->geometry.width, c->geometry.height);
+}
+
+/** Bring globalconf.client_areas up to date before answering a query from
+ * Lua. Geometry changes since the last refresh are still pending.
+ * \return False if banning is outdated as well; the caller has to look at all
+ * clients then.
+ */
+static bool
+client_areas_sync(void)
+{
+    foreach(c, globalconf.dirty.clients)
+        client_areas_update(*c);
+    return !globalconf.need_lazy_banning;
+}
+
 /** Ban client and move it out of the viewport.
  * \param c The client.
  */
@@ -1207,6 +1228,7 @@ client_ban(client_t *c)
         client_restore_enterleave_events();
 
         c->isbanned = true;
+        client_areas_update(c);
 
         client_ban_unfocus(c);
     }
@@ -1305,6 +1327,7 @@ client_get_nofocus_window(client_t *c)
                           0, NULL);
         xcb_map_window(globalconf.connection, c->nofocus_window);
         xwindow_grabkeys(c->nofocus_window, &c->keys);
+        windowindex_insert(&globalconf.windows, c->nofocus_window, WINDOW_ROLE_NOFOCUS, c);
     }
     return c->nofocus_window;
 }
@@ -1344,10 +1367,23 @@ client_focus_refresh(void)
     globalconf.focus.need_update = false;
 }
 
+/** Queue a client for the next refresh of geometries and borders.
+ * \param c The client.
+ */
+void
+client_need_refresh(client_t *c)
+{
+    /* Unmanaged clients have nothing left to refresh */
+    if(c->refresh_queued || c->window == XCB_NONE)
+        return;
+    c->refresh_queued = true;
+    client_array_append(&globalconf.dirty.clients, c);
+}
+
 static void
 client_border_refresh(void)
 {
-    foreach(c, globalconf.clients)
+    foreach(c, globalconf.dirty.clients)
         window_border_refresh((window_t *) *c);
 }
 
@@ -1355,10 +1391,12 @@ static void
 client_geometry_refresh(void)
 {
     bool ignored_enterleave = false;
-    foreach(_c, globalconf.clients)
+    foreach(_c, globalconf.dirty.clients)
     {
         client_t *c = *_c;
 
+        client_areas_update(c);
+
         /* Compute the client window's and frame window's geometry */
         area_t geometry = c->geometry;
         area_t real_geometry = c->geometry;
@@ -1435,6 +1473,17 @@ client_refresh(void)
 {
     client_geometry_refresh();
     client_border_refresh();
+
+    foreach(c, globalconf.dirty.clients)
+    {
+        if((*c)->exposed)
+            client_refresh_exposed(*c);
+        (*c)->refresh_queued = false;
+    }
+    globalconf.dirty.last_clients = globalconf.dirty.clients.len;
+    globalconf.dirty.visited_clients += globalconf.dirty.clients.len;
+    globalconf.dirty.clients.len = 0;
+
     client_focus_refresh();
 }
 
@@ -1473,72 +1522,138 @@ border_width_callback(client_t *c, uint16_t old_width, uint16_t new_width)
 }
 
 static void
-client_update_properties(lua_State *L, int cidx, client_t *c)
+client_update_properties(lua_State *L, int cidx, client_t *c, client_manage_cookies_t *cookies)
 {
-    /* get all hints */
-    xcb_get_property_cookie_t wm_normal_hints   = property_get_wm_normal_hints(c);
-    xcb_get_property_cookie_t wm_hints          = property_get_wm_hints(c);
-    xcb_get_property_cookie_t wm_transient_for  = property_get_wm_transient_for(c);
-    xcb_get_property_cookie_t wm_client_leader  = property_get_wm_client_leader(c);
-    xcb_get_property_cookie_t wm_client_machine = property_get_wm_client_machine(c);
-    xcb_get_property_cookie_t wm_window_role    = property_get_wm_window_role(c);
-    xcb_get_property_cookie_t net_wm_pid        = property_get_net_wm_pid(c);
-    xcb_get_property_cookie_t net_wm_icon       = property_get_net_wm_icon(c);
-    xcb_get_property_cookie_t wm_name           = property_get_wm_name(c);
-    xcb_get_property_cookie_t net_wm_name       = property_get_net_wm_name(c);
-    xcb_get_property_cookie_t wm_icon_name      = property_get_wm_icon_name(c);
-    xcb_get_property_cookie_t net_wm_icon_name  = property_get_net_wm_icon_name(c);
-    xcb_get_property_cookie_t wm_class          = property_get_wm_class(c);
-    xcb_get_property_cookie_t wm_protocols      = property_get_wm_protocols(c);
-    xcb_get_property_cookie_t motif_wm_hints    = property_get_motif_wm_hints(c);
-    xcb_get_property_cookie_t opacity           = xwindow_get_opacity_unchecked(c->window);
-
     /* update strut */
-    ewmh_process_client_strut(c);
+    ewmh_process_client_strut_reply(c, cookies->strut);
 
     /* Now process all replies */
-    property_update_wm_normal_hints(c, wm_normal_hints);
-    property_update_wm_hints(c, wm_hints);
-    property_update_wm_transient_for(c, wm_transient_for);
-    property_update_wm_client_leader(c, wm_client_leader);
-    property_update_wm_client_machine(c, wm_client_machine);
-    property_update_wm_window_role(c, wm_window_role);
-    property_update_net_wm_pid(c, net_wm_pid);
-    property_update_net_wm_icon(c, net_wm_icon);
-    property_update_wm_name(c, wm_name);
-    property_update_net_wm_name(c, net_wm_name);
-    property_update_wm_icon_name(c, wm_icon_name);
-    property_update_net_wm_icon_name(c, net_wm_icon_name);
-    property_update_wm_class(c, wm_class);
-    property_update_wm_protocols(c, wm_protocols);
-    property_update_motif_wm_hints(c, motif_wm_hints);
-    window_set_opacity(L, cidx, xwindow_get_opacity_from_cookie(opacity));
+    property_update_wm_normal_hints(c, cookies->wm_normal_hints);
+    property_update_wm_hints(c, cookies->wm_hints);
+    property_update_wm_transient_for(c, cookies->wm_transient_for);
+    property_update_wm_client_leader(c, cookies->wm_client_leader);
+    property_update_wm_client_machine(c, cookies->wm_client_machine);
+    property_update_wm_window_role(c, cookies->wm_window_role);
+    property_update_net_wm_pid(c, cookies->net_wm_pid);
+    property_update_net_wm_icon(c, cookies->net_wm_icon);
+    property_update_wm_name(c, cookies->wm_name);
+    property_update_net_wm_name(c, cookies->net_wm_name);
+    property_update_wm_icon_name(c, cookies->wm_icon_name);
+    property_update_net_wm_icon_name(c, cookies->net_wm_icon_name);
+    property_update_wm_class(c, cookies->wm_class);
+    property_update_wm_protocols(c, cookies->wm_protocols);
+    property_update_motif_wm_hints(c, cookies->motif_wm_hints);
+    window_set_opacity(L, cidx, xwindow_get_opacity_from_cookie(cookies->opacity));
+}
+
+/** Send all requests needed for managing a window, without waiting for any
+ * replies. This way, the requests for many windows can be sent before
+ * client_manage_prepared() waits for the first reply.
+ * \param w The window.
+ * \param cookies Filled with the pending requests.
+ */
+void
+client_manage_prepare(xcb_window_t w, client_manage_cookies_t *cookies)
+{
+    /* Select PropertyNotify before getting the properties, so that changes
+     * made until client_manage_prepared() selects the full event mask are not
+     * lost. The other events would be caused by the reparenting itself. */
+    xcb_change_window_attributes(globalconf.connection, w, XCB_CW_EVENT_MASK,
+                                 (const uint32_t []) { XCB_EVENT_MASK_PROPERTY_CHANGE });
+
+    cookies->kde_dockapp = systray_iskdedockapp_unchecked(w);
+    /* If this is a new client that just has been launched, then request its
+     * startup id. */
+    cookies->startup_id = xcb_get_property(globalconf.connection, false,
+                                           w, _NET_STARTUP_ID,
+                                           XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
+    cookies->strut = ewmh_client_strut_get_unchecked(w);
+
+    /* get all hints */
+    cookies->wm_normal_hints   = property_get_wm_normal_hints(w);
+    cookies->wm_hints          = property_get_wm_hints(w);
+    cookies->wm_transient_for  = property_get_wm_transient_for(w);
+    cookies->wm_client_leader  = property_get_wm_client_leader(w);
+    cookies->wm_client_machine = property_get_wm_client_machine(w);
+    cookies->wm_window_role    = property_get_wm_window_role(w);
+    cookies->net_wm_pid        = property_get_net_wm_pid(w);
+    cookies->net_wm_icon       = property_get_net_wm_icon(w);
+    cookies->wm_name           = property_get_wm_name(w);
+    cookies->net_wm_name       = property_get_net_wm_name(w);
+    cookies->wm_icon_name      = property_get_wm_icon_name(w);
+    cookies->net_wm_icon_name  = property_get_net_wm_icon_name(w);
+    cookies->wm_class          = property_get_wm_class(w);
+    cookies->wm_protocols      = property_get_wm_protocols(w);
+    cookies->motif_wm_hints    = property_get_motif_wm_hints(w);
+    cookies->opacity           = xwindow_get_opacity_unchecked(w);
+    cookies->ewmh_hints        = ewmh_client_get_hints_unchecked(w);
+
+    cookies->reparent.sequence = 0;
+    cookies->extra_round_trips = 0;
+}
+
+/** Throw away the replies for a window that we do not manage after all.
+ * \param cookies The pending requests.
+ */
+static void
+client_manage_discard(client_manage_cookies_t *cookies)
+{
+    xcb_get_property_cookie_t pending[] =
+    {
+        cookies->startup_id, cookies->strut,
+        cookies->wm_normal_hints, cookies->wm_hints, cookies->wm_transient_for,
+        cookies->wm_client_leader, cookies->wm_client_machine,
+        cookies->wm_window_role, cookies->net_wm_pid, cookies->net_wm_icon,
+        cookies->wm_name, cookies->net_wm_name, cookies->wm_icon_name,
+        cookies->net_wm_icon_name, cookies->wm_class, cookies->wm_protocols,
+        cookies->motif_wm_hints, cookies->opacity,
+        cookies->ewmh_hints.desktop, cookies->ewmh_hints.state,
+        cookies->ewmh_hints.window_type
+    };
+
+    for(int i = 0; i < countof(pending); i++)
+        xcb_discard_reply(globalconf.connection, pending[i].sequence);
 }
 
 /** Manage a new client.
  * \param w The window.
  * \param wgeom Window geometry.
- * \param startup True if we are managing at startup time.
+ * \param wattr Window attributes.
  */
 void
 client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_attributes_reply_t *wattr)
 {
-    xcb_void_cookie_t reparent_cookie;
+    client_manage_cookies_t cookies;
+
+    client_manage_prepare(w, &cookies);
+    client_t *c = client_manage_prepared(w, wgeom, wattr, &cookies);
+    if(c)
+        client_manage_check(c, &cookies);
+}
+
+/** Manage a new client whose requests were sent by client_manage_prepare().
+ * client_manage_check() has to be called afterwards.
+ * \param w The window.
+ * \param wgeom Window geometry.
+ * \param wattr Window attributes.
+ * \param cookies The pending requests.
+ * \return The new client, or NULL if the window is not managed as a client.
+ */
+client_t *
+client_manage_prepared(xcb_window_t w, xcb_get_geometry_reply_t *wgeom,
+                       xcb_get_window_attributes_reply_t *wattr,
+                       client_manage_cookies_t *cookies)
+{
     lua_State *L = globalconf_get_lua_State();
     const uint32_t select_input_val[] = { CLIENT_SELECT_INPUT_EVENT_MASK };
 
-    if(systray_iskdedockapp(w))
+    if(systray_iskdedockapp_reply(cookies->kde_dockapp))
     {
+        client_manage_discard(cookies);
         systray_request_handle(w);
-        return;
+        return NULL;
     }
 
-    /* If this is a new client that just has been launched, then request its
-     * startup id. */
-    xcb_get_property_cookie_t startup_id_q = xcb_get_property(globalconf.connection, false,
-                                                              w, _NET_STARTUP_ID,
-                                                              XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
-
     /* Make sure the window is automatically mapped if awesome exits or dies. */
     xcb_change_save_set(globalconf.connection, XCB_SET_MODE_INSERT, w);
     if (globalconf.have_shape)
@@ -1547,6 +1662,7 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     client_t *c = client_new(L);
     xcb_screen_t *s = globalconf.screen;
     c->border_width_callback = (void (*) (void *, uint16_t, uint16_t)) border_width_callback;
+    c->need_refresh_callback = (void (*) (void *)) client_need_refresh;
 
     /* consider the window banned */
     c->isbanned = true;
@@ -1581,7 +1697,7 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
                                  globalconf.screen->root,
                                  XCB_CW_EVENT_MASK,
                                  no_event);
-    reparent_cookie = xcb_reparent_window_checked(globalconf.connection, w, c->frame_window, 0, 0);
+    cookies->reparent = xcb_reparent_window_checked(globalconf.connection, w, c->frame_window, 0, 0);
     xcb_map_window(globalconf.connection, w);
     xcb_change_window_attributes(globalconf.connection,
                                  globalconf.screen->root,
@@ -1609,6 +1725,8 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     /* Duplicate client and push it in client list */
     lua_pushvalue(L, -1);
     client_array_push(&globalconf.clients, luaA_object_ref(L, -1));
+    windowindex_insert(&globalconf.windows, c->window, WINDOW_ROLE_CLIENT, c);
+    windowindex_insert(&globalconf.windows, c->frame_window, WINDOW_ROLE_FRAME, c);
 
     /* Set the right screen */
     screen_client_moveto(c, screen_getbycoord(wgeom->x, wgeom->y), false);
@@ -1620,13 +1738,14 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     c->geometry.y = wgeom->y;
     c->geometry.width = wgeom->width;
     c->geometry.height = wgeom->height;
+    client_need_refresh(c);
 
-    luaA_object_emit_signal(L, -1, "property::x", 0);
-    luaA_object_emit_signal(L, -1, "property::y", 0);
-    luaA_object_emit_signal(L, -1, "property::width", 0);
-    luaA_object_emit_signal(L, -1, "property::height", 0);
+    luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::x"), 0);
+    luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::y"), 0);
+    luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::width"), 0);
+    luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::height"), 0);
     luaA_object_emit_signal(L, -1, "property::window", 0);
-    luaA_object_emit_signal(L, -1, "property::geometry", 0);
+    luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::geometry"), 0);
 
     /* Set border width */
     window_set_border_width(L, -1, wgeom->border_width);
@@ -1636,7 +1755,7 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     luaA_object_emit_signal(L, -1, "property::size_hints_honor", 0);
 
     /* update all properties */
-    client_update_properties(L, -1, c);
+    client_update_properties(L, -1, c, cookies);
 
     /* check if this is a TRANSIENT_FOR of another client */
     foreach(oc, globalconf.clients)
@@ -1647,24 +1766,26 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     xwindow_set_state(c->window, XCB_ICCCM_WM_STATE_NORMAL);
 
     /* Then check clients hints */
-    ewmh_client_check_hints(c);
+    ewmh_client_check_hints(c, cookies->ewmh_hints);
 
     /* Push client in stack */
     stack_client_push(c);
 
     /* Request our response */
     xcb_get_property_reply_t *reply =
-        xcb_get_property_reply(globalconf.connection, startup_id_q, NULL);
+        xcb_get_property_reply(globalconf.connection, cookies->startup_id, NULL);
     /* Say spawn that a client has been started, with startup id as argument */
     char *startup_id = xutil_get_text_property_from_reply(reply);
     p_delete(&reply);
 
     if (startup_id == NULL && c->leader_window != XCB_NONE) {
         /* GTK hides this property elsewhere. No idea why. */
-        startup_id_q = xcb_get_property(globalconf.connection, false,
-                                        c->leader_window, _NET_STARTUP_ID,
-                                        XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
+        xcb_get_property_cookie_t startup_id_q =
+            xcb_get_property(globalconf.connection, false,
+                             c->leader_window, _NET_STARTUP_ID,
+                             XCB_GET_PROPERTY_TYPE_ANY, 0, UINT_MAX);
         reply = xcb_get_property_reply(globalconf.connection, startup_id_q, NULL);
+        cookies->extra_round_trips++;
         startup_id = xutil_get_text_property_from_reply(reply);
         p_delete(&reply);
     }
@@ -1677,17 +1798,29 @@ client_manage(xcb_window_t w, xcb_get_geometry_reply_t *wgeom, xcb_get_window_at
     /* client is still on top of the stack; emit signal */
     luaA_object_emit_signal(L, -1, "manage", 0);
 
-    xcb_generic_error_t *error = xcb_request_check(globalconf.connection, reparent_cookie);
+    /* pop client */
+    lua_pop(L, 1);
+
+    return c;
+}
+
+/** Check if reparenting a newly managed client worked and unmanage it if not.
+ * \param c The client returned by client_manage_prepared().
+ * \param cookies The requests that were used for managing the client.
+ */
+void
+client_manage_check(client_t *c, client_manage_cookies_t *cookies)
+{
+    xcb_generic_error_t *error = xcb_request_check(globalconf.connection, cookies->reparent);
     if (error != NULL) {
         warn("Failed to manage window with name '%s', class '%s', instance '%s', because reparenting failed.",
                 NONULL(c->name), NONULL(c->class), NONULL(c->instance));
         event_handle((xcb_generic_event_t *) error);
         p_delete(&error);
-        client_unmanage(c, true);
+        /* Lua might have unmanaged the client already */
+        if(c->window != XCB_NONE)
+            client_unmanage(c, true);
     }
-
-    /* pop client */
-    lua_pop(L, 1);
 }
 
 static void
@@ -1841,25 +1974,28 @@ client_resize_do(client_t *c, area_t geometry)
     /* Also store geometry including border */
     area_t old_geometry = c->geometry;
     c->geometry = geometry;
+    client_need_refresh(c);
+    if(!AREA_EQUAL(old_geometry, geometry))
+        mouse_client_moved(c);
 
     luaA_object_push(L, c);
     if (!AREA_EQUAL(old_geometry, geometry))
-        luaA_object_emit_signal(L, -1, "property::geometry", 0);
+        luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::geometry"), 0);
     if (old_geometry.x != geometry.x || old_geometry.y != geometry.y)
     {
-        luaA_object_emit_signal(L, -1, "property::position", 0);
+        luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::position"), 0);
         if (old_geometry.x != geometry.x)
-            luaA_object_emit_signal(L, -1, "property::x", 0);
+            luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::x"), 0);
         else
-            luaA_object_emit_signal(L, -1, "property::y", 0);
+            luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::y"), 0);
     }
     if (old_geometry.width != geometry.width || old_geometry.height != geometry.height)
     {
-        luaA_object_emit_signal(L, -1, "property::size", 0);
+        luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::size"), 0);
         if (old_geometry.width != geometry.width)
-            luaA_object_emit_signal(L, -1, "property::width", 0);
+            luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::width"), 0);
         else
-            luaA_object_emit_signal(L, -1, "property::height", 0);
+            luaA_object_emit_signal_id(L, -1, SIGNAL_ID("property::height"), 0);
     }
     lua_pop(L, 1);
 
@@ -2279,6 +2415,7 @@ client_unban(client_t *c)
         client_restore_enterleave_events();
 
         c->isbanned = false;
+        client_areas_update(c);
 
         /* An unbanned client shouldn't be minimized or hidden */
         luaA_object_push(L, c);
@@ -2318,7 +2455,12 @@ client_unmanage(client_t *c, bool window_valid)
             client_array_remove(&globalconf.clients, elem);
             break;
         }
+    windowindex_remove(&globalconf.windows, c->window);
+    windowindex_remove(&globalconf.windows, c->frame_window);
+    windowindex_remove(&globalconf.windows, c->nofocus_window);
+    spatialindex_remove(&globalconf.client_areas, c);
     stack_client_remove(c);
+    mouse_forget_client(c);
     for(int i = 0; i < globalconf.tags.len; i++)
         untag_client(c, globalconf.tags.tab[i]);
 
@@ -2389,6 +2531,17 @@ client_unmanage(client_t *c, bool window_valid)
     /* set client as invalid */
     c->window = XCB_NONE;
 
+    if(c->refresh_queued)
+    {
+        foreach(elem, globalconf.dirty.clients)
+            if(*elem == c)
+            {
+                client_array_remove(&globalconf.dirty.clients, elem);
+                break;
+            }
+        c->refresh_queued = false;
+    }
+
     luaA_object_unref(L, c);
 }
 
@@ -2464,6 +2617,147 @@ luaA_client_get(lua_State *L)
     return 1;
 }
 
+/** Get the topmost visible client at a position.
+ *
+ * @tparam integer x The X coordinate.
+ * @tparam integer y The Y coordinate.
+ * @treturn client|nil The topmost visible client whose frame contains the
+ *   point, if any.
+ * @function at
+ */
+static int
+luaA_client_at(lua_State *L)
+{
+    int x = luaL_checkinteger(L, 1);
+    int y = luaL_checkinteger(L, 2);
+    client_t *top = NULL;
+
+    if(client_areas_sync())
+    {
+        spatialindex_cell_array_t *cell = spatialindex_cell(&globalconf.client_areas, x, y);
+        if(cell)
+            foreach(item, *cell)
+            {
+                client_t *c = (*item)->object;
+                if(spatialindex_item_contains(*item, x, y) && client_isvisible(c)
+                   && (!top || c->stack_position > top->stack_position))
+                    top = c;
+            }
+    }
+    else
+        /* Banning is outdated, so the stack tells what will be on top */
+        foreach_reverse(_c, globalconf.stack)
+        {
+            client_t *c = *_c;
+            if(client_isvisible(c)
+               && x >= c->geometry.x && x < c->geometry.x + c->geometry.width
+               && y >= c->geometry.y && y < c->geometry.y + c->geometry.height)
+            {
+                top = c;
+                break;
+            }
+        }
+
+    if(!top)
+        return 0;
+    luaA_object_push(L, top);
+    return 1;
+}
+
+typedef struct
+{
+    client_t *source;
+    screen_t *screen;
+} client_in_direction_filter_t;
+
+static bool
+client_in_direction_filter(void *object, void *data)
+{
+    client_t *c = object;
+    client_in_direction_filter_t *filter = data;
+    return c != filter->source && client_isvisible(c)
+        && (!filter->screen || c->screen == filter->screen);
+}
+
+/** Of two clients at the same distance, prefer the one that comes first in
+ * the client list, like gears.geometry.rectangle.get_in_direction() does with
+ * client.get().
+ */
+static bool
+client_in_direction_before(void *object, void *other, void *data)
+{
+    foreach(c, globalconf.clients)
+        if(*c == object || *c == other)
+            return *c == object;
+    return false;
+}
+
+/** Get the nearest visible client in a direction.
+ *
+ * This uses the same rules as `gears.geometry.rectangle.get_in_direction`.
+ *
+ * @tparam client|table source The client to start from or a geometry table.
+ * @tparam string dir The direction, can be either *up*, *down*, *left* or
+ *   *right*.
+ * @tparam[opt] screen screen Only consider clients on this screen.
+ * @treturn client|nil The nearest client in that direction, if any.
+ * @function in_direction
+ */
+static int
+luaA_client_in_direction(lua_State *L)
+{
+    static const char *const directions[] = { "up", "down", "left", "right", NULL };
+    client_in_direction_filter_t filter = { NULL, NULL };
+    area_t geometry;
+
+    if(lua_istable(L, 1))
+    {
+        geometry.x = round(luaA_getopt_number(L, 1, "x", 0));
+        geometry.y = round(luaA_getopt_number(L, 1, "y", 0));
+        geometry.width = ceil(luaA_getopt_number(L, 1, "width", 0));
+        geometry.height = ceil(luaA_getopt_number(L, 1, "height", 0));
+    }
+    else
+    {
+        filter.source = luaA_checkudata(L, 1, &client_class);
+        geometry = filter.source->geometry;
+    }
+
+    spatialindex_direction_t dir = luaL_checkoption(L, 2, NULL, directions);
+
+    if(!lua_isnoneornil(L, 3))
+        filter.screen = luaA_checkscreen(L, 3);
+
+    client_t *target;
+    if(client_areas_sync())
+        target = spatialindex_in_direction(&globalconf.client_areas, dir,
+                                           geometry.x, geometry.y,
+                                           geometry.width, geometry.height,
+                                           client_in_direction_filter,
+                                           client_in_direction_before, &filter);
+    else
+    {
+        /* Banning is outdated (e.g. tags were just switched) and clients
+         * that are about to be shown are not in the index yet. This is rare,
+         * so just index all clients for this query. */
+        spatialindex_t all = { 0 };
+        foreach(c, globalconf.clients)
+            spatialindex_set(&all, *c, (*c)->geometry.x, (*c)->geometry.y,
+                             (*c)->geometry.width, (*c)->geometry.height);
+        target = spatialindex_in_direction(&all, dir,
+                                           geometry.x, geometry.y,
+                                           geometry.width, geometry.height,
+                                           client_in_direction_filter,
+                                           client_in_direction_before, &filter);
+        spatialindex_wipe(&all);
+    }
+
+    if(!target)
+        return 0;
+    luaA_object_push(L, target);
+    return 1;
+}
+
 /** Check if a client is visible on its screen.
  *
  * @return A boolean value, true if the client is visible, false otherwise.
@@ -2865,15 +3159,21 @@ HANDLE_TITLEBAR_REFRESH(right, CLIENT_TITLEBAR_RIGHT)
 HANDLE_TITLEBAR_REFRESH(bottom, CLIENT_TITLEBAR_BOTTOM)
 HANDLE_TITLEBAR_REFRESH(left, CLIENT_TITLEBAR_LEFT)
 
-/**
- * Refresh all titlebars that are in the specified rectangle
+/** Repaint the parts of the titlebars that were exposed since the last
+ * refresh.
+ * \param c The client.
  */
-void
-client_refresh_partial(client_t *c, int16_t x, int16_t y, uint16_t width, uint16_t height)
+static void
+client_refresh_exposed(client_t *c)
 {
     for (client_titlebar_t bar = CLIENT_TITLEBAR_TOP; bar < CLIENT_TITLEBAR_COUNT; bar++) {
-        client_refresh_titlebar_partial(c, bar, x, y, width, height);
+        drawable_t *drawable = c->titlebar[bar].drawable;
+        if (drawable == NULL || drawable->pixmap == XCB_NONE || !drawable->refreshed)
+            continue;
+        cairo_surface_flush(drawable->surface);
+        window_expose_refresh((window_t *) c, drawable->pixmap, titlebar_get_area(c, bar));
     }
+    window_expose_clear((window_t *) c);
 }
 
 static drawable_t *
@@ -3321,6 +3621,19 @@ luaA_client_get_content(lua_State *L, client_t *c)
     return 1;
 }
 
+/** Get a client icon for Lua. Icons from the icon cache are shared with other
+ * clients, so Lua gets a copy of them.
+ * \param surface One of the client's icons.
+ * \return A new reference that Lua has to destroy.
+ */
+static cairo_surface_t *
+client_icon_for_lua(cairo_surface_t *surface)
+{
+    if(iconcache_contains(surface))
+        return draw_dup_image_surface(surface);
+    return cairo_surface_reference(surface);
+}
+
 static int
 luaA_client_get_icon(lua_State *L, client_t *c)
 {
@@ -3355,7 +3668,7 @@ luaA_client_get_icon(lua_State *L, client_t *c)
     }
 
     /* lua gets its own reference which it will have to destroy */
-    lua_pushlightuserdata(L, cairo_surface_reference(found));
+    lua_pushlightuserdata(L, client_icon_for_lua(found));
     return 1;
 }
 
@@ -3699,7 +4012,7 @@ luaA_client_get_some_icon(lua_State *L)
     int index = luaL_checkinteger(L, 2);
     luaL_argcheck(L, (index >= 1 && index <= c->icons.len), 2,
             "invalid icon index");
-    lua_pushlightuserdata(L, cairo_surface_reference(c->icons.tab[index-1]));
+    lua_pushlightuserdata(L, client_icon_for_lua(c->icons.tab[index-1]));
     return 1;
 }
 
@@ -3765,6 +4078,8 @@ client_class_setup(lua_State *L)
     {
         LUA_CLASS_METHODS(client)
         { "get", luaA_client_get },
+        { "at", luaA_client_at },
+        { "in_direction", luaA_client_in_direction },
         { "__index", luaA_client_module_index },
         { "__newindex", luaA_client_module_newindex },
         { NULL, NULL }
@@ -23,6 +23,7 @@
 #define AWESOME_OBJECTS_CLIENT_H
 
 #include "stack.h"
+#include "ewmh.h"
 #include "objects/window.h"
 
 #define CLIENT_SELECT_INPUT_EVENT_MASK (XCB_EVENT_MASK_STRUCTURE_NOTIFY \
@@ -158,6 +159,10 @@ struct client_t
     xcb_icccm_get_wm_protocols_reply_t protocols;
     /** Key bindings */
     key_array_t keys;
+    /** Lookup table for keys */
+    key_index_t keys_index;
+    /** Tags this client is tagged with */
+    tagset_array_t tags;
     /** Icons */
     cairo_surface_array_t icons;
     /** True if we ever got an icon from _NET_WM_ICON */
@@ -178,6 +183,9 @@ struct client_t
     client_t *transient_for;
     /** Value of WM_TRANSIENT_FOR */
     xcb_window_t transient_for_window;
+    /** First transient of this client and next transient of transient_for,
+     * in stacking order. Only valid during stack_refresh(). */
+    client_t *stack_transients, *stack_next_transient;
     /** Titelbar information */
     struct {
         /** The size of this bar. */
@@ -187,10 +195,45 @@ struct client_t
     } titlebar[CLIENT_TITLEBAR_COUNT];
     /** Motif WM hints, with an additional MWM_HINTS_AWESOME_SET bit */
     motif_wm_hints_t motif_wm_hints;
+    /** Properties that changed and were not requested yet, see
+     * property_mark_dirty() */
+    uint32_t dirty_properties;
 };
 
 ARRAY_FUNCS(client_t *, client, DO_NOTHING)
 
+/** Pending requests for everything we need to know to manage a window. This
+ * allows to manage many windows with a single round-trip to the X server, see
+ * client_manage_prepare().
+ */
+typedef struct
+{
+    xcb_get_property_cookie_t kde_dockapp;
+    xcb_get_property_cookie_t startup_id;
+    xcb_get_property_cookie_t strut;
+    xcb_get_property_cookie_t wm_normal_hints;
+    xcb_get_property_cookie_t wm_hints;
+    xcb_get_property_cookie_t wm_transient_for;
+    xcb_get_property_cookie_t wm_client_leader;
+    xcb_get_property_cookie_t wm_client_machine;
+    xcb_get_property_cookie_t wm_window_role;
+    xcb_get_property_cookie_t net_wm_pid;
+    xcb_get_property_cookie_t net_wm_icon;
+    xcb_get_property_cookie_t wm_name;
+    xcb_get_property_cookie_t net_wm_name;
+    xcb_get_property_cookie_t wm_icon_name;
+    xcb_get_property_cookie_t net_wm_icon_name;
+    xcb_get_property_cookie_t wm_class;
+    xcb_get_property_cookie_t wm_protocols;
+    xcb_get_property_cookie_t motif_wm_hints;
+    xcb_get_property_cookie_t opacity;
+    ewmh_hints_cookies_t ewmh_hints;
+    /** The checked ReparentWindow request, see client_manage_check() */
+    xcb_void_cookie_t reparent;
+    /** Number of round-trips that could not be avoided by prefetching */
+    int extra_round_trips;
+} client_manage_cookies_t;
+
 /** Client class */
 lua_class_t client_class;
 
@@ -205,7 +248,11 @@ void client_ban(client_t *);
 void client_ban_unfocus(client_t *);
 void client_unban(client_t *);
 void client_manage(xcb_window_t, xcb_get_geometry_reply_t *, xcb_get_window_attributes_reply_t *);
+void client_manage_prepare(xcb_window_t, client_manage_cookies_t *);
+client_t * client_manage_prepared(xcb_window_t, xcb_get_geometry_reply_t *, xcb_get_window_attributes_reply_t *, client_manage_cookies_t *);
+void client_manage_check(client_t *, client_manage_cookies_t *);
 bool client_resize(client_t *, area_t, bool);
+void client_need_refresh(client_t *);
 void client_unmanage(client_t *, bool);
 void client_kill(client_t *);
 void client_set_sticky(lua_State *, int, bool);
@@ -240,7 +287,6 @@ bool client_focus_update(client_t *);
 bool client_hasproto(client_t *, xcb_atom_t);
 void client_ignore_enterleave_events(void);
 void client_restore_enterleave_events(void);
-void client_refresh_partial(client_t *, int16_t, int16_t, uint16_t, uint16_t);
 void client_class_setup(lua_State *);
 void client_send_configure(client_t *);
 void client_find_transient_for(client_t *);
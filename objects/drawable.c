@@ -35,10 +35,18 @@
 #include "globalconf.h"
 
 #include <cairo-xcb.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
 
 /** Drawable object.
  *
- * @field surface The drawable's cairo surface.
+ * @field surface The drawable's cairo surface. With MIT-SHM, the X server
+ *  reads from this surface after @{refresh}, so it has to be fetched again
+ *  before drawing to it after every refresh instead of being kept around.
+ * @field shm Whether the surface should be an image surface in a MIT-SHM
+ *  segment instead of a surface on the X server. Only the region passed to
+ *  @{refresh} is then uploaded. This defaults to true when the X server
+ *  supports MIT-SHM.
  * @function drawable
  */
 
@@ -86,6 +94,10 @@
  * @signal property::surface
  */
 
+/**
+ * @signal property::shm
+ */
+
 /** Get the number of instances.
  *
  * @return The number of drawable objects alive.
@@ -106,6 +118,11 @@ static lua_class_t drawable_class;
 
 LUA_OBJECT_FUNCS(drawable_class, drawable_t, drawable)
 
+DO_ARRAY(drawable_t *, drawable, DO_NOTHING)
+
+/** Drawables whose MIT-SHM segment the X server may still be reading */
+static drawable_array_t shm_pending;
+
 drawable_t *
 drawable_allocator(lua_State *L, drawable_refresh_callback *callback, void *data)
 {
@@ -115,19 +132,206 @@ drawable_allocator(lua_State *L, drawable_refresh_callback *callback, void *data
     d->refreshed = false;
     d->surface = NULL;
     d->pixmap = XCB_NONE;
+    d->use_shm = globalconf.have_shm;
+    d->shmseg = XCB_NONE;
+    d->shmaddr = NULL;
+    d->shm_upload_pending = false;
     return d;
 }
 
+/** Get the image format to use for MIT-SHM backed drawables.
+ * The image data is handed to the X server as-is, so this only works if the
+ * server's pixmap format matches what cairo produces.
+ * \return The cairo format or CAIRO_FORMAT_INVALID.
+ */
+static cairo_format_t
+drawable_shm_format(void)
+{
+    const xcb_setup_t *setup = xcb_get_setup(globalconf.connection);
+    const uint16_t one = 1;
+    uint8_t byte_order = *(const uint8_t *) &one ?
+        XCB_IMAGE_ORDER_LSB_FIRST : XCB_IMAGE_ORDER_MSB_FIRST;
+
+    if (setup->image_byte_order != byte_order
+            || globalconf.visual->red_mask != 0xff0000
+            || globalconf.visual->green_mask != 0x00ff00
+            || globalconf.visual->blue_mask != 0x0000ff)
+        return CAIRO_FORMAT_INVALID;
+
+    xcb_format_iterator_t iter = xcb_setup_pixmap_formats_iterator(setup);
+    for (; iter.rem; xcb_format_next(&iter))
+        if (iter.data->depth == globalconf.default_depth)
+        {
+            if (iter.data->bits_per_pixel != 32)
+                return CAIRO_FORMAT_INVALID;
+            if (globalconf.default_depth == 24)
+                return CAIRO_FORMAT_RGB24;
+            if (globalconf.default_depth == 32)
+                return CAIRO_FORMAT_ARGB32;
+        }
+
+    return CAIRO_FORMAT_INVALID;
+}
+
+/** Create a MIT-SHM segment and an image surface on it for a drawable.
+ * \param d The drawable.
+ * \param width The width of the surface.
+ * \param height The height of the surface.
+ * \return true on success.
+ */
+static bool
+drawable_shm_create(drawable_t *d, int width, int height)
+{
+    cairo_format_t format = drawable_shm_format();
+    if (format == CAIRO_FORMAT_INVALID)
+        return false;
+
+    int stride = cairo_format_stride_for_width(format, width);
+    int shmid = shmget(IPC_PRIVATE, (size_t) stride * height, IPC_CREAT | 0600);
+    if (shmid < 0)
+        return false;
+
+    void *addr = shmat(shmid, NULL, 0);
+    if (addr == (void *) -1)
+    {
+        shmctl(shmid, IPC_RMID, NULL);
+        return false;
+    }
+
+    xcb_shm_seg_t seg = xcb_generate_id(globalconf.connection);
+    xcb_generic_error_t *error = xcb_request_check(globalconf.connection,
+            xcb_shm_attach_checked(globalconf.connection, seg, shmid, true));
+
+    /* Both sides are attached (or never will be), so the segment can already
+     * be marked for removal. It goes away once the last one detaches. */
+    shmctl(shmid, IPC_RMID, NULL);
+
+    if (error)
+    {
+        /* Most likely the X server is on another machine. Don't try again. */
+        warn("Cannot attach MIT-SHM segment, drawing to server-side pixmaps instead");
+        globalconf.have_shm = false;
+        p_delete(&error);
+        shmdt(addr);
+        return false;
+    }
+
+    d->shmseg = seg;
+    d->shmaddr = addr;
+    d->surface = cairo_image_surface_create_for_data(addr, format, width, height, stride);
+    return true;
+}
+
+/** Mark the last upload from a drawable's MIT-SHM segment as done.
+ * \param d The drawable.
+ */
+static void
+drawable_shm_upload_done(drawable_t *d)
+{
+    d->shm_upload_pending = false;
+    for (int i = 0; i < shm_pending.len; i++)
+        if (shm_pending.tab[i] == d)
+        {
+            drawable_array_take(&shm_pending, i);
+            break;
+        }
+}
+
+/** Handle the ShmCompletion event that ends an upload.
+ * \param ev The event.
+ */
+void
+drawable_shm_completion(xcb_shm_completion_event_t *ev)
+{
+    foreach(d, shm_pending)
+        /* Events of earlier uploads can still arrive after a wait */
+        if ((*d)->shmseg == ev->shmseg
+                && (uint16_t) (*d)->shm_upload.sequence == ev->sequence)
+        {
+            drawable_shm_upload_done(*d);
+            break;
+        }
+}
+
+/** Wait until the X server is done reading a drawable's MIT-SHM segment.
+ * This normally returns right away, because the completion event of the last
+ * upload was handled in the meantime. Otherwise it waits for the server to
+ * answer a request that was sent after the upload.
+ * \param d The drawable.
+ */
+static void
+drawable_shm_wait(drawable_t *d)
+{
+    if (!d->shm_upload_pending)
+        return;
+
+    xcb_get_input_focus_reply_t *reply = xcb_get_input_focus_reply(globalconf.connection,
+            xcb_get_input_focus(globalconf.connection), NULL);
+    p_delete(&reply);
+    drawable_shm_upload_done(d);
+}
+
+/** Copy part of a drawable's MIT-SHM segment to its pixmap.
+ * \param d The drawable.
+ * \param area The area to copy, in drawable coordinates.
+ */
+static void
+drawable_shm_upload(drawable_t *d, area_t area)
+{
+    drawable_shm_wait(d);
+    cairo_surface_flush(d->surface);
+    /* Ask for a completion event instead of waiting for the server */
+    d->shm_upload = xcb_shm_put_image(globalconf.connection,
+                                      d->pixmap, globalconf.gc,
+                                      d->geometry.width, d->geometry.height,
+                                      area.x, area.y, area.width, area.height,
+                                      area.x, area.y,
+                                      globalconf.default_depth,
+                                      XCB_IMAGE_FORMAT_Z_PIXMAP, true,
+                                      d->shmseg, 0);
+    d->shm_upload_pending = true;
+    drawable_array_append(&shm_pending, d);
+}
+
 static void
 drawable_unset_surface(drawable_t *d)
 {
+    drawable_shm_wait(d);
     cairo_surface_finish(d->surface);
     cairo_surface_destroy(d->surface);
+    if (d->shmseg)
+    {
+        xcb_shm_detach(globalconf.connection, d->shmseg);
+        shmdt(d->shmaddr);
+    }
     if (d->pixmap)
         xcb_free_pixmap(globalconf.connection, d->pixmap);
     d->refreshed = false;
     d->surface = NULL;
     d->pixmap = XCB_NONE;
+    d->shmseg = XCB_NONE;
+    d->shmaddr = NULL;
+}
+
+/** Create the pixmap and the surface of a drawable for its current size.
+ * \param L The Lua VM state.
+ * \param didx The index of the drawable on the stack.
+ * \param d The drawable.
+ */
+static void
+drawable_set_surface(lua_State *L, int didx, drawable_t *d)
+{
+    area_t geom = d->geometry;
+
+    d->pixmap = xcb_generate_id(globalconf.connection);
+    xcb_create_pixmap(globalconf.connection, globalconf.default_depth, d->pixmap,
+                      globalconf.screen->root, geom.width, geom.height);
+    if (!d->use_shm || !globalconf.have_shm
+            || !drawable_shm_create(d, geom.width, geom.height))
+        d->surface = cairo_xcb_surface_create(globalconf.connection,
+                                              d->pixmap, globalconf.visual,
+                                              geom.width, geom.height);
+    luaA_object_emit_signal(L, didx, "property::surface", 0);
 }
 
 static void
@@ -147,26 +351,18 @@ drawable_set_geometry(lua_State *L, int didx, area_t geom)
     if (size_changed)
         drawable_unset_surface(d);
     if (size_changed && geom.width > 0 && geom.height > 0)
-    {
-        d->pixmap = xcb_generate_id(globalconf.connection);
-        xcb_create_pixmap(globalconf.connection, globalconf.default_depth, d->pixmap,
-                          globalconf.screen->root, geom.width, geom.height);
-        d->surface = cairo_xcb_surface_create(globalconf.connection,
-                                              d->pixmap, globalconf.visual,
-                                              geom.width, geom.height);
-        luaA_object_emit_signal(L, didx, "property::surface", 0);
-    }
+        drawable_set_surface(L, didx, d);
 
     if (!AREA_EQUAL(old, geom))
-        luaA_object_emit_signal(L, didx, "property::geometry", 0);
+        luaA_object_emit_signal_id(L, didx, SIGNAL_ID("property::geometry"), 0);
     if (old.x != geom.x)
-        luaA_object_emit_signal(L, didx, "property::x", 0);
+        luaA_object_emit_signal_id(L, didx, SIGNAL_ID("property::x"), 0);
     if (old.y != geom.y)
-        luaA_object_emit_signal(L, didx, "property::y", 0);
+        luaA_object_emit_signal_id(L, didx, SIGNAL_ID("property::y"), 0);
     if (old.width != geom.width)
-        luaA_object_emit_signal(L, didx, "property::width", 0);
+        luaA_object_emit_signal_id(L, didx, SIGNAL_ID("property::width"), 0);
     if (old.height != geom.height)
-        luaA_object_emit_signal(L, didx, "property::height", 0);
+        luaA_object_emit_signal_id(L, didx, SIGNAL_ID("property::height"), 0);
 }
 
 /** Get a drawable's surface
@@ -177,6 +373,8 @@ drawable_set_geometry(lua_State *L, int didx, area_t geom)
 static int
 luaA_drawable_get_surface(lua_State *L, drawable_t *drawable)
 {
+    /* The caller is about to draw, which must not race with an upload */
+    drawable_shm_wait(drawable);
     if (drawable->surface)
         /* Lua gets its own reference which it will have to destroy */
         lua_pushlightuserdata(L, cairo_surface_reference(drawable->surface));
@@ -185,15 +383,76 @@ luaA_drawable_get_surface(lua_State *L, drawable_t *drawable)
     return 1;
 }
 
+/** Get whether a drawable uses a MIT-SHM segment if possible.
+ * \param L The Lua VM state.
+ * \param drawable The drawable object.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_drawable_get_shm(lua_State *L, drawable_t *drawable)
+{
+    lua_pushboolean(L, drawable->use_shm);
+    return 1;
+}
+
+/** Set whether a drawable uses a MIT-SHM segment if possible.
+ * \param L The Lua VM state.
+ * \param drawable The drawable object.
+ * \return The number of elements pushed on stack.
+ */
+static int
+luaA_drawable_set_shm(lua_State *L, drawable_t *drawable)
+{
+    bool b = luaA_checkboolean(L, -1);
+    if (b != drawable->use_shm)
+    {
+        drawable->use_shm = b;
+        if (drawable->surface)
+        {
+            drawable_unset_surface(drawable);
+            drawable_set_surface(L, -3, drawable);
+        }
+        luaA_object_emit_signal(L, -3, "property::shm", 0);
+    }
+    return 0;
+}
+
 /** Refresh a drawable's content. This has to be called whenever some drawing to
  * the drawable's surface has been done and should become visible.
  *
+ * When the drawable's surface lives in a MIT-SHM segment, only the given
+ * area is uploaded to the X server. The surface has to be queried again
+ * before drawing to it after a refresh.
+ *
+ * @tparam[opt=0] integer x The x coordinate of the area that changed.
+ * @tparam[opt=0] integer y The y coordinate of the area that changed.
+ * @tparam[opt] integer width The width of the area, defaults to the whole
+ *  drawable.
+ * @tparam[opt] integer height The height of the area, defaults to the whole
+ *  drawable.
  * @function refresh
  */
 static int
 luaA_drawable_refresh(lua_State *L)
 {
     drawable_t *drawable = luaA_checkudata(L, 1, &drawable_class);
+
+    if (drawable->shmseg)
+    {
+        int x = luaL_optinteger(L, 2, 0);
+        int y = luaL_optinteger(L, 3, 0);
+        int right = x + luaL_optinteger(L, 4, drawable->geometry.width);
+        int bottom = y + luaL_optinteger(L, 5, drawable->geometry.height);
+        x = MAX(x, 0);
+        y = MAX(y, 0);
+        right = MIN(right, drawable->geometry.width);
+        bottom = MIN(bottom, drawable->geometry.height);
+        if (right > x && bottom > y)
+            drawable_shm_upload(drawable, (area_t) { .x = x, .y = y,
+                                                     .width = right - x,
+                                                     .height = bottom - y });
+    }
+
     drawable->refreshed = true;
     (*drawable->refresh_callback)(drawable->refresh_data);
 
@@ -239,6 +498,10 @@ drawable_class_setup(lua_State *L)
                             NULL,
                             (lua_class_propfunc_t) luaA_drawable_get_surface,
                             NULL);
+    luaA_class_add_property(&drawable_class, "shm",
+                            (lua_class_propfunc_t) luaA_drawable_set_shm,
+                            (lua_class_propfunc_t) luaA_drawable_get_shm,
+                            (lua_class_propfunc_t) luaA_drawable_set_shm);
 }
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
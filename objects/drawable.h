@@ -26,6 +26,8 @@
 #include "common/luaclass.h"
 #include "draw.h"
 
+#include <xcb/shm.h>
+
 typedef void drawable_refresh_callback(void *);
 
 /** drawable type */
@@ -44,11 +46,23 @@ struct drawable_t
     drawable_refresh_callback *refresh_callback;
     /** Data for refresh callback. */
     void *refresh_data;
+    /** Should the surface live in a MIT-SHM segment if possible? */
+    bool use_shm;
+    /** The segment backing the surface, or XCB_NONE if we draw to the pixmap. */
+    xcb_shm_seg_t shmseg;
+    /** Our mapping of the segment. */
+    void *shmaddr;
+    /** Is the server possibly still reading from the segment? This is
+     * cleared by the upload's ShmCompletion event. */
+    bool shm_upload_pending;
+    /** The last upload from the segment to the pixmap. */
+    xcb_void_cookie_t shm_upload;
 };
 typedef struct drawable_t drawable_t;
 
 drawable_t *drawable_allocator(lua_State *, drawable_refresh_callback *, void *);
 void drawable_set_geometry(lua_State *, int, area_t);
+void drawable_shm_completion(xcb_shm_completion_event_t *);
 void drawable_class_setup(lua_State *);
 
 #endif
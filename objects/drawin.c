@@ -181,6 +181,14 @@ drawin_wipe(drawin_t *w)
     {
         /* Make sure we don't accidentally kill the systray window */
         drawin_systray_kickout(w);
+        if(w->refresh_queued)
+            foreach(item, globalconf.dirty.drawins)
+                if(*item == w)
+                {
+                    drawin_array_remove(&globalconf.dirty.drawins, item);
+                    break;
+                }
+        windowindex_remove(&globalconf.windows, w->window);
         xcb_destroy_window(globalconf.connection, w->window);
         w->window = XCB_NONE;
     }
@@ -227,14 +235,55 @@ drawin_apply_moveresize(drawin_t *w)
     client_restore_enterleave_events();
 }
 
+/** Queue a drawin for the next refresh.
+ * \param w The drawin.
+ */
+static void
+drawin_need_refresh(drawin_t *w)
+{
+    if(w->refresh_queued)
+        return;
+    w->refresh_queued = true;
+    drawin_array_append(&globalconf.dirty.drawins, w);
+}
+
+/** Repaint the parts of a drawin that were exposed since the last refresh.
+ * \param drawin The drawin.
+ */
+static void
+drawin_refresh_exposed(drawin_t *drawin)
+{
+    if (drawin->drawable && drawin->drawable->pixmap && drawin->drawable->refreshed)
+    {
+        /* Make cairo do all pending drawing */
+        cairo_surface_flush(drawin->drawable->surface);
+        window_expose_refresh((window_t *) drawin, drawin->drawable->pixmap,
+                              (area_t) { 0, 0, drawin->geometry.width, drawin->geometry.height });
+    }
+    window_expose_clear((window_t *) drawin);
+}
+
 void
 drawin_refresh(void)
 {
-    foreach(item, globalconf.drawins)
+    foreach(item, globalconf.dirty.drawins)
     {
+        (*item)->refresh_queued = false;
+        /* Hidden drawins are refreshed when they are mapped again */
+        if(!(*item)->visible)
+        {
+            window_expose_clear((window_t *) *item);
+            continue;
+        }
         drawin_apply_moveresize(*item);
         window_border_refresh((window_t *) *item);
+        if((*item)->exposed)
+            drawin_refresh_exposed(*item);
     }
+
+    globalconf.dirty.last_drawins = globalconf.dirty.drawins.len;
+    globalconf.dirty.visited_drawins += globalconf.dirty.drawins.len;
+    globalconf.dirty.drawins.len = 0;
 }
 
 /** Get all drawins into a table.
@@ -274,18 +323,19 @@ drawin_moveresize(lua_State *L, int udx, area_t geometry)
         w->geometry.height = old_geometry.height;
 
     w->geometry_dirty = true;
+    drawin_need_refresh(w);
     drawin_update_drawing(L, udx);
 
     if (!AREA_EQUAL(old_geometry, w->geometry))
-        luaA_object_emit_signal(L, udx, "property::geometry", 0);
+        luaA_object_emit_signal_id(L, udx, SIGNAL_ID("property::geometry"), 0);
     if (old_geometry.x != w->geometry.x)
-        luaA_object_emit_signal(L, udx, "property::x", 0);
+        luaA_object_emit_signal_id(L, udx, SIGNAL_ID("property::x"), 0);
     if (old_geometry.y != w->geometry.y)
-        luaA_object_emit_signal(L, udx, "property::y", 0);
+        luaA_object_emit_signal_id(L, udx, SIGNAL_ID("property::y"), 0);
     if (old_geometry.width != w->geometry.width)
-        luaA_object_emit_signal(L, udx, "property::width", 0);
+        luaA_object_emit_signal_id(L, udx, SIGNAL_ID("property::width"), 0);
     if (old_geometry.height != w->geometry.height)
-        luaA_object_emit_signal(L, udx, "property::height", 0);
+        luaA_object_emit_signal_id(L, udx, SIGNAL_ID("property::height"), 0);
 
     screen_t *old_screen = screen_getbycoord(old_geometry.x, old_geometry.y);
     screen_t *new_screen = screen_getbycoord(w->geometry.x, w->geometry.y);
@@ -337,6 +387,9 @@ drawin_map(lua_State *L, int widx)
     stack_windows();
     /* Add it to the list of visible drawins */
     drawin_array_append(&globalconf.drawins, drawin);
+    windowindex_insert(&globalconf.windows, drawin->window, WINDOW_ROLE_DRAWIN, drawin);
+    /* Apply border changes done while it was hidden */
+    drawin_need_refresh(drawin);
     /* Make sure it has a surface */
     if(drawin->drawable->surface == NULL)
         drawin_update_drawing(L, widx);
@@ -346,6 +399,7 @@ static void
 drawin_unmap(drawin_t *drawin)
 {
     xcb_unmap_window(globalconf.connection, drawin->window);
+    windowindex_remove(&globalconf.windows, drawin->window);
     foreach(item, globalconf.drawins)
         if(*item == drawin)
         {
@@ -361,10 +415,7 @@ drawin_unmap(drawin_t *drawin)
 drawin_t *
 drawin_getbywin(xcb_window_t win)
 {
-    foreach(w, globalconf.drawins)
-        if((*w)->window == win)
-            return *w;
-    return NULL;
+    return windowindex_get(&globalconf.windows, win, WINDOW_ROLE_DRAWIN);
 }
 
 /** Set a drawin visible or not.
@@ -422,6 +473,7 @@ drawin_allocator(lua_State *L)
     w->geometry.width = 1;
     w->geometry.height = 1;
     w->geometry_dirty = false;
+    w->need_refresh_callback = (void (*) (void *)) drawin_need_refresh;
     w->type = _NET_WM_WINDOW_TYPE_NORMAL;
 
     drawable_allocator(L, (drawable_refresh_callback *) drawin_refresh_pixmap, w);
@@ -43,6 +43,10 @@
 #include <xkbcommon/xkbcommon.h>
 #include <glib.h>
 
+/** Incremented whenever a key array or a key changes; key indexes that were
+ * built for an older generation are stale. */
+static unsigned int key_generation = 1;
+
 /** Key object.
  *
  * @tfield string key The key to trigger an event.
@@ -52,6 +56,9 @@
  * @tfield table modifiers The modifier key that should be pressed while the
  *   key is pressed. An array with all the modifiers. Valid modifiers are: Any,
  *   Mod1, Mod2, Mod3, Mod4, Mod5, Shift, Lock and Control.
+ * @tfield table ignore_modifiers Modifiers that are ignored when matching the
+ *   key, so that e.g. Num Lock does not prevent the key from working. Same
+ *   format as `modifiers`.
  * @table key
  */
 
@@ -67,6 +74,10 @@
  * @signal property::modifiers
  */
 
+/**
+ * @signal property::ignore_modifiers
+ */
+
 /**
  * @signal release
  */
@@ -163,7 +174,8 @@ luaA_keystore(lua_State *L, int ud, const char *str, ssize_t len)
         }
     }
 
-    luaA_object_emit_signal(L, ud, "property::key", 0);
+    key_index_invalidate();
+    luaA_object_emit_signal_id(L, ud, SIGNAL_ID("property::key"), 0);
 }
 
 /** Create a new key object.
@@ -192,6 +204,7 @@ luaA_key_array_set(lua_State *L, int oidx, int idx, key_array_t *keys)
 
     key_array_wipe(keys);
     key_array_init(keys);
+    key_index_invalidate();
 
     lua_pushnil(L);
     while(lua_next(L, idx))
@@ -219,6 +232,172 @@ luaA_key_array_get(lua_State *L, int oidx, key_array_t *keys)
     return 1;
 }
 
+/** Mark all key indexes as out of date. This has to be called whenever a key
+ * array or the key or modifiers of a key object change.
+ */
+void
+key_index_invalidate(void)
+{
+    key_generation++;
+}
+
+/** Get the code under which a key is stored in a key index. Keys bound to a
+ * keycode and keys bound to a keysym live in the same table, keycodes are
+ * tagged with the highest bit (keysyms only use 29 bits).
+ * \param keycode The keycode or 0.
+ * \param keysym The keysym, used if keycode is 0.
+ * \return The code, 0 if neither is set.
+ */
+static inline uint32_t
+key_index_code(xcb_keycode_t keycode, xcb_keysym_t keysym)
+{
+    if(keycode)
+        return UINT32_C(0x80000000) | keycode;
+    return keysym;
+}
+
+static inline int
+key_index_slot(key_index_t *idx, uint32_t code)
+{
+    uint32_t h = code * UINT32_C(2654435769);
+    return (h ^ (h >> 16)) & (idx->size - 1);
+}
+
+typedef struct
+{
+    uint32_t code;
+    int position;
+} key_index_item_t;
+
+static int
+key_index_item_cmp(const void *a, const void *b)
+{
+    const key_index_item_t *x = a, *y = b;
+    if(x->code != y->code)
+        return x->code < y->code ? -1 : 1;
+    return x->position - y->position;
+}
+
+/** Free all memory used by a key index.
+ * \param idx The index.
+ */
+void
+key_index_wipe(key_index_t *idx)
+{
+    p_delete(&idx->slots);
+    p_delete(&idx->positions);
+    idx->size = 0;
+    idx->generation = 0;
+}
+
+static void
+key_index_build(key_index_t *idx, key_array_t *keys)
+{
+    key_index_item_t *items = p_new(key_index_item_t, MAX(keys->len, 1));
+    int n = 0;
+
+    for(int i = 0; i < keys->len; i++)
+    {
+        uint32_t code = key_index_code(keys->tab[i]->keycode, keys->tab[i]->keysym);
+        if(code)
+            items[n++] = (key_index_item_t) { .code = code, .position = i };
+    }
+    qsort(items, n, sizeof(*items), key_index_item_cmp);
+
+    key_index_wipe(idx);
+    /* Keep the load factor below 1/2; there are at most n distinct codes */
+    idx->size = 16;
+    while(idx->size < 2 * n)
+        idx->size *= 2;
+    idx->slots = p_new(key_index_slot_t, idx->size);
+    idx->positions = p_new(int, MAX(n, 1));
+    idx->generation = key_generation;
+
+    for(int i = 0; i < n; i++)
+    {
+        idx->positions[i] = items[i].position;
+        if(i > 0 && items[i].code == items[i - 1].code)
+            continue;
+
+        int mask = idx->size - 1, slot = key_index_slot(idx, items[i].code);
+        while(idx->slots[slot].code)
+            slot = (slot + 1) & mask;
+
+        int count = 1;
+        while(i + count < n && items[i + count].code == items[i].code)
+            count++;
+        idx->slots[slot] = (key_index_slot_t) { .code = items[i].code, .first = i, .count = count };
+    }
+
+    p_delete(&items);
+}
+
+static key_index_slot_t *
+key_index_lookup(key_index_t *idx, uint32_t code)
+{
+    int mask = idx->size - 1;
+    for(int slot = key_index_slot(idx, code);; slot = (slot + 1) & mask)
+    {
+        if(idx->slots[slot].code == code)
+            return &idx->slots[slot];
+        if(!idx->slots[slot].code)
+            return NULL;
+    }
+}
+
+/** Check if a modifier state matches a key. Like when grabbing it, modifiers
+ * that are part of the key's own modifiers are not ignored.
+ */
+static inline bool
+key_modifiers_match(keyb_t *k, uint16_t state)
+{
+    return k->modifiers == XCB_BUTTON_MASK_ANY
+        || k->modifiers == (state & ~(k->ignore_modifiers & ~k->modifiers));
+}
+
+/** Find all keys of a key array that match a pressed key.
+ * \param idx The index for the key array, rebuilt if it is stale.
+ * \param keys The key array.
+ * \param keycode The keycode of the pressed key.
+ * \param keysym The keysym of the pressed key, ignoring modifiers.
+ * \param state The modifier state.
+ * \return The matching keys, in the order of the key array. The array is only
+ * valid until the next call.
+ */
+key_array_t *
+key_index_match(key_index_t *idx, key_array_t *keys, xcb_keycode_t keycode,
+                xcb_keysym_t keysym, uint16_t state)
+{
+    static key_array_t matches;
+    key_index_slot_t *by_keycode, *by_keysym;
+
+    if(idx->generation != key_generation)
+        key_index_build(idx, keys);
+
+    matches.len = 0;
+    by_keycode = keycode ? key_index_lookup(idx, key_index_code(keycode, 0)) : NULL;
+    by_keysym = keysym ? key_index_lookup(idx, key_index_code(0, keysym)) : NULL;
+
+    /* Merge both lists to keep the order of the key array */
+    int i = 0, j = 0;
+    int ni = by_keycode ? by_keycode->count : 0;
+    int nj = by_keysym ? by_keysym->count : 0;
+    while(i < ni || j < nj)
+    {
+        int pos;
+        if(j >= nj || (i < ni && idx->positions[by_keycode->first + i]
+                                 < idx->positions[by_keysym->first + j]))
+            pos = idx->positions[by_keycode->first + i++];
+        else
+            pos = idx->positions[by_keysym->first + j++];
+
+        if(key_modifiers_match(keys->tab[pos], state))
+            key_array_append(&matches, keys->tab[pos]);
+    }
+
+    return &matches;
+}
+
 /** Push a modifier set to a Lua table.
  * \param L The Lua VM state.
  * \param modifiers The modifier.
@@ -268,11 +447,22 @@ static int
 luaA_key_set_modifiers(lua_State *L, keyb_t *k)
 {
     k->modifiers = luaA_tomodifiers(L, -1);
-    luaA_object_emit_signal(L, -3, "property::modifiers", 0);
+    key_index_invalidate();
+    luaA_object_emit_signal_id(L, -3, SIGNAL_ID("property::modifiers"), 0);
+    return 0;
+}
+
+static int
+luaA_key_set_ignore_modifiers(lua_State *L, keyb_t *k)
+{
+    k->ignore_modifiers = luaA_tomodifiers(L, -1);
+    key_index_invalidate();
+    luaA_object_emit_signal_id(L, -3, SIGNAL_ID("property::ignore_modifiers"), 0);
     return 0;
 }
 
 LUA_OBJECT_EXPORT_PROPERTY(key, keyb_t, modifiers, luaA_pushmodifiers)
+LUA_OBJECT_EXPORT_PROPERTY(key, keyb_t, ignore_modifiers, luaA_pushmodifiers)
 
 /* It's caller's responsibility to release the returned string. */
 char *
@@ -372,6 +562,10 @@ key_class_setup(lua_State *L)
                             (lua_class_propfunc_t) luaA_key_set_modifiers,
                             (lua_class_propfunc_t) luaA_key_get_modifiers,
                             (lua_class_propfunc_t) luaA_key_set_modifiers);
+    luaA_class_add_property(&key_class, "ignore_modifiers",
+                            (lua_class_propfunc_t) luaA_key_set_ignore_modifiers,
+                            (lua_class_propfunc_t) luaA_key_get_ignore_modifiers,
+                            (lua_class_propfunc_t) luaA_key_set_ignore_modifiers);
 }
 
 /* @DOC_cobject_COMMON@ */
@@ -30,6 +30,8 @@ typedef struct keyb_t
     LUA_OBJECT_HEADER
     /** Key modifier */
     uint16_t modifiers;
+    /** Modifiers that may additionally be pressed without affecting matching */
+    uint16_t ignore_modifiers;
     /** Keysym */
     xcb_keysym_t keysym;
     /** Keycode */
@@ -40,8 +42,34 @@ lua_class_t key_class;
 LUA_OBJECT_FUNCS(key_class, keyb_t, key)
 DO_ARRAY(keyb_t *, key, DO_NOTHING)
 
+typedef struct
+{
+    /** The keycode or keysym, see key_index_code(); 0 for an empty slot */
+    uint32_t code;
+    /** Where the positions of the keys with this code start and how many */
+    int first, count;
+} key_index_slot_t;
+
+/** A lookup table from a pressed key to the key objects of a key array that
+ * could match it. It is rebuilt lazily after any key array or key changed.
+ */
+typedef struct
+{
+    /** Open-addressing hash table, size is a power of two */
+    key_index_slot_t *slots;
+    int size;
+    /** Positions in the key array, grouped by code and ascending per code */
+    int *positions;
+    /** The key_generation this index was built for */
+    unsigned int generation;
+} key_index_t;
+
 void key_class_setup(lua_State *);
 
+void key_index_wipe(key_index_t *);
+void key_index_invalidate(void);
+key_array_t *key_index_match(key_index_t *, key_array_t *, xcb_keycode_t, xcb_keysym_t, uint16_t);
+
 void luaA_key_array_set(lua_State *, int, int, key_array_t *);
 int luaA_key_array_get(lua_State *, int, key_array_t *);
 
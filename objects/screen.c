@@ -50,6 +50,7 @@
 #include "objects/client.h"
 #include "objects/drawin.h"
 #include "event.h"
+#include "common/spatialindex.h"
 
 #include <stdio.h>
 
@@ -62,6 +63,38 @@
  */
 #define FAKE_SCREEN_XID ((uint32_t) 0xffffffff)
 
+/** The screens by their geometry. This is rebuilt on the next lookup after
+ * screens were added, removed, moved or reordered. Screens are inserted in
+ * the order of globalconf.screens, so the first screen in a cell that
+ * contains a point is the same one a linear search would find.
+ */
+static struct
+{
+    spatialindex_t index;
+    bool valid;
+} screen_areas;
+
+static void
+screen_areas_invalidate(void)
+{
+    screen_areas.valid = false;
+}
+
+static spatialindex_t *
+screen_areas_get(void)
+{
+    if(!screen_areas.valid)
+    {
+        spatialindex_wipe(&screen_areas.index);
+        foreach(s, globalconf.screens)
+            spatialindex_set(&screen_areas.index, *s,
+                             (*s)->geometry.x, (*s)->geometry.y,
+                             (*s)->geometry.width, (*s)->geometry.height);
+        screen_areas.valid = true;
+    }
+    return &screen_areas.index;
+}
+
 /** Screen is a table where indexes are screen numbers. You can use `screen[1]`
  * to get access to the first screen, etc. Alternatively, if RANDR information
  * is available, you can use output names for finding screen objects.
@@ -576,6 +609,7 @@ screen_added(lua_State *L, screen_t *screen)
 {
     screen->workarea = screen->geometry;
     screen->valid = true;
+    screen_areas_invalidate();
     luaA_object_push(L, screen);
     luaA_object_emit_signal(L, -1, "added", 0);
     lua_pop(L, 1);
@@ -612,6 +646,7 @@ screen_removed(lua_State *L, int sidx)
 {
     screen_t *screen = luaA_checkudata(L, sidx, &screen_class);
 
+    screen_areas_invalidate();
     luaA_object_emit_signal(L, sidx, "removed", 0);
 
     if (globalconf.primary_screen == screen)
@@ -632,6 +667,7 @@ screen_modified(screen_t *existing_screen, screen_t *other_screen)
     if(!AREA_EQUAL(existing_screen->geometry, other_screen->geometry)) {
         area_t old_geometry = existing_screen->geometry;
         existing_screen->geometry = other_screen->geometry;
+        screen_areas_invalidate();
         luaA_object_push(L, existing_screen);
         luaA_pusharea(L, old_geometry);
         luaA_object_emit_signal(L, -2, "property::geometry", 1);
@@ -792,9 +828,9 @@ screen_get_distance_squared(screen_t *s, int x, int y)
 screen_t *
 screen_getbycoord(int x, int y)
 {
-    foreach(s, globalconf.screens)
-        if(screen_coord_in_screen(*s, x, y))
-            return *s;
+    screen_t *s = screen_at(x, y);
+    if(s)
+        return s;
 
     /* No screen found, find nearest screen. */
     screen_t *nearest_screen = NULL;
@@ -811,6 +847,22 @@ screen_getbycoord(int x, int y)
     return nearest_screen;
 }
 
+/** Get the screen containing a point.
+ * \param x X coordinate
+ * \param y Y coordinate
+ * \return The first screen containing the point or NULL.
+ */
+screen_t *
+screen_at(int x, int y)
+{
+    spatialindex_cell_array_t *cell = spatialindex_cell(screen_areas_get(), x, y);
+    if(cell)
+        foreach(item, *cell)
+            if(spatialindex_item_contains(*item, x, y))
+                return (*item)->object;
+    return NULL;
+}
+
 /** Are the given coordinates in a given screen?
  * \param screen The logical screen number.
  * \param x X coordinate
@@ -1156,6 +1208,26 @@ luaA_screen_count(lua_State *L)
     return 1;
 }
 
+/** Get the screen at a position.
+ *
+ * Unlike `awful.screen.getbycoord`, this does not fall back to the nearest
+ * screen.
+ *
+ * @tparam integer x The X coordinate.
+ * @tparam integer y The Y coordinate.
+ * @treturn screen|nil The screen containing the point, if any.
+ * @function at
+ */
+static int
+luaA_screen_at(lua_State *L)
+{
+    screen_t *s = screen_at(luaL_checkinteger(L, 1), luaL_checkinteger(L, 2));
+    if(!s)
+        return 0;
+    luaA_object_push(L, s);
+    return 1;
+}
+
 /** Add a fake screen.
  *
  * To vertically split the first screen in 2 equal parts, use:
@@ -1247,6 +1319,7 @@ luaA_screen_fake_resize(lua_State *L)
     screen->geometry.y = y;
     screen->geometry.width = width;
     screen->geometry.height = height;
+    screen_areas_invalidate();
 
     screen_update_workarea(screen);
 
@@ -1284,6 +1357,7 @@ luaA_screen_swap(lua_State *L)
         /* swap ! */
         *ref_s = swap;
         *ref_swap = s;
+        screen_areas_invalidate();
 
         luaA_class_emit_signal(L, &screen_class, "list", 0);
 
@@ -1307,6 +1381,7 @@ screen_class_setup(lua_State *L)
     {
         LUA_CLASS_METHODS(screen)
         { "count", luaA_screen_count },
+        { "at", luaA_screen_at },
         { "__index", luaA_screen_module_index },
         { "__newindex", luaA_default_newindex },
         { "__call", luaA_screen_module_call },
@@ -261,11 +261,36 @@ tag_unref_simplified(tag_t **tag)
     luaA_object_unref(L, *tag);
 }
 
+static tag_t *
+tag_allocator(lua_State *L)
+{
+    tag_t *tag = tag_new(L);
+
+    /* Use the lowest free id, so that tag sets stay small */
+    while(tagset_contains(&globalconf.tag_ids, tag->id))
+        tag->id++;
+    tagset_set(&globalconf.tag_ids, tag->id, true);
+
+    return tag;
+}
+
 static void
 tag_wipe(tag_t *tag)
 {
     client_array_wipe(&tag->clients);
     p_delete(&tag->name);
+    tagset_set(&globalconf.selected_tags, tag->id, false);
+    tagset_set(&globalconf.tag_ids, tag->id, false);
+}
+
+/** Update the global set of selected tags after the tag's selected or
+ * activated state changed.
+ * \param tag The tag.
+ */
+static void
+tag_update_selected_tags(tag_t *tag)
+{
+    tagset_set(&globalconf.selected_tags, tag->id, tag->selected && tag->activated);
 }
 
 OBJECT_EXPORT_PROPERTY(tag, tag_t, selected)
@@ -283,6 +308,7 @@ tag_view(lua_State *L, int udx, bool view)
     if(tag->selected != view)
     {
         tag->selected = view;
+        tag_update_selected_tags(tag);
         banning_need_update();
         foreach(screen, globalconf.screens)
             screen_update_workarea(*screen);
@@ -325,6 +351,7 @@ tag_client(lua_State *L, client_t *c)
     }
 
     client_array_append(&t->clients, c);
+    tagset_set(&c->tags, t->id, true);
     ewmh_client_update_desktop(c);
     banning_need_update();
     screen_update_workarea(c->screen);
@@ -344,6 +371,7 @@ untag_client(client_t *c, tag_t *t)
         {
             lua_State *L = globalconf_get_lua_State();
             client_array_take(&t->clients, i);
+            tagset_set(&c->tags, t->id, false);
             banning_need_update();
             ewmh_client_update_desktop(c);
             screen_update_workarea(c->screen);
@@ -361,11 +389,7 @@ untag_client(client_t *c, tag_t *t)
 bool
 is_client_tagged(client_t *c, tag_t *t)
 {
-    for(int i = 0; i < t->clients.len; i++)
-        if(t->clients.tab[i] == c)
-            return true;
-
-    return false;
+    return tagset_contains(&c->tags, t->id);
 }
 
 /** Get the index of the tag with focused client or first selected
@@ -532,6 +556,7 @@ luaA_tag_set_activated(lua_State *L, tag_t *tag)
         }
         luaA_object_unref(L, tag);
     }
+    tag_update_selected_tags(tag);
     ewmh_update_net_numbers_of_desktop();
     ewmh_update_net_desktop_names();
 
@@ -559,7 +584,7 @@ tag_class_setup(lua_State *L)
     };
 
     luaA_class_setup(L, &tag_class, "tag", NULL,
-                     (lua_class_allocator_t) tag_new,
+                     (lua_class_allocator_t) tag_allocator,
                      (lua_class_collector_t) tag_wipe,
                      NULL,
                      luaA_class_index_miss_property, luaA_class_newindex_miss_property,
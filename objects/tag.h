@@ -44,6 +44,8 @@ struct tag
     bool selected;
     /** clients in this tag */
     client_array_t clients;
+    /** Index of this tag in tag sets */
+    int id;
 };
 
 lua_class_t tag_class;
@@ -54,5 +56,61 @@ void tag_class_setup(lua_State *);
 bool tag_get_selected(tag_t *);
 char *tag_get_name(tag_t *);
 
+#define TAGSET_WORD_BITS 32
+
+/** Check if a tag set contains a tag.
+ * \param set The tag set.
+ * \param id The id of the tag.
+ * \return True if the tag is in the set.
+ */
+static inline bool
+tagset_contains(tagset_array_t *set, int id)
+{
+    int word = id / TAGSET_WORD_BITS;
+    return word < set->len
+        && (set->tab[word] & (UINT32_C(1) << (id % TAGSET_WORD_BITS)));
+}
+
+/** Add a tag to a tag set or remove it.
+ * \param set The tag set.
+ * \param id The id of the tag.
+ * \param value True to add the tag, false to remove it.
+ */
+static inline void
+tagset_set(tagset_array_t *set, int id, bool value)
+{
+    int word = id / TAGSET_WORD_BITS;
+    uint32_t bit = UINT32_C(1) << (id % TAGSET_WORD_BITS);
+
+    if(word >= set->len)
+    {
+        if(!value)
+            return;
+        tagset_array_grow(set, word + 1);
+        p_clear(set->tab + set->len, word + 1 - set->len);
+        set->len = word + 1;
+    }
+
+    if(value)
+        set->tab[word] |= bit;
+    else
+        set->tab[word] &= ~bit;
+}
+
+/** Check if two tag sets have a tag in common.
+ * \param a The first tag set.
+ * \param b The second tag set.
+ * \return True if some tag is in both sets.
+ */
+static inline bool
+tagset_intersects(tagset_array_t *a, tagset_array_t *b)
+{
+    int len = MIN(a->len, b->len);
+    for(int i = 0; i < len; i++)
+        if(a->tab[i] & b->tab[i])
+            return true;
+    return false;
+}
+
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -69,10 +69,106 @@ window_get(window_t *window)
     return window->window;
 }
 
+/** Make sure that the next refresh looks at a window.
+ * \param window The window object.
+ */
+static void
+window_need_refresh(window_t *window)
+{
+    if(window->need_refresh_callback)
+        (*window->need_refresh_callback)(window);
+}
+
+/** Counters for repainting exposed windows */
+static struct
+{
+    /** Number of Expose events */
+    unsigned long events;
+    /** Number of CopyArea requests sent for them */
+    unsigned long copies;
+} expose_stats;
+
 static void
 window_wipe(window_t *window)
 {
     button_array_wipe(&window->buttons);
+    window_expose_clear(window);
+}
+
+/** Remember that a part of a window has to be repainted. This is done during
+ * the next refresh, where all the rectangles exposed since the previous one
+ * are repainted together with as few copies as possible.
+ * \param window The window object.
+ * \param x The x coordinate of the exposed rectangle.
+ * \param y The y coordinate of the exposed rectangle.
+ * \param width The width of the exposed rectangle.
+ * \param height The height of the exposed rectangle.
+ */
+void
+window_expose(window_t *window, int16_t x, int16_t y, uint16_t width, uint16_t height)
+{
+    cairo_rectangle_int_t rect = { x, y, width, height };
+
+    expose_stats.events++;
+    if(!window->exposed)
+        window->exposed = cairo_region_create();
+    cairo_region_union_rectangle(window->exposed, &rect);
+    window_need_refresh(window);
+}
+
+/** Repaint the exposed parts of a window that are inside of an area.
+ * The caller has to flush the pixmap's cairo surface first.
+ * \param window The window object.
+ * \param pixmap The pixmap with the content of the area.
+ * \param area The part of the window that the pixmap covers.
+ */
+void
+window_expose_refresh(window_t *window, xcb_pixmap_t pixmap, area_t area)
+{
+    cairo_rectangle_int_t clip = { area.x, area.y, area.width, area.height };
+    cairo_region_t *region;
+
+    if(!window->exposed)
+        return;
+
+    region = cairo_region_copy(window->exposed);
+    cairo_region_intersect_rectangle(region, &clip);
+    for(int i = 0; i < cairo_region_num_rectangles(region); i++)
+    {
+        cairo_rectangle_int_t rect;
+        cairo_region_get_rectangle(region, i, &rect);
+        xcb_copy_area(globalconf.connection, pixmap, window_get(window),
+                      globalconf.gc, rect.x - area.x, rect.y - area.y,
+                      rect.x, rect.y, rect.width, rect.height);
+        expose_stats.copies++;
+    }
+    cairo_region_destroy(region);
+}
+
+/** Forget the exposed parts of a window, e.g. after they were repainted.
+ * \param window The window object.
+ */
+void
+window_expose_clear(window_t *window)
+{
+    if(window->exposed)
+        cairo_region_destroy(window->exposed);
+    window->exposed = NULL;
+}
+
+/** Push the expose statistics onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+window_push_expose_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 2);
+    lua_pushinteger(L, expose_stats.events);
+    lua_setfield(L, -2, "events");
+    lua_pushinteger(L, expose_stats.copies);
+    lua_setfield(L, -2, "copies");
+    return 1;
 }
 
 /** Get or set mouse buttons bindings on a window.
@@ -197,6 +293,7 @@ luaA_window_set_border_color(lua_State *L, window_t *window)
        color_init_reply(color_init_unchecked(&window->border_color, color_name, len, globalconf.visual)))
     {
         window->border_need_update = true;
+        window_need_refresh(window);
         luaA_object_emit_signal(L, -3, "property::border_color", 0);
     }
 
@@ -219,6 +316,7 @@ window_set_border_width(lua_State *L, int idx, int width)
 
     window->border_need_update = true;
     window->border_width = width;
+    window_need_refresh(window);
 
     if(window->border_width_callback)
         (*window->border_width_callback)(window, old_width, width);
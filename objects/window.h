@@ -23,6 +23,7 @@
 #define AWESOME_OBJECTS_WINDOW_H
 
 #include "color.h"
+#include "draw.h"
 #include "common/luaclass.h"
 #include "objects/button.h"
 #include "strut.h"
@@ -65,12 +66,22 @@ typedef enum
     button_array_t buttons; \
     /** Do we have pending border changes? */ \
     bool border_need_update; \
+    /** Parts of the window that have to be repainted, or NULL */ \
+    cairo_region_t *exposed; \
+    /** Is the window queued for the next refresh? */ \
+    bool refresh_queued; \
+    /** Queues the window for the next refresh */ \
+    void (*need_refresh_callback)(void *); \
     /** Border color */ \
     color_t border_color; \
     /** Border width */ \
     uint16_t border_width; \
     /** The window type */ \
     window_type_t type; \
+    /** Position in the stacking order that was last sent to the X server */ \
+    int stack_position; \
+    /** The restack that stack_position belongs to */ \
+    unsigned int stack_serial; \
     /** The border width callback */ \
     void (*border_width_callback)(void *, uint16_t old, uint16_t new);
 
@@ -87,6 +98,10 @@ void window_class_setup(lua_State *);
 void window_set_opacity(lua_State *, int, double);
 void window_set_border_width(lua_State *, int, int);
 void window_border_refresh(window_t *);
+void window_expose(window_t *, int16_t, int16_t, uint16_t, uint16_t);
+void window_expose_refresh(window_t *, xcb_pixmap_t, area_t);
+void window_expose_clear(window_t *);
+int window_push_expose_stats(lua_State *);
 int luaA_window_get_type(lua_State *, window_t *);
 int luaA_window_set_type(lua_State *, window_t *);
 uint32_t window_translate_type(window_type_t);
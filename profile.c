@@ -0,0 +1,274 @@
+/*
+ * profile.c - main loop profiling
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/**
+ * @module awesome
+ */
+
+#include "profile.h"
+#include "common/array.h"
+#include "common/lualib.h"
+#include "common/util.h"
+
+#include <glib.h>
+#include <stdio.h>
+
+/** Histogram bucket i counts durations below 2^i microseconds that do not
+ * fit into a smaller bucket. The last bucket also counts everything longer. */
+#define PROFILE_BUCKETS 24
+
+typedef struct
+{
+    char *name;
+    /** Number of samples */
+    unsigned long count;
+    /** Sum and maximum of the samples in seconds */
+    double total, max;
+    unsigned long histogram[PROFILE_BUCKETS];
+} profile_entry_t;
+
+static void
+profile_entry_wipe(profile_entry_t *entry)
+{
+    p_delete(&entry->name);
+}
+
+static int
+profile_entry_cmp(const void *a, const void *b)
+{
+    const profile_entry_t *x = a, *y = b;
+    return a_strcmp(x->name, y->name);
+}
+
+DO_BARRAY(profile_entry_t, profile_entry, profile_entry_wipe, profile_entry_cmp)
+
+static const char * const phase_names[PROFILE_PHASE_COUNT] =
+{
+    [PROFILE_ITERATION] = "iteration",
+    [PROFILE_EVENTS] = "events",
+    [PROFILE_SOURCES] = "sources",
+    [PROFILE_DBUS] = "dbus",
+    [PROFILE_SPAWN] = "spawn",
+    [PROFILE_PROPERTY] = "property",
+    [PROFILE_REFRESH_SIGNAL] = "refresh",
+    [PROFILE_DRAWINS] = "drawins",
+    [PROFILE_CLIENTS] = "clients",
+    [PROFILE_BANNING] = "banning",
+    [PROFILE_STACK] = "stack",
+    [PROFILE_DESTROY] = "destroy",
+};
+
+static profile_entry_t phases[PROFILE_PHASE_COUNT];
+/** Times reported from Lua with awesome.profile_record() */
+static profile_entry_array_t sections;
+/** Times of Lua functions called from C, only in detailed mode */
+static profile_entry_array_t callbacks;
+
+static void
+profile_entry_add(profile_entry_t *entry, double seconds)
+{
+    uint64_t us = MAX(seconds, 0) * 1e6;
+    int bucket = 0;
+
+    while(us && bucket < PROFILE_BUCKETS - 1)
+    {
+        us >>= 1;
+        bucket++;
+    }
+
+    entry->count++;
+    entry->total += seconds;
+    entry->max = MAX(entry->max, seconds);
+    entry->histogram[bucket]++;
+}
+
+static profile_entry_t *
+profile_entry_getbyname(profile_entry_array_t *arr, const char *name)
+{
+    profile_entry_t needle = { .name = (char *) name };
+    profile_entry_t *entry = profile_entry_array_lookup(arr, &needle);
+
+    if(!entry)
+    {
+        needle.name = a_strdup(name);
+        profile_entry_array_insert(arr, needle);
+        entry = profile_entry_array_lookup(arr, &needle);
+    }
+    return entry;
+}
+
+/** Get the current time for profiling.
+ * \return A monotonic timestamp in microseconds.
+ */
+int64_t
+profile_now(void)
+{
+    return g_get_monotonic_time();
+}
+
+/** Record the duration of a phase.
+ * \param phase The phase that just finished.
+ * \param start The profile_now() timestamp of when the phase started.
+ * \return The current time, which is the start of the following phase.
+ */
+int64_t
+profile_record(profile_phase_t phase, int64_t start)
+{
+    int64_t now = profile_now();
+    profile_entry_add(&phases[phase], (now - start) / 1e6);
+    return now;
+}
+
+/** Record the duration of a phase.
+ * \param phase The phase.
+ * \param seconds How long it took.
+ */
+void
+profile_record_seconds(profile_phase_t phase, double seconds)
+{
+    profile_entry_add(&phases[phase], seconds);
+}
+
+/** Called by luaA_dofunction() in detailed mode */
+static void
+profile_callback(const lua_Debug *ar, double seconds)
+{
+    char name[LUA_IDSIZE + 16];
+
+    snprintf(name, sizeof(name), "%s:%d", ar->short_src, ar->linedefined);
+    profile_entry_add(profile_entry_getbyname(&callbacks, name), seconds);
+}
+
+static void
+profile_entry_push(lua_State *L, profile_entry_t *entry)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, entry->count);
+    lua_setfield(L, -2, "count");
+    lua_pushnumber(L, entry->total);
+    lua_setfield(L, -2, "total");
+    lua_pushnumber(L, entry->max);
+    lua_setfield(L, -2, "max");
+    lua_createtable(L, PROFILE_BUCKETS, 0);
+    for(int i = 0; i < PROFILE_BUCKETS; i++)
+    {
+        lua_pushinteger(L, entry->histogram[i]);
+        lua_rawseti(L, -2, i + 1);
+    }
+    lua_setfield(L, -2, "histogram");
+}
+
+static void
+profile_entry_array_push(lua_State *L, profile_entry_array_t *arr)
+{
+    lua_createtable(L, 0, arr->len);
+    foreach(entry, *arr)
+    {
+        profile_entry_push(L, entry);
+        lua_setfield(L, -2, entry->name);
+    }
+}
+
+/** Push the main loop statistics onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+profile_push_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushstring(L, lualib_dofunction_profile ? "detailed" : "phases");
+    lua_setfield(L, -2, "mode");
+
+    lua_createtable(L, 0, PROFILE_PHASE_COUNT);
+    for(int i = 0; i < PROFILE_PHASE_COUNT; i++)
+    {
+        profile_entry_push(L, &phases[i]);
+        lua_setfield(L, -2, phase_names[i]);
+    }
+    lua_setfield(L, -2, "phases");
+
+    profile_entry_array_push(L, &sections);
+    lua_setfield(L, -2, "sections");
+    profile_entry_array_push(L, &callbacks);
+    lua_setfield(L, -2, "callbacks");
+    return 1;
+}
+
+/**
+ * Set how much detail the main loop statistics in `awesome.stats()` have.
+ *
+ * In the default `"phases"` mode only the phases of each main loop iteration
+ * are timed, which is cheap enough to be always on. The `"detailed"` mode
+ * additionally times every Lua function that is called from C, for example
+ * signal handlers, and reports it per function.
+ *
+ * @function set_profile_mode
+ * @tparam string mode Either `"phases"` or `"detailed"`.
+ */
+int
+luaA_set_profile_mode(lua_State *L)
+{
+    const char *mode = luaL_checkstring(L, 1);
+
+    if(A_STREQ(mode, "phases"))
+        lualib_dofunction_profile = NULL;
+    else if(A_STREQ(mode, "detailed"))
+        lualib_dofunction_profile = profile_callback;
+    else
+        luaL_error(L, "unknown profile mode: %s", mode);
+    return 0;
+}
+
+/**
+ * Add a time measured in Lua to the main loop statistics.
+ *
+ * @function profile_record
+ * @tparam string name The name of the section that was measured.
+ * @tparam number seconds How long it took.
+ */
+int
+luaA_profile_record(lua_State *L)
+{
+    const char *name = luaL_checkstring(L, 1);
+    double seconds = luaL_checknumber(L, 2);
+
+    profile_entry_add(profile_entry_getbyname(&sections, name), seconds);
+    return 0;
+}
+
+/**
+ * Forget all main loop statistics collected so far.
+ *
+ * @function profile_reset
+ */
+int
+luaA_profile_reset(lua_State *L)
+{
+    p_clear(phases, countof(phases));
+    profile_entry_array_wipe(&sections);
+    profile_entry_array_init(&sections);
+    profile_entry_array_wipe(&callbacks);
+    profile_entry_array_init(&callbacks);
+    return 0;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,63 @@
+/*
+ * profile.h - main loop profiling header
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#ifndef AWESOME_PROFILE_H
+#define AWESOME_PROFILE_H
+
+#include <lua.h>
+#include <stdint.h>
+
+/** The parts of a main loop iteration that are timed */
+typedef enum
+{
+    /** A complete iteration, without the time spent sleeping */
+    PROFILE_ITERATION,
+    /** Handling X11 events */
+    PROFILE_EVENTS,
+    /** Dispatching GLib sources: timers, D-Bus, spawn IO, ... */
+    PROFILE_SOURCES,
+    /** The part of PROFILE_SOURCES spent handling D-Bus messages */
+    PROFILE_DBUS,
+    /** The part of PROFILE_SOURCES spent on output and exits of spawned
+     * processes */
+    PROFILE_SPAWN,
+    /** The stages of awesome_refresh() */
+    PROFILE_PROPERTY,
+    PROFILE_REFRESH_SIGNAL,
+    PROFILE_DRAWINS,
+    PROFILE_CLIENTS,
+    PROFILE_BANNING,
+    PROFILE_STACK,
+    PROFILE_DESTROY,
+    PROFILE_PHASE_COUNT
+} profile_phase_t;
+
+int64_t profile_now(void);
+int64_t profile_record(profile_phase_t, int64_t);
+void profile_record_seconds(profile_phase_t, double);
+
+int profile_push_stats(lua_State *);
+int luaA_profile_record(lua_State *);
+int luaA_profile_reset(lua_State *);
+int luaA_set_profile_mode(lua_State *);
+
+#endif
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
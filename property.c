@@ -30,14 +30,113 @@
 #include "xwindow.h"
 
 #include <xcb/xcb_atom.h>
+#include <xcb/xcbext.h>
 
-#define HANDLE_TEXT_PROPERTY(funcname, atom, setfunc) \
+typedef xcb_get_property_cookie_t (*property_get_t)(xcb_window_t);
+typedef void (*property_update_t)(client_t *, xcb_get_property_cookie_t);
+
+/** The client properties that are fetched in batches, each has a bit in
+ * client_t's dirty_properties */
+typedef enum
+{
+    PROPERTY_WM_NAME,
+    PROPERTY_NET_WM_NAME,
+    PROPERTY_WM_ICON_NAME,
+    PROPERTY_NET_WM_ICON_NAME,
+    PROPERTY_WM_CLIENT_MACHINE,
+    PROPERTY_WM_WINDOW_ROLE,
+    PROPERTY_WM_PROTOCOLS,
+    PROPERTY_WM_TRANSIENT_FOR,
+    PROPERTY_WM_CLIENT_LEADER,
+    PROPERTY_WM_NORMAL_HINTS,
+    PROPERTY_WM_HINTS,
+    PROPERTY_WM_CLASS,
+    PROPERTY_NET_WM_ICON,
+    PROPERTY_NET_WM_PID,
+    PROPERTY_MOTIF_WM_HINTS,
+    PROPERTY_NET_WM_STRUT_PARTIAL
+} property_id_t;
+
+/** A client property that changed and still has to be fetched */
+typedef struct
+{
+    xcb_window_t window;
+    property_id_t id;
+    /** Functions for requesting and applying the property */
+    property_get_t get;
+    property_update_t update;
+    xcb_get_property_cookie_t cookie;
+} property_pending_t;
+
+DO_ARRAY(property_pending_t, property_pending, DO_NOTHING)
+
+/** Client properties are not fetched when their PropertyNotify arrives.
+ * Instead, all changes seen during one main loop iteration are collected
+ * without duplicates and requested together in property_refresh(). The replies
+ * are applied during a later iteration, once the fence request sent after the
+ * batch got its reply, so that the main loop never waits for the X server.
+ */
+static struct
+{
+    /** Changed properties that were not requested yet */
+    property_pending_array_t dirty;
+    /** Properties that were requested, but whose replies are not applied yet */
+    property_pending_array_t in_flight;
+    /** Request sent after the in-flight batch; once its reply is there, all
+     * replies of the batch are there */
+    xcb_get_input_focus_cookie_t fence;
+    bool fence_done;
+} property_queue;
+
+static struct
+{
+    /** PropertyNotify events for client properties */
+    unsigned int notifies;
+    /** Notifies that were merged into an already dirty property */
+    unsigned int coalesced;
+    /** GetProperty requests sent */
+    unsigned int fetched;
+    /** Batches of requests sent */
+    unsigned int batches;
+} property_stats;
+
+/** Remember that a client property changed. The client's dirty_properties
+ * tell if the property is already queued, so that a storm of changes costs
+ * the same for every notify.
+ * \param window The window whose property changed.
+ * \param id Which property changed.
+ * \param get The function requesting the property.
+ * \param update The function applying the property to the client.
+ */
+static void
+property_mark_dirty(xcb_window_t window, property_id_t id,
+                    property_get_t get, property_update_t update)
+{
+    client_t *c = client_getbywin(window);
+    if(!c)
+        return;
+
+    property_stats.notifies++;
+
+    if(c->dirty_properties & (1u << id))
+    {
+        property_stats.coalesced++;
+        return;
+    }
+    c->dirty_properties |= 1u << id;
+
+    property_pending_array_append(&property_queue.dirty,
+            (property_pending_t) { .window = window, .id = id,
+                                   .get = get, .update = update });
+}
+
+#define HANDLE_TEXT_PROPERTY(funcname, id, atom, setfunc) \
     xcb_get_property_cookie_t \
-    property_get_##funcname(client_t *c) \
+    property_get_##funcname(xcb_window_t window) \
     { \
         return xcb_get_property(globalconf.connection, \
                                 false, \
-                                c->window, \
+                                window, \
                                 atom, \
                                 XCB_GET_PROPERTY_TYPE_ANY, \
                                 0, \
@@ -58,47 +157,45 @@
     property_handle_##funcname(uint8_t state, \
                                xcb_window_t window) \
     { \
-        client_t *c = client_getbywin(window); \
-        if(c) \
-            property_update_##funcname(c, property_get_##funcname(c));\
+        property_mark_dirty(window, id, property_get_##funcname, \
+                            property_update_##funcname); \
     }
 
 
-HANDLE_TEXT_PROPERTY(wm_name, XCB_ATOM_WM_NAME, client_set_alt_name)
-HANDLE_TEXT_PROPERTY(net_wm_name, _NET_WM_NAME, client_set_name)
-HANDLE_TEXT_PROPERTY(wm_icon_name, XCB_ATOM_WM_ICON_NAME, client_set_alt_icon_name)
-HANDLE_TEXT_PROPERTY(net_wm_icon_name, _NET_WM_ICON_NAME, client_set_icon_name)
-HANDLE_TEXT_PROPERTY(wm_client_machine, XCB_ATOM_WM_CLIENT_MACHINE, client_set_machine)
-HANDLE_TEXT_PROPERTY(wm_window_role, WM_WINDOW_ROLE, client_set_role)
+HANDLE_TEXT_PROPERTY(wm_name, PROPERTY_WM_NAME, XCB_ATOM_WM_NAME, client_set_alt_name)
+HANDLE_TEXT_PROPERTY(net_wm_name, PROPERTY_NET_WM_NAME, _NET_WM_NAME, client_set_name)
+HANDLE_TEXT_PROPERTY(wm_icon_name, PROPERTY_WM_ICON_NAME, XCB_ATOM_WM_ICON_NAME, client_set_alt_icon_name)
+HANDLE_TEXT_PROPERTY(net_wm_icon_name, PROPERTY_NET_WM_ICON_NAME, _NET_WM_ICON_NAME, client_set_icon_name)
+HANDLE_TEXT_PROPERTY(wm_client_machine, PROPERTY_WM_CLIENT_MACHINE, XCB_ATOM_WM_CLIENT_MACHINE, client_set_machine)
+HANDLE_TEXT_PROPERTY(wm_window_role, PROPERTY_WM_WINDOW_ROLE, WM_WINDOW_ROLE, client_set_role)
 
 #undef HANDLE_TEXT_PROPERTY
 
-#define HANDLE_PROPERTY(name) \
+#define HANDLE_PROPERTY(name, id) \
     static void \
     property_handle_##name(uint8_t state, \
                            xcb_window_t window) \
     { \
-        client_t *c = client_getbywin(window); \
-        if(c) \
-            property_update_##name(c, property_get_##name(c));\
+        property_mark_dirty(window, id, property_get_##name, \
+                            property_update_##name); \
     }
 
-HANDLE_PROPERTY(wm_protocols)
-HANDLE_PROPERTY(wm_transient_for)
-HANDLE_PROPERTY(wm_client_leader)
-HANDLE_PROPERTY(wm_normal_hints)
-HANDLE_PROPERTY(wm_hints)
-HANDLE_PROPERTY(wm_class)
-HANDLE_PROPERTY(net_wm_icon)
-HANDLE_PROPERTY(net_wm_pid)
-HANDLE_PROPERTY(motif_wm_hints)
+HANDLE_PROPERTY(wm_protocols, PROPERTY_WM_PROTOCOLS)
+HANDLE_PROPERTY(wm_transient_for, PROPERTY_WM_TRANSIENT_FOR)
+HANDLE_PROPERTY(wm_client_leader, PROPERTY_WM_CLIENT_LEADER)
+HANDLE_PROPERTY(wm_normal_hints, PROPERTY_WM_NORMAL_HINTS)
+HANDLE_PROPERTY(wm_hints, PROPERTY_WM_HINTS)
+HANDLE_PROPERTY(wm_class, PROPERTY_WM_CLASS)
+HANDLE_PROPERTY(net_wm_icon, PROPERTY_NET_WM_ICON)
+HANDLE_PROPERTY(net_wm_pid, PROPERTY_NET_WM_PID)
+HANDLE_PROPERTY(motif_wm_hints, PROPERTY_MOTIF_WM_HINTS)
 
 #undef HANDLE_PROPERTY
 
 xcb_get_property_cookie_t
-property_get_wm_transient_for(client_t *c)
+property_get_wm_transient_for(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_transient_for_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_transient_for_unchecked(globalconf.connection, window);
 }
 
 void
@@ -128,9 +225,9 @@ property_update_wm_transient_for(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_client_leader(client_t *c)
+property_get_wm_client_leader(xcb_window_t window)
 {
-    return xcb_get_property_unchecked(globalconf.connection, false, c->window,
+    return xcb_get_property_unchecked(globalconf.connection, false, window,
                                       WM_CLIENT_LEADER, XCB_ATOM_WINDOW, 0, 32);
 }
 
@@ -153,9 +250,9 @@ property_update_wm_client_leader(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_normal_hints(client_t *c)
+property_get_wm_normal_hints(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_normal_hints_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_normal_hints_unchecked(globalconf.connection, window);
 }
 
 /** Update the size hints of a client.
@@ -177,9 +274,9 @@ property_update_wm_normal_hints(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_hints(client_t *c)
+property_get_wm_hints(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_hints_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_hints_unchecked(globalconf.connection, window);
 }
 
 /** Update the WM hints of a client.
@@ -223,9 +320,9 @@ property_update_wm_hints(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_class(client_t *c)
+property_get_wm_class(xcb_window_t window)
 {
-    return xcb_icccm_get_wm_class_unchecked(globalconf.connection, c->window);
+    return xcb_icccm_get_wm_class_unchecked(globalconf.connection, window);
 }
 
 /** Update WM_CLASS of a client.
@@ -254,16 +351,15 @@ static void
 property_handle_net_wm_strut_partial(uint8_t state,
                                      xcb_window_t window)
 {
-    client_t *c = client_getbywin(window);
-
-    if(c)
-        ewmh_process_client_strut(c);
+    property_mark_dirty(window, PROPERTY_NET_WM_STRUT_PARTIAL,
+                        ewmh_client_strut_get_unchecked,
+                        ewmh_process_client_strut_reply);
 }
 
 xcb_get_property_cookie_t
-property_get_net_wm_icon(client_t *c)
+property_get_net_wm_icon(xcb_window_t window)
 {
-    return ewmh_window_icon_get_unchecked(c->window);
+    return ewmh_window_icon_get_unchecked(window);
 }
 
 void
@@ -280,9 +376,9 @@ property_update_net_wm_icon(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_net_wm_pid(client_t *c)
+property_get_net_wm_pid(xcb_window_t window)
 {
-    return xcb_get_property_unchecked(globalconf.connection, false, c->window, _NET_WM_PID, XCB_ATOM_CARDINAL, 0L, 1L);
+    return xcb_get_property_unchecked(globalconf.connection, false, window, _NET_WM_PID, XCB_ATOM_CARDINAL, 0L, 1L);
 }
 
 void
@@ -308,9 +404,9 @@ property_update_net_wm_pid(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_motif_wm_hints(client_t *c)
+property_get_motif_wm_hints(xcb_window_t window)
 {
-    return xcb_get_property_unchecked(globalconf.connection, false, c->window, _MOTIF_WM_HINTS, _MOTIF_WM_HINTS, 0L, 5L);
+    return xcb_get_property_unchecked(globalconf.connection, false, window, _MOTIF_WM_HINTS, _MOTIF_WM_HINTS, 0L, 5L);
 }
 
 void
@@ -343,10 +439,10 @@ property_update_motif_wm_hints(client_t *c, xcb_get_property_cookie_t cookie)
 }
 
 xcb_get_property_cookie_t
-property_get_wm_protocols(client_t *c)
+property_get_wm_protocols(xcb_window_t window)
 {
     return xcb_icccm_get_wm_protocols_unchecked(globalconf.connection,
-						c->window, WM_PROTOCOLS);
+						window, WM_PROTOCOLS);
 }
 
 /** Update the list of supported protocols for a client.
@@ -530,6 +626,102 @@ property_handle_propertynotify(xcb_property_notify_event_t *ev)
     (*handler)(ev->state, ev->window);
 }
 
+/** Check whether the replies of the in-flight batch are all there.
+ * \return true if property_refresh() can apply the batch without blocking.
+ */
+bool
+property_replies_ready(void)
+{
+    if(property_queue.in_flight.len == 0)
+        return false;
+
+    if(!property_queue.fence_done)
+    {
+        void *reply = NULL;
+        xcb_generic_error_t *error = NULL;
+        if(!xcb_poll_for_reply(globalconf.connection, property_queue.fence.sequence,
+                               &reply, &error))
+            return false;
+        p_delete(&reply);
+        p_delete(&error);
+        property_queue.fence_done = true;
+    }
+
+    return true;
+}
+
+/** Apply the client properties whose replies arrived and request the ones that
+ * changed since the last call.
+ */
+void
+property_refresh(void)
+{
+    if(property_replies_ready())
+    {
+        property_pending_array_t batch = property_queue.in_flight;
+        property_pending_array_init(&property_queue.in_flight);
+
+        foreach(p, batch)
+        {
+            /* The client might have been unmanaged in the meantime */
+            client_t *c = client_getbywin(p->window);
+            if(c)
+                p->update(c, p->cookie);
+            else
+                xcb_discard_reply(globalconf.connection, p->cookie.sequence);
+        }
+
+        property_pending_array_wipe(&batch);
+    }
+
+    /* Only one batch at a time, so that replies are applied in order */
+    if(property_queue.in_flight.len > 0 || property_queue.dirty.len == 0)
+        return;
+
+    property_pending_array_t batch = property_queue.dirty;
+    property_pending_array_init(&property_queue.dirty);
+
+    foreach(p, batch)
+    {
+        /* Skip clients that were unmanaged since the property changed */
+        client_t *c = client_getbywin(p->window);
+        if(c)
+        {
+            c->dirty_properties &= ~(1u << p->id);
+            p->cookie = p->get(p->window);
+            property_pending_array_append(&property_queue.in_flight, *p);
+        }
+    }
+    property_pending_array_wipe(&batch);
+
+    if(property_queue.in_flight.len == 0)
+        return;
+
+    property_stats.fetched += property_queue.in_flight.len;
+    property_stats.batches++;
+    property_queue.fence = xcb_get_input_focus_unchecked(globalconf.connection);
+    property_queue.fence_done = false;
+}
+
+/** Push a table with statistics about property fetching.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+property_push_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, property_stats.notifies);
+    lua_setfield(L, -2, "notifies");
+    lua_pushinteger(L, property_stats.coalesced);
+    lua_setfield(L, -2, "coalesced");
+    lua_pushinteger(L, property_stats.fetched);
+    lua_setfield(L, -2, "fetched");
+    lua_pushinteger(L, property_stats.batches);
+    lua_setfield(L, -2, "batches");
+    return 1;
+}
+
 /** Register a new xproperty.
  * \param L The Lua VM state.
  * \return The number of elements pushed on stack.
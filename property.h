@@ -25,7 +25,7 @@
 #include "objects/client.h"
 
 #define PROPERTY(funcname) \
-    xcb_get_property_cookie_t property_get_##funcname(client_t *c); \
+    xcb_get_property_cookie_t property_get_##funcname(xcb_window_t window); \
     void property_update_##funcname(client_t *c, xcb_get_property_cookie_t cookie)
 
 PROPERTY(wm_name);
@@ -47,6 +47,9 @@ PROPERTY(motif_wm_hints);
 #undef PROPERTY
 
 void property_handle_propertynotify(xcb_property_notify_event_t *ev);
+bool property_replies_ready(void);
+void property_refresh(void);
+int property_push_stats(lua_State *L);
 int luaA_register_xproperty(lua_State *L);
 int luaA_set_xproperty(lua_State *L);
 int luaA_get_xproperty(lua_State *L);
@@ -73,8 +73,14 @@ root_set_wallpaper_pixmap(xcb_connection_t *c, xcb_pixmap_t p)
     p_delete(&prop_r);
 }
 
+/** Create a new wallpaper pixmap, paint it and make it the root window's
+ * background.
+ * \param paint Function painting the new wallpaper.
+ * \param data Argument for paint.
+ * \return true on success.
+ */
 static bool
-root_set_wallpaper(cairo_pattern_t *pattern)
+root_install_wallpaper(void (*paint)(cairo_t *, void *), void *data)
 {
     lua_State *L = globalconf_get_lua_State();
     xcb_connection_t *c = xcb_connect(NULL, NULL);
@@ -105,10 +111,7 @@ root_set_wallpaper(cairo_pattern_t *pattern)
      */
     surface = cairo_xcb_surface_create(globalconf.connection, p, draw_default_visual(screen), width, height);
     cr = cairo_create(surface);
-    /* Paint the pattern to the surface */
-    cairo_set_source(cr, pattern);
-    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
-    cairo_paint(cr);
+    paint(cr, data);
     cairo_destroy(cr);
     cairo_surface_flush(surface);
     xcb_aux_sync(globalconf.connection);
@@ -141,6 +144,214 @@ disconnect:
     return result;
 }
 
+static void
+root_paint_pattern(cairo_t *cr, void *data)
+{
+    cairo_set_source(cr, data);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_paint(cr);
+}
+
+static bool
+root_set_wallpaper(cairo_pattern_t *pattern)
+{
+    return root_install_wallpaper(root_paint_pattern, pattern);
+}
+
+/** How an image is placed on the area of an asynchronous wallpaper. These
+ * match the functions in gears.wallpaper. */
+typedef enum
+{
+    WALLPAPER_MAXIMIZED,
+    WALLPAPER_FIT,
+    WALLPAPER_CENTERED,
+    WALLPAPER_TILED
+} wallpaper_mode_t;
+
+/** An asynchronous wallpaper request. Everything except result and error is
+ * set up on the main thread and only read by the worker. */
+typedef struct
+{
+    /** The id handed out to Lua */
+    int id;
+    /** The file to load or NULL */
+    char *path;
+    /** The image to use if path is NULL, always an image surface */
+    cairo_surface_t *image;
+    /** The background, never a surface pattern, or NULL */
+    cairo_pattern_t *background;
+    /** The part of the root window to draw to */
+    area_t area;
+    wallpaper_mode_t mode;
+    bool ignore_aspect;
+    bool has_offset;
+    double offset_x, offset_y;
+    double scale;
+    /** The rendered wallpaper for area, set by the worker */
+    cairo_surface_t *result;
+    /** Why rendering failed, set by the worker */
+    char *error;
+} wallpaper_job_t;
+
+static void
+wallpaper_job_delete(wallpaper_job_t **job)
+{
+    p_delete(&(*job)->path);
+    if ((*job)->image)
+        cairo_surface_destroy((*job)->image);
+    if ((*job)->background)
+        cairo_pattern_destroy((*job)->background);
+    if ((*job)->result)
+        cairo_surface_destroy((*job)->result);
+    p_delete(&(*job)->error);
+    p_delete(job);
+}
+
+/** Decode and scale the image of a wallpaper job. This runs in a worker
+ * thread and must not touch Lua, the X11 connection or globalconf.
+ * \param job The job.
+ */
+static void
+wallpaper_job_render(wallpaper_job_t *job)
+{
+    cairo_surface_t *image = job->image;
+    double width = job->area.width, height = job->area.height;
+
+    if (job->path)
+    {
+        GError *error = NULL;
+        image = draw_load_image(NULL, job->path, &error);
+        if (!image)
+        {
+            job->error = a_strdup(error->message);
+            g_error_free(error);
+            return;
+        }
+    }
+    else if (!image)
+    {
+        job->error = a_strdup("no image given");
+        return;
+    }
+
+    double w = cairo_image_surface_get_width(image);
+    double h = cairo_image_surface_get_height(image);
+    job->result = cairo_image_surface_create(CAIRO_FORMAT_RGB24, width, height);
+    cairo_t *cr = cairo_create(job->result);
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+
+    if (job->background)
+    {
+        cairo_set_source(cr, job->background);
+        cairo_paint(cr);
+    }
+
+    switch (job->mode)
+    {
+      case WALLPAPER_MAXIMIZED:
+        {
+            double aspect_w = width / w, aspect_h = height / h;
+            if (!job->ignore_aspect)
+                aspect_w = aspect_h = MAX(aspect_w, aspect_h);
+            cairo_scale(cr, aspect_w, aspect_h);
+            if (job->has_offset)
+                cairo_translate(cr, job->offset_x, job->offset_y);
+            else if (!job->ignore_aspect)
+                cairo_translate(cr, (width / aspect_w - w) / 2, (height / aspect_h - h) / 2);
+            cairo_set_source_surface(cr, image, 0, 0);
+        }
+        break;
+      case WALLPAPER_FIT:
+      case WALLPAPER_CENTERED:
+        {
+            double scale = job->scale;
+            if (job->mode == WALLPAPER_FIT)
+            {
+                scale = width / w;
+                if (h * scale > height)
+                    scale = height / h;
+            }
+            cairo_translate(cr, (width - w * scale) / 2, (height - h * scale) / 2);
+            cairo_rectangle(cr, 0, 0, w * scale, h * scale);
+            cairo_clip(cr);
+            cairo_scale(cr, scale, scale);
+            cairo_set_source_surface(cr, image, 0, 0);
+        }
+        break;
+      case WALLPAPER_TILED:
+        if (job->has_offset)
+            cairo_translate(cr, job->offset_x, job->offset_y);
+        cairo_set_source_surface(cr, image, 0, 0);
+        cairo_pattern_set_extend(cairo_get_source(cr), CAIRO_EXTEND_REPEAT);
+        break;
+    }
+    cairo_paint(cr);
+
+    if (cairo_status(cr) != CAIRO_STATUS_SUCCESS)
+        job->error = a_strdup(cairo_status_to_string(cairo_status(cr)));
+    cairo_destroy(cr);
+    cairo_surface_flush(job->result);
+
+    if (image != job->image)
+        cairo_surface_destroy(image);
+}
+
+static void
+root_paint_job(cairo_t *cr, void *data)
+{
+    wallpaper_job_t *job = data;
+
+    /* Keep what the old wallpaper shows outside of the job's area */
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    if (globalconf.wallpaper)
+        cairo_set_source_surface(cr, globalconf.wallpaper, 0, 0);
+    else
+        cairo_set_source_rgb(cr, 0, 0, 0);
+    cairo_paint(cr);
+
+    cairo_set_source_surface(cr, job->result, job->area.x, job->area.y);
+    cairo_rectangle(cr, job->area.x, job->area.y, job->area.width, job->area.height);
+    cairo_fill(cr);
+}
+
+/** Install the result of a finished wallpaper job. This runs in the main loop.
+ * \param data The job.
+ * \return G_SOURCE_REMOVE.
+ */
+static gboolean
+root_wallpaper_job_done(gpointer data)
+{
+    wallpaper_job_t *job = data;
+    lua_State *L = globalconf_get_lua_State();
+    bool ok = false;
+
+    if (!job->error && job->result)
+    {
+        ok = root_install_wallpaper(root_paint_job, job);
+        if (!ok)
+            job->error = a_strdup("cannot connect to the X server");
+    }
+
+    lua_pushinteger(L, job->id);
+    lua_pushboolean(L, ok);
+    if (job->error)
+        lua_pushstring(L, job->error);
+    else
+        lua_pushnil(L);
+    signal_object_emit(L, &global_signals, "wallpaper_ready", 3);
+
+    wallpaper_job_delete(&job);
+    return G_SOURCE_REMOVE;
+}
+
+static gpointer
+root_wallpaper_worker(gpointer data)
+{
+    wallpaper_job_render(data);
+    g_idle_add(root_wallpaper_job_done, data);
+    return NULL;
+}
+
 void
 root_update_wallpaper(void)
 {
@@ -348,6 +559,7 @@ luaA_root_keys(lua_State *L)
 
         key_array_wipe(&globalconf.keys);
         key_array_init(&globalconf.keys);
+        key_index_invalidate();
 
         lua_pushnil(L);
         while(lua_next(L, 1))
@@ -480,6 +692,122 @@ luaA_root_wallpaper(lua_State *L)
     return 1;
 }
 
+/** Set the wallpaper from an image without blocking.
+ *
+ * The image is loaded, scaled and drawn in a separate thread. Only uploading
+ * the result and replacing the wallpaper happens in the main loop, and the
+ * old wallpaper stays visible until then. Afterwards `wallpaper_ready` is
+ * emitted with the returned id.
+ *
+ * @tparam table args
+ * @tparam[opt] string args.path The image file to load.
+ * @param[opt] args.surface An image as a cairo surface (light userdata), used
+ *  when no path is given.
+ * @tparam[opt] string args.mode One of "maximized" (the default), "fit",
+ *  "centered" or "tiled". See `gears.wallpaper`.
+ * @param[opt] args.background A cairo pattern (light userdata) to fill the
+ *  area with first. It must not contain surfaces.
+ * @tparam[opt] integer args.x The area of the root window to set, defaults to
+ *  all of it.
+ * @tparam[opt] integer args.y
+ * @tparam[opt] integer args.width
+ * @tparam[opt] integer args.height
+ * @tparam[opt=false] boolean args.ignore_aspect For "maximized".
+ * @tparam[opt] number args.offset_x For "maximized" and "tiled".
+ * @tparam[opt] number args.offset_y For "maximized" and "tiled".
+ * @tparam[opt=1] number args.scale For "centered".
+ * @treturn integer The id of this request.
+ * @function wallpaper_async
+ */
+static int
+luaA_root_wallpaper_async(lua_State *L)
+{
+    static int next_id = 0;
+    const xcb_screen_t *screen = globalconf.screen;
+    wallpaper_mode_t mode;
+    cairo_surface_t *surface = NULL;
+    cairo_pattern_t *background;
+    const char *path, *mode_name;
+    area_t area;
+
+    luaA_checktable(L, 1);
+
+    /* Check all arguments before allocating anything, these can throw errors */
+    lua_getfield(L, 1, "mode");
+    mode_name = luaL_optstring(L, -1, "maximized");
+    if (A_STREQ(mode_name, "maximized"))
+        mode = WALLPAPER_MAXIMIZED;
+    else if (A_STREQ(mode_name, "fit"))
+        mode = WALLPAPER_FIT;
+    else if (A_STREQ(mode_name, "centered"))
+        mode = WALLPAPER_CENTERED;
+    else if (A_STREQ(mode_name, "tiled"))
+        mode = WALLPAPER_TILED;
+    else
+        return luaL_error(L, "unknown wallpaper mode '%s'", mode_name);
+    lua_pop(L, 1);
+
+    area.x = luaA_getopt_integer_range(L, 1, "x", 0, 0, screen->width_in_pixels - 1);
+    area.y = luaA_getopt_integer_range(L, 1, "y", 0, 0, screen->height_in_pixels - 1);
+    area.width = luaA_getopt_integer_range(L, 1, "width", screen->width_in_pixels - area.x,
+                                           1, screen->width_in_pixels - area.x);
+    area.height = luaA_getopt_integer_range(L, 1, "height", screen->height_in_pixels - area.y,
+                                            1, screen->height_in_pixels - area.y);
+
+    lua_getfield(L, 1, "background");
+    background = lua_touserdata(L, -1);
+    lua_pop(L, 1);
+    if (background && cairo_pattern_get_type(background) == CAIRO_PATTERN_TYPE_SURFACE)
+        return luaL_error(L, "wallpaper_async background must not be a surface pattern");
+
+    /* path stays valid while it is in the table */
+    lua_getfield(L, 1, "path");
+    path = luaL_optstring(L, -1, NULL);
+    lua_pop(L, 1);
+    if (!path)
+    {
+        lua_getfield(L, 1, "surface");
+        surface = lua_touserdata(L, -1);
+        lua_pop(L, 1);
+        if (!surface)
+            return luaL_error(L, "wallpaper_async needs a path or a surface");
+    }
+
+    wallpaper_job_t *job = p_new(wallpaper_job_t, 1);
+    job->id = ++next_id;
+    job->path = a_strdup(path);
+    job->mode = mode;
+    job->area = area;
+    if (background)
+        job->background = cairo_pattern_reference(background);
+    /* The worker may only use image surfaces, anything else has to be read
+     * back here */
+    if (surface && cairo_surface_get_type(surface) == CAIRO_SURFACE_TYPE_IMAGE)
+        job->image = cairo_surface_reference(surface);
+    else if (surface)
+        job->image = draw_dup_image_surface(surface);
+
+    lua_getfield(L, 1, "ignore_aspect");
+    job->ignore_aspect = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    lua_getfield(L, 1, "offset_x");
+    lua_getfield(L, 1, "offset_y");
+    job->has_offset = lua_isnumber(L, -2) || lua_isnumber(L, -1);
+    job->offset_x = lua_tonumber(L, -2);
+    job->offset_y = lua_tonumber(L, -1);
+    lua_pop(L, 2);
+
+    lua_getfield(L, 1, "scale");
+    job->scale = lua_isnumber(L, -1) && lua_tonumber(L, -1) > 0 ? lua_tonumber(L, -1) : 1;
+    lua_pop(L, 1);
+
+    lua_pushinteger(L, job->id);
+    g_thread_unref(g_thread_new("awesome-wallpaper", root_wallpaper_worker, job));
+
+    return 1;
+}
+
 /** Get the size of the root window.
  *
  * @return Width of the root window.
@@ -508,6 +836,27 @@ luaA_root_size_mm(lua_State *L)
     return 2;
 }
 
+/** Get the content of the root window, as it is currently shown on screen.
+ *
+ * @return A cairo surface with the content as light user datum.
+ * @function content
+ */
+static int
+luaA_root_get_content(lua_State *L)
+{
+    cairo_surface_t *surface;
+
+    surface = cairo_xcb_surface_create(globalconf.connection,
+                                       globalconf.screen->root,
+                                       globalconf.default_visual,
+                                       globalconf.screen->width_in_pixels,
+                                       globalconf.screen->height_in_pixels);
+
+    /* lua has to make sure to free the ref or we have a leak */
+    lua_pushlightuserdata(L, surface);
+    return 1;
+}
+
 /** Get the attached tags.
  * @return A table with all tags.
  * @function tags
@@ -533,9 +882,11 @@ const struct luaL_Reg awesome_root_lib[] =
     { "fake_input", luaA_root_fake_input },
     { "drawins", luaA_root_drawins },
     { "wallpaper", luaA_root_wallpaper },
+    { "wallpaper_async", luaA_root_wallpaper_async },
     { "size", luaA_root_size },
     { "size_mm", luaA_root_size_mm },
     { "tags", luaA_root_tags },
+    { "content", luaA_root_get_content },
     { "__index", luaA_default_index },
     { "__newindex", luaA_default_newindex },
     { NULL, NULL }
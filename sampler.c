@@ -0,0 +1,933 @@
+/*
+ * sampler.c - system statistics sampler
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/** Read system statistics without spawning processes.
+ *
+ * Widgets showing the CPU load, memory usage, network traffic, battery or
+ * temperatures usually poll a shell command every few seconds. The sampler
+ * instead keeps the relevant files in `/proc` and `/sys` open, reads all of
+ * them together on one shared tick and passes the parsed values to Lua.
+ *
+ * The following sources exist. Each subscriber gets a table with the values
+ * of its source and an `interval` field with the time in seconds since the
+ * previous sample.
+ *
+ * * *cpu*: Entry `0` is the sum of all CPUs, entry `n` is the `n`-th CPU.
+ *   Each is a table with the jiffies spent in `user`, `nice`, `system`,
+ *   `idle`, `iowait`, `irq`, `softirq` and `steal` since the previous sample,
+ *   and `usage`, the fraction of that time that was not spent idle.
+ * * *memory*: All fields from `/proc/meminfo` in kB, for example `MemTotal`
+ *   and `MemAvailable`.
+ * * *network*: For each interface, a table with `rx_bytes`, `tx_bytes`,
+ *   `rx_packets` and `tx_packets` since the previous sample and the totals
+ *   `rx_total` and `tx_total`.
+ * * *power_supply*: For each power supply, a table with the available ones of
+ *   `type`, `status`, `online`, `capacity`, `energy_now`, `energy_full` and
+ *   `power_now`.
+ * * *hwmon*: For each hardware monitor, a table with its `name` and a
+ *   `temperatures` list of tables with `label` and `celsius`.
+ *
+ * @usage
+ * sampler.subscribe("cpu", function(cpu)
+ *     mycpuwidget:set_value(cpu[0].usage)
+ * end)
+ *
+ * @author awesome developers
+ * @copyright 2026 awesome developers
+ * @module sampler
+ */
+
+#include "sampler.h"
+#include "globalconf.h"
+#include "luaa.h"
+#include "common/buffer.h"
+
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include <glib.h>
+
+/** Default time between two samples in milliseconds */
+#define SAMPLER_DEFAULT_INTERVAL 2000
+
+typedef enum
+{
+    SAMPLER_CPU,
+    SAMPLER_MEMORY,
+    SAMPLER_NETWORK,
+    SAMPLER_POWER_SUPPLY,
+    SAMPLER_HWMON,
+    SAMPLER_SOURCE_COUNT
+} sampler_source_t;
+
+static const char *const sampler_source_names[] =
+{
+    [SAMPLER_CPU]          = "cpu",
+    [SAMPLER_MEMORY]       = "memory",
+    [SAMPLER_NETWORK]      = "network",
+    [SAMPLER_POWER_SUPPLY] = "power_supply",
+    [SAMPLER_HWMON]        = "hwmon",
+};
+
+/** A file that is kept open and re-read on every sample */
+typedef struct
+{
+    int fd;
+    buffer_t content;
+} sampler_file_t;
+
+/** A sysfs attribute of a device */
+typedef struct
+{
+    /** The name of the device's directory, e.g. BAT0 */
+    char *device;
+    /** The name of the attribute, e.g. capacity */
+    char *attribute;
+    /** Label for temperatures or the hwmon name, read once when the device
+     * is found */
+    char *label;
+    sampler_file_t file;
+} sampler_attribute_t;
+
+static void
+sampler_attribute_wipe(sampler_attribute_t *attr)
+{
+    p_delete(&attr->device);
+    p_delete(&attr->attribute);
+    p_delete(&attr->label);
+    if(attr->file.fd >= 0)
+        close(attr->file.fd);
+    buffer_wipe(&attr->file.content);
+}
+
+DO_ARRAY(sampler_attribute_t, sampler_attribute, sampler_attribute_wipe)
+
+/** Time spent by a CPU, in the order of /proc/stat */
+typedef struct
+{
+    uint64_t jiffies[8];
+} sampler_cpu_t;
+
+DO_ARRAY(sampler_cpu_t, sampler_cpu, DO_NOTHING)
+
+static const char *const sampler_cpu_fields[] =
+{
+    "user", "nice", "system", "idle", "iowait", "irq", "softirq", "steal"
+};
+
+typedef struct
+{
+    char *name;
+    uint64_t rx_bytes, rx_packets, tx_bytes, tx_packets;
+} sampler_interface_t;
+
+static void
+sampler_interface_wipe(sampler_interface_t *iface)
+{
+    p_delete(&iface->name);
+}
+
+DO_ARRAY(sampler_interface_t, sampler_interface, sampler_interface_wipe)
+
+typedef struct
+{
+    int id;
+    int callback;
+} sampler_subscriber_t;
+
+DO_ARRAY(sampler_subscriber_t, sampler_subscriber, DO_NOTHING)
+
+static struct
+{
+    /** Prefix for all paths, only changed by tests */
+    char *root;
+    /** Milliseconds between samples */
+    guint interval;
+    /** The GLib source of the tick, 0 if nothing is subscribed */
+    guint tick_source;
+    /** When the last sample was taken (monotonic, microseconds) */
+    gint64 last_sample[SAMPLER_SOURCE_COUNT];
+    sampler_subscriber_array_t subscribers[SAMPLER_SOURCE_COUNT];
+    /** The last id handed out by subscribe() */
+    int last_id;
+    /** Are subscribers being called right now? */
+    bool dispatching;
+
+    sampler_file_t stat, meminfo, netdev;
+    sampler_cpu_array_t cpus;
+    sampler_interface_array_t interfaces;
+    sampler_attribute_array_t supplies, hwmon;
+} sampler = {
+    .interval = SAMPLER_DEFAULT_INTERVAL,
+    .stat = { .fd = -1 }, .meminfo = { .fd = -1 }, .netdev = { .fd = -1 },
+};
+
+static struct
+{
+    /** Number of ticks */
+    unsigned long ticks;
+    /** Number of files read */
+    unsigned long reads;
+} sampler_stats;
+
+/** Open a file below the sampler's root.
+ * \param file The file to initialise.
+ * \param path The path without the root prefix.
+ */
+static void
+sampler_file_open(sampler_file_t *file, const char *path)
+{
+    char *full = g_strconcat(NONULL(sampler.root), path, NULL);
+    file->fd = open(full, O_RDONLY | O_CLOEXEC);
+    buffer_init(&file->content);
+    g_free(full);
+}
+
+static void
+sampler_file_close(sampler_file_t *file)
+{
+    if(file->fd >= 0)
+        close(file->fd);
+    file->fd = -1;
+    buffer_wipe(&file->content);
+}
+
+/** Read the complete contents of a file again.
+ * /proc files are generated when they are read, so they are read from offset
+ * 0 with pread() instead of being reopened.
+ * \param file The file.
+ * \return The file's contents or NULL if it cannot be read.
+ */
+static const char *
+sampler_file_read(sampler_file_t *file)
+{
+    if(file->fd < 0)
+        return NULL;
+
+    file->content.len = 0;
+    for(;;)
+    {
+        buffer_grow(&file->content, BUFSIZ);
+        ssize_t len = pread(file->fd, file->content.s + file->content.len,
+                            file->content.size - file->content.len - 1,
+                            file->content.len);
+        if(len < 0 && errno == EINTR)
+            continue;
+        if(len < 0)
+            return NULL;
+        if(len == 0)
+            break;
+        file->content.len += len;
+    }
+    file->content.s[file->content.len] = '\0';
+    sampler_stats.reads++;
+    return file->content.s;
+}
+
+/** Push a sysfs value as a number if it is one and as a string otherwise. */
+static void
+sampler_push_value(lua_State *L, const char *value)
+{
+    char *end;
+    long long number = strtoll(value, &end, 10);
+
+    if(end != value && (*end == '\0' || *end == '\n'))
+        lua_pushnumber(L, number);
+    else
+        lua_pushlstring(L, value, strcspn(value, "\n"));
+}
+
+/* CPU */
+
+/** Parse /proc/stat.
+ * \param cpus Where to store the times, entry 0 is the sum of all CPUs.
+ * \return True on success.
+ */
+static bool
+sampler_cpu_parse(sampler_cpu_array_t *cpus)
+{
+    const char *line = sampler_file_read(&sampler.stat);
+
+    if(!line)
+        return false;
+
+    for(; line && a_strncmp(line, "cpu", 3) == 0; line = strchr(line, '\n'), line = line ? line + 1 : NULL)
+    {
+        sampler_cpu_t cpu;
+        char *p = (char *) line + 3;
+
+        /* "cpu" is the sum, "cpuN" is the N-th CPU */
+        while(isdigit((unsigned char) *p))
+            p++;
+        for(int i = 0; i < countof(cpu.jiffies); i++)
+            cpu.jiffies[i] = strtoull(p, &p, 10);
+        sampler_cpu_array_append(cpus, cpu);
+    }
+
+    return cpus->len > 0;
+}
+
+static void
+sampler_cpu_push(lua_State *L)
+{
+    sampler_cpu_array_t cpus;
+
+    sampler_cpu_array_init(&cpus);
+    sampler_cpu_parse(&cpus);
+
+    lua_createtable(L, cpus.len, 1);
+    for(int i = 0; i < cpus.len; i++)
+    {
+        sampler_cpu_t *prev = i < sampler.cpus.len ? &sampler.cpus.tab[i] : NULL;
+        uint64_t total = 0, idle = 0;
+
+        lua_createtable(L, 0, countof(sampler_cpu_fields) + 1);
+        for(int j = 0; j < countof(sampler_cpu_fields); j++)
+        {
+            uint64_t delta = cpus.tab[i].jiffies[j];
+            /* Counters can go backwards when a CPU goes offline */
+            if(prev)
+                delta = delta >= prev->jiffies[j] ? delta - prev->jiffies[j] : 0;
+            total += delta;
+            /* idle and iowait */
+            if(j == 3 || j == 4)
+                idle += delta;
+            lua_pushnumber(L, delta);
+            lua_setfield(L, -2, sampler_cpu_fields[j]);
+        }
+        lua_pushnumber(L, total ? 1.0 - (double) idle / total : 0);
+        lua_setfield(L, -2, "usage");
+        lua_rawseti(L, -2, i);
+    }
+
+    sampler_cpu_array_wipe(&sampler.cpus);
+    sampler.cpus = cpus;
+}
+
+/* Memory */
+
+static void
+sampler_memory_push(lua_State *L)
+{
+    const char *line = sampler_file_read(&sampler.meminfo);
+
+    lua_newtable(L);
+    for(; line && *line; line = strchr(line, '\n'), line = line ? line + 1 : NULL)
+    {
+        const char *colon = strchr(line, ':');
+        if(!colon)
+            break;
+        lua_pushlstring(L, line, colon - line);
+        lua_pushnumber(L, strtoull(colon + 1, NULL, 10));
+        lua_rawset(L, -3);
+    }
+}
+
+/* Network */
+
+static sampler_interface_t *
+sampler_interface_get(const char *name)
+{
+    foreach(iface, sampler.interfaces)
+        if(A_STREQ(iface->name, name))
+            return iface;
+    return NULL;
+}
+
+static void
+sampler_network_push(lua_State *L)
+{
+    const char *line = sampler_file_read(&sampler.netdev);
+    sampler_interface_array_t interfaces;
+
+    sampler_interface_array_init(&interfaces);
+    lua_newtable(L);
+
+    /* Skip the two header lines */
+    for(int i = 0; line && i < 2; i++)
+        if((line = strchr(line, '\n')))
+            line++;
+
+    for(; line && *line; line = strchr(line, '\n'), line = line ? line + 1 : NULL)
+    {
+        const char *colon = strchr(line, ':');
+        sampler_interface_t iface;
+        char *p;
+
+        if(!colon)
+            break;
+        while(*line == ' ')
+            line++;
+        iface.name = a_strndup(line, colon - line);
+
+        /* Receive: bytes packets errs drop fifo frame compressed multicast,
+         * then the same for transmit */
+        p = (char *) colon + 1;
+        iface.rx_bytes = strtoull(p, &p, 10);
+        iface.rx_packets = strtoull(p, &p, 10);
+        for(int i = 0; i < 6; i++)
+            strtoull(p, &p, 10);
+        iface.tx_bytes = strtoull(p, &p, 10);
+        iface.tx_packets = strtoull(p, &p, 10);
+
+        sampler_interface_t *prev = sampler_interface_get(iface.name);
+#define DELTA(field) (prev && iface.field >= prev->field ? iface.field - prev->field : 0)
+        lua_createtable(L, 0, 6);
+        lua_pushnumber(L, DELTA(rx_bytes));
+        lua_setfield(L, -2, "rx_bytes");
+        lua_pushnumber(L, DELTA(tx_bytes));
+        lua_setfield(L, -2, "tx_bytes");
+        lua_pushnumber(L, DELTA(rx_packets));
+        lua_setfield(L, -2, "rx_packets");
+        lua_pushnumber(L, DELTA(tx_packets));
+        lua_setfield(L, -2, "tx_packets");
+        lua_pushnumber(L, iface.rx_bytes);
+        lua_setfield(L, -2, "rx_total");
+        lua_pushnumber(L, iface.tx_bytes);
+        lua_setfield(L, -2, "tx_total");
+        lua_setfield(L, -2, iface.name);
+#undef DELTA
+
+        sampler_interface_array_append(&interfaces, iface);
+    }
+
+    sampler_interface_array_wipe(&sampler.interfaces);
+    sampler.interfaces = interfaces;
+}
+
+/* sysfs devices */
+
+static const char *const sampler_supply_attributes[] =
+{
+    "type", "status", "online", "capacity", "energy_now", "energy_full", "power_now"
+};
+
+/** Read a small sysfs file once.
+ * \return The first line of the file or NULL, has to be freed.
+ */
+static char *
+sampler_read_once(const char *dir, const char *device, const char *attribute)
+{
+    char *path = g_strconcat(dir, "/", device, "/", attribute, NULL);
+    char *content = NULL;
+
+    if(g_file_get_contents(path, &content, NULL, NULL))
+        content[strcspn(content, "\n")] = '\0';
+    g_free(path);
+    return content;
+}
+
+static void
+sampler_attribute_add(sampler_attribute_array_t *arr, const char *class,
+                      const char *device, const char *attribute, char *label)
+{
+    char *path = g_strconcat("/sys/class/", class, "/", device, "/", attribute, NULL);
+    sampler_attribute_t attr = { .label = label };
+
+    sampler_file_open(&attr.file, path);
+    g_free(path);
+    if(attr.file.fd < 0)
+    {
+        p_delete(&label);
+        return;
+    }
+    attr.device = a_strdup(device);
+    attr.attribute = a_strdup(attribute);
+    sampler_attribute_array_append(arr, attr);
+}
+
+static int
+sampler_dirent_cmp(const struct dirent **a, const struct dirent **b)
+{
+    return a_strcmp((*a)->d_name, (*b)->d_name);
+}
+
+/** Find all devices of a sysfs class and open their attributes.
+ * \param arr The array to fill.
+ * \param class The device class, power_supply or hwmon.
+ */
+static void
+sampler_scan_class(sampler_attribute_array_t *arr, const char *class)
+{
+    char *dir = g_strconcat(NONULL(sampler.root), "/sys/class/", class, NULL);
+    struct dirent **devices;
+    int n = scandir(dir, &devices, NULL, sampler_dirent_cmp);
+
+    for(int i = 0; i < n; i++)
+    {
+        const char *device = devices[i]->d_name;
+
+        if(device[0] == '.')
+            ;
+        else if(A_STREQ(class, "power_supply"))
+        {
+            for(int j = 0; j < countof(sampler_supply_attributes); j++)
+                sampler_attribute_add(arr, class, device, sampler_supply_attributes[j], NULL);
+        }
+        else
+        {
+            /* The name does not change, so it is read only once and no file
+             * is kept open for it */
+            char *name = sampler_read_once(dir, device, "name");
+            if(name)
+            {
+                sampler_attribute_t attr = {
+                    .device = a_strdup(device),
+                    .attribute = a_strdup("name"),
+                    .label = name,
+                    .file = { .fd = -1 },
+                };
+                buffer_init(&attr.file.content);
+                sampler_attribute_array_append(arr, attr);
+            }
+
+            for(int t = 1; t < 64; t++)
+            {
+                char input[32], label[32];
+                snprintf(input, sizeof(input), "temp%d_input", t);
+                snprintf(label, sizeof(label), "temp%d_label", t);
+
+                char *path = g_strconcat(dir, "/", device, "/", input, NULL);
+                bool exists = access(path, R_OK) == 0;
+                g_free(path);
+                if(!exists)
+                    continue;
+
+                char *label_value = sampler_read_once(dir, device, label);
+                if(!label_value)
+                    label_value = a_strdup(input);
+                sampler_attribute_add(arr, class, device, input, label_value);
+            }
+        }
+        free(devices[i]);
+    }
+    if(n >= 0)
+        free(devices);
+    g_free(dir);
+}
+
+static void
+sampler_power_supply_push(lua_State *L)
+{
+    lua_newtable(L);
+    foreach(attr, sampler.supplies)
+    {
+        const char *value = sampler_file_read(&attr->file);
+        if(!value)
+            continue;
+
+        lua_getfield(L, -1, attr->device);
+        if(lua_isnil(L, -1))
+        {
+            lua_pop(L, 1);
+            lua_newtable(L);
+            lua_pushvalue(L, -1);
+            lua_setfield(L, -3, attr->device);
+        }
+        sampler_push_value(L, value);
+        lua_setfield(L, -2, attr->attribute);
+        lua_pop(L, 1);
+    }
+}
+
+static void
+sampler_hwmon_push(lua_State *L)
+{
+    lua_newtable(L);
+    foreach(attr, sampler.hwmon)
+    {
+        lua_getfield(L, -1, attr->device);
+        if(lua_isnil(L, -1))
+        {
+            lua_pop(L, 1);
+            lua_createtable(L, 0, 2);
+            lua_newtable(L);
+            lua_setfield(L, -2, "temperatures");
+            lua_pushvalue(L, -1);
+            lua_setfield(L, -3, attr->device);
+        }
+
+        if(A_STREQ(attr->attribute, "name"))
+        {
+            /* Read once during the scan, there is no file for it */
+            lua_pushstring(L, attr->label);
+            lua_setfield(L, -2, "name");
+        }
+        else
+        {
+            const char *value = sampler_file_read(&attr->file);
+            if(value)
+            {
+                lua_getfield(L, -1, "temperatures");
+                lua_createtable(L, 0, 2);
+                lua_pushstring(L, attr->label);
+                lua_setfield(L, -2, "label");
+                /* sysfs reports millidegrees */
+                lua_pushnumber(L, strtoll(value, NULL, 10) / 1000.0);
+                lua_setfield(L, -2, "celsius");
+                lua_rawseti(L, -2, luaA_rawlen(L, -2) + 1);
+                lua_pop(L, 1);
+            }
+        }
+        lua_pop(L, 1);
+    }
+}
+
+/* Sources */
+
+/** Open the files of a source and take an initial sample for the deltas.
+ * \param source The source.
+ */
+static void
+sampler_source_open(sampler_source_t source)
+{
+    switch(source)
+    {
+      case SAMPLER_CPU:
+        sampler_file_open(&sampler.stat, "/proc/stat");
+        sampler_cpu_parse(&sampler.cpus);
+        break;
+      case SAMPLER_MEMORY:
+        sampler_file_open(&sampler.meminfo, "/proc/meminfo");
+        break;
+      case SAMPLER_NETWORK:
+        {
+            lua_State *L = globalconf_get_lua_State();
+            sampler_file_open(&sampler.netdev, "/proc/net/dev");
+            sampler_network_push(L);
+            lua_pop(L, 1);
+        }
+        break;
+      case SAMPLER_POWER_SUPPLY:
+        sampler_scan_class(&sampler.supplies, "power_supply");
+        break;
+      case SAMPLER_HWMON:
+        sampler_scan_class(&sampler.hwmon, "hwmon");
+        break;
+      case SAMPLER_SOURCE_COUNT:
+        break;
+    }
+    sampler.last_sample[source] = g_get_monotonic_time();
+}
+
+static void
+sampler_source_close(sampler_source_t source)
+{
+    switch(source)
+    {
+      case SAMPLER_CPU:
+        sampler_file_close(&sampler.stat);
+        sampler_cpu_array_wipe(&sampler.cpus);
+        break;
+      case SAMPLER_MEMORY:
+        sampler_file_close(&sampler.meminfo);
+        break;
+      case SAMPLER_NETWORK:
+        sampler_file_close(&sampler.netdev);
+        sampler_interface_array_wipe(&sampler.interfaces);
+        break;
+      case SAMPLER_POWER_SUPPLY:
+        sampler_attribute_array_wipe(&sampler.supplies);
+        break;
+      case SAMPLER_HWMON:
+        sampler_attribute_array_wipe(&sampler.hwmon);
+        break;
+      case SAMPLER_SOURCE_COUNT:
+        break;
+    }
+}
+
+/** Take a sample of a source and push it onto the stack. */
+static void
+sampler_source_push(lua_State *L, sampler_source_t source)
+{
+    gint64 now = g_get_monotonic_time();
+
+    switch(source)
+    {
+      case SAMPLER_CPU:
+        sampler_cpu_push(L);
+        break;
+      case SAMPLER_MEMORY:
+        sampler_memory_push(L);
+        break;
+      case SAMPLER_NETWORK:
+        sampler_network_push(L);
+        break;
+      case SAMPLER_POWER_SUPPLY:
+        sampler_power_supply_push(L);
+        break;
+      case SAMPLER_HWMON:
+        sampler_hwmon_push(L);
+        break;
+      case SAMPLER_SOURCE_COUNT:
+        lua_newtable(L);
+        break;
+    }
+
+    lua_pushnumber(L, (now - sampler.last_sample[source]) / 1e6);
+    lua_setfield(L, -2, "interval");
+    sampler.last_sample[source] = now;
+}
+
+/** Drop subscribers that were removed while they were being called. */
+static void
+sampler_compact(sampler_source_t source)
+{
+    sampler_subscriber_array_t *subscribers = &sampler.subscribers[source];
+
+    for(int i = subscribers->len - 1; i >= 0; i--)
+        if(subscribers->tab[i].callback == LUA_REFNIL)
+            sampler_subscriber_array_take(subscribers, i);
+    if(subscribers->len == 0)
+        sampler_source_close(source);
+}
+
+/** Sample every source that has subscribers and call them. */
+static void
+sampler_dispatch(lua_State *L)
+{
+    sampler_stats.ticks++;
+    sampler.dispatching = true;
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+    {
+        sampler_subscriber_array_t *subscribers = &sampler.subscribers[source];
+        if(subscribers->len == 0)
+            continue;
+
+        sampler_source_push(L, source);
+        /* Subscribers can subscribe more callbacks, so use indices */
+        for(int i = 0; i < subscribers->len; i++)
+        {
+            if(subscribers->tab[i].callback == LUA_REFNIL)
+                continue;
+            lua_pushvalue(L, -1);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, subscribers->tab[i].callback);
+            luaA_dofunction(L, 1, 0);
+        }
+        lua_pop(L, 1);
+    }
+    sampler.dispatching = false;
+
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+        if(sampler.subscribers[source].len > 0)
+            sampler_compact(source);
+}
+
+static bool
+sampler_has_subscribers(void)
+{
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+        if(sampler.subscribers[source].len > 0)
+            return true;
+    return false;
+}
+
+static gboolean
+sampler_tick(gpointer data)
+{
+    sampler_dispatch(globalconf_get_lua_State());
+    if(sampler_has_subscribers())
+        return G_SOURCE_CONTINUE;
+    sampler.tick_source = 0;
+    return G_SOURCE_REMOVE;
+}
+
+/** Start or stop the tick depending on whether anything is subscribed. */
+static void
+sampler_update_tick(void)
+{
+    bool needed = sampler_has_subscribers();
+
+    if(needed && !sampler.tick_source)
+        sampler.tick_source = g_timeout_add(sampler.interval, sampler_tick, NULL);
+    else if(!needed && sampler.tick_source)
+    {
+        g_source_remove(sampler.tick_source);
+        sampler.tick_source = 0;
+    }
+}
+
+static sampler_source_t
+luaA_checksource(lua_State *L, int idx)
+{
+    const char *name = luaL_checkstring(L, idx);
+
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+        if(A_STREQ(name, sampler_source_names[source]))
+            return source;
+    luaA_typerror(L, idx, "sampler source");
+    return SAMPLER_SOURCE_COUNT;
+}
+
+/** Call a function with new values of a source on every tick.
+ *
+ * @tparam string source One of "cpu", "memory", "network", "power_supply" or
+ *   "hwmon".
+ * @tparam function callback The function to call with a table of values.
+ * @treturn integer An id for `sampler.unsubscribe`.
+ * @function subscribe
+ */
+static int
+luaA_sampler_subscribe(lua_State *L)
+{
+    sampler_source_t source = luaA_checksource(L, 1);
+    sampler_subscriber_t subscriber = { .id = ++sampler.last_id, .callback = LUA_REFNIL };
+
+    luaA_registerfct(L, 2, &subscriber.callback);
+    if(sampler.subscribers[source].len == 0)
+        sampler_source_open(source);
+    sampler_subscriber_array_append(&sampler.subscribers[source], subscriber);
+    sampler_update_tick();
+
+    lua_pushinteger(L, subscriber.id);
+    return 1;
+}
+
+/** Stop calling a function that was subscribed before.
+ *
+ * @tparam integer id The id returned by `sampler.subscribe`.
+ * @treturn boolean True if the subscription existed.
+ * @function unsubscribe
+ */
+static int
+luaA_sampler_unsubscribe(lua_State *L)
+{
+    int id = luaL_checkinteger(L, 1);
+
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+        foreach(subscriber, sampler.subscribers[source])
+            if(subscriber->id == id && subscriber->callback != LUA_REFNIL)
+            {
+                luaA_unregister(L, &subscriber->callback);
+                if(!sampler.dispatching)
+                {
+                    sampler_compact(source);
+                    sampler_update_tick();
+                }
+                lua_pushboolean(L, true);
+                return 1;
+            }
+
+    lua_pushboolean(L, false);
+    return 1;
+}
+
+/** Set the time between two samples.
+ *
+ * @tparam number interval The interval in seconds, 2 by default.
+ * @function set_interval
+ */
+static int
+luaA_sampler_set_interval(lua_State *L)
+{
+    lua_Number interval = luaL_checknumber(L, 1);
+
+    luaL_argcheck(L, interval > 0, 1, "interval must be positive");
+    sampler.interval = MAX(1, interval * 1000);
+    if(sampler.tick_source)
+    {
+        g_source_remove(sampler.tick_source);
+        sampler.tick_source = 0;
+        sampler_update_tick();
+    }
+    return 0;
+}
+
+/** Read files below another directory than `/`.
+ * This is meant for tests which provide a fake `/proc` and `/sys`. All
+ * subscribed sources are reopened.
+ *
+ * @tparam[opt] string root The new root directory.
+ * @function set_root
+ */
+static int
+luaA_sampler_set_root(lua_State *L)
+{
+    const char *root = luaL_optstring(L, 1, NULL);
+
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+        if(sampler.subscribers[source].len > 0)
+            sampler_source_close(source);
+
+    p_delete(&sampler.root);
+    sampler.root = a_strdup(root);
+
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+        if(sampler.subscribers[source].len > 0)
+            sampler_source_open(source);
+    return 0;
+}
+
+/** Take a sample now and call all subscribers, without waiting for the tick.
+ *
+ * @function sample_now
+ */
+static int
+luaA_sampler_sample_now(lua_State *L)
+{
+    if(sampler.dispatching)
+        return luaL_error(L, "sampler.sample_now() cannot be called from a subscriber");
+    sampler_dispatch(L);
+    sampler_update_tick();
+    return 0;
+}
+
+/** Push statistics about the sampler onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on the stack.
+ */
+int
+sampler_push_stats(lua_State *L)
+{
+    int subscribers = 0;
+
+    for(sampler_source_t source = 0; source < SAMPLER_SOURCE_COUNT; source++)
+        foreach(subscriber, sampler.subscribers[source])
+            subscribers += subscriber->callback != LUA_REFNIL;
+
+    lua_createtable(L, 0, 3);
+    lua_pushinteger(L, sampler_stats.ticks);
+    lua_setfield(L, -2, "ticks");
+    lua_pushinteger(L, sampler_stats.reads);
+    lua_setfield(L, -2, "reads");
+    lua_pushinteger(L, subscribers);
+    lua_setfield(L, -2, "subscribers");
+    return 1;
+}
+
+const struct luaL_Reg awesome_sampler_lib[] =
+{
+    { "subscribe", luaA_sampler_subscribe },
+    { "unsubscribe", luaA_sampler_unsubscribe },
+    { "set_interval", luaA_sampler_set_interval },
+    { "set_root", luaA_sampler_set_root },
+    { "sample_now", luaA_sampler_sample_now },
+    { "__index", luaA_default_index },
+    { "__newindex", luaA_default_newindex },
+    { NULL, NULL }
+};
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
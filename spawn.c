@@ -52,12 +52,16 @@
  */
 
 #include "spawn.h"
+#include "profile.h"
+#include "common/buffer.h"
 
 #include <sys/types.h>
 #include <sys/wait.h>
 
+#include <errno.h>
 #include <unistd.h>
 #include <glib.h>
+#include <glib-unix.h>
 
 /** 20 seconds timeout */
 #define AWESOME_SPAWN_TIMEOUT 20.0
@@ -75,9 +79,30 @@ DO_ARRAY(SnStartupSequence *, SnStartupSequence, a_sn_startup_sequence_unref)
 /** The array of startup sequence running */
 static SnStartupSequence_array_t sn_waits;
 
+/** How much is read from a captured pipe at once */
+#define SPAWN_CAPTURE_CHUNK 65536
+
+/** The output of a child whose stdout and stderr are collected by us */
+typedef struct
+{
+    /** Output read so far, index 0 is stdout and 1 is stderr */
+    buffer_t output[2];
+    /** The pipes we are reading from, -1 after end of file */
+    int fd[2];
+    /** Maximum number of bytes to keep per stream, 0 for no limit */
+    int max_bytes;
+    /** Has the child exited already? */
+    bool exited;
+    /** The child's exit status as returned by waitpid() */
+    int status;
+    /** The Lua function to call once the child exited and the pipes are closed */
+    int exit_callback;
+} spawn_capture_t;
+
 typedef struct {
     GPid pid;
     int exit_callback;
+    spawn_capture_t *capture;
 } running_child_t;
 
 static int
@@ -375,13 +400,159 @@ parse_command(lua_State *L, int idx, GError **error)
     return argv;
 }
 
+/** Push the exit reason and code of a child onto the stack.
+ * \param L The Lua VM state.
+ * \param status The exit status as returned by waitpid().
+ */
+static void
+spawn_push_exit_status(lua_State *L, int status)
+{
+    /* 'Decode' the exit status */
+    if (WIFEXITED(status)) {
+        lua_pushliteral(L, "exit");
+        lua_pushinteger(L, WEXITSTATUS(status));
+    } else {
+        check(WIFSIGNALED(status));
+        lua_pushliteral(L, "signal");
+        lua_pushinteger(L, WTERMSIG(status));
+    }
+}
+
+/** Call the exit callback of a captured child once it exited and all of its
+ * output was read.
+ * \param capture The capture, freed if the callback was called.
+ */
+static void
+spawn_capture_finish(spawn_capture_t *capture)
+{
+    lua_State *L = globalconf_get_lua_State();
+
+    if(!capture->exited || capture->fd[0] >= 0 || capture->fd[1] >= 0)
+        return;
+
+    spawn_push_exit_status(L, capture->status);
+    for(int i = 0; i < 2; i++)
+    {
+        lua_pushlstring(L, capture->output[i].s, capture->output[i].len);
+        buffer_wipe(&capture->output[i]);
+    }
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, capture->exit_callback);
+    luaA_dofunction(L, 4, 0);
+    luaA_unregister(L, &capture->exit_callback);
+    p_delete(&capture);
+}
+
+/** Read everything that is available from one of the pipes of a child.
+ * \param capture The capture.
+ * \param i Which pipe to read from, 0 for stdout and 1 for stderr.
+ * \return false once the end of file was reached.
+ */
+static bool
+spawn_capture_read(spawn_capture_t *capture, int i)
+{
+    buffer_t *buf = &capture->output[i];
+    char discard[SPAWN_CAPTURE_CHUNK];
+
+    for(;;)
+    {
+        ssize_t len;
+        bool keep = capture->max_bytes <= 0 || buf->len < capture->max_bytes;
+
+        if(keep)
+        {
+            buffer_grow(buf, SPAWN_CAPTURE_CHUNK);
+            len = read(capture->fd[i], buf->s + buf->len, buf->size - buf->len - 1);
+        }
+        else
+            /* Over the limit: keep draining the pipe so the child does not
+             * block, but drop the data. */
+            len = read(capture->fd[i], discard, sizeof(discard));
+
+        if(len < 0 && errno == EINTR)
+            continue;
+        if(len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return true;
+        if(len <= 0)
+            return false;
+
+        if(keep)
+        {
+            buf->len += len;
+            if(capture->max_bytes > 0 && buf->len > capture->max_bytes)
+                buf->len = capture->max_bytes;
+            buf->s[buf->len] = '\0';
+        }
+    }
+}
+
+static gboolean
+spawn_capture_io(gint fd, GIOCondition condition, gpointer data, int i)
+{
+    spawn_capture_t *capture = data;
+    int64_t start = profile_now();
+
+    if(spawn_capture_read(capture, i))
+    {
+        profile_record(PROFILE_SPAWN, start);
+        return TRUE;
+    }
+
+    close(fd);
+    capture->fd[i] = -1;
+    spawn_capture_finish(capture);
+    profile_record(PROFILE_SPAWN, start);
+    return FALSE;
+}
+
+static gboolean
+spawn_capture_stdout(gint fd, GIOCondition condition, gpointer data)
+{
+    return spawn_capture_io(fd, condition, data, 0);
+}
+
+static gboolean
+spawn_capture_stderr(gint fd, GIOCondition condition, gpointer data)
+{
+    return spawn_capture_io(fd, condition, data, 1);
+}
+
+/** Start collecting the output of a child.
+ * \param stdout_fd The child's stdout.
+ * \param stderr_fd The child's stderr.
+ * \param max_bytes Maximum number of bytes to keep per stream, 0 for all.
+ * \return The new capture.
+ */
+static spawn_capture_t *
+spawn_capture_new(int stdout_fd, int stderr_fd, int max_bytes)
+{
+    spawn_capture_t *capture = p_new(spawn_capture_t, 1);
+    GIOCondition cond = G_IO_IN | G_IO_HUP | G_IO_ERR;
+
+    buffer_init(&capture->output[0]);
+    buffer_init(&capture->output[1]);
+    capture->fd[0] = stdout_fd;
+    capture->fd[1] = stderr_fd;
+    capture->max_bytes = max_bytes;
+    capture->exit_callback = LUA_REFNIL;
+
+    g_unix_set_fd_nonblocking(stdout_fd, TRUE, NULL);
+    g_unix_set_fd_nonblocking(stderr_fd, TRUE, NULL);
+    g_unix_fd_add(stdout_fd, cond, spawn_capture_stdout, capture);
+    g_unix_fd_add(stderr_fd, cond, spawn_capture_stderr, capture);
+
+    return capture;
+}
+
 /** Callback for when a spawned process exits. */
 void
 spawn_child_exited(pid_t pid, int status)
 {
     int exit_callback;
+    spawn_capture_t *capture;
     running_child_t needle = { .pid = pid };
     lua_State *L = globalconf_get_lua_State();
+    int64_t start = profile_now();
 
     running_child_t *child = running_child_array_lookup(&running_children, &needle);
     if (child == NULL) {
@@ -390,21 +561,25 @@ spawn_child_exited(pid_t pid, int status)
         return;
     }
     exit_callback = child->exit_callback;
+    capture = child->capture;
     running_child_array_remove(&running_children, child);
 
-    /* 'Decode' the exit status */
-    if (WIFEXITED(status)) {
-        lua_pushliteral(L, "exit");
-        lua_pushinteger(L, WEXITSTATUS(status));
-    } else {
-        check(WIFSIGNALED(status));
-        lua_pushliteral(L, "signal");
-        lua_pushinteger(L, WTERMSIG(status));
+    if(capture)
+    {
+        /* The callback also needs the output, which might still be in the
+         * pipes */
+        capture->exited = true;
+        capture->status = status;
+        spawn_capture_finish(capture);
+        profile_record(PROFILE_SPAWN, start);
+        return;
     }
 
+    spawn_push_exit_status(L, status);
     lua_rawgeti(L, LUA_REGISTRYINDEX, exit_callback);
     luaA_dofunction(L, 2, 0);
     luaA_unregister(L, &exit_callback);
+    profile_record(PROFILE_SPAWN, start);
 }
 
 /** Spawn a program.
@@ -420,6 +595,11 @@ spawn_child_exited(pid_t pid, int status)
  *   code / the signal number causing process termination.
  * @tparam[opt=nil] table cmd The environment to use for the spawned program.
  *   Without this the spawned process inherits awesome's environment.
+ * @tparam[opt=nil] boolean|integer capture Collect the program's output
+ *   instead of returning file descriptors for it. Requires `exit_callback`,
+ *   which then gets the complete stdout and stderr as a third and fourth
+ *   argument once the program exited and closed both streams. A number limits
+ *   how many bytes are kept of each stream; the rest is discarded.
  * @treturn[1] integer Process ID if everything is OK.
  * @treturn[1] string Startup-notification ID, if `use_sn` is true.
  * @treturn[1] integer stdin, if `stdin` is true.
@@ -433,6 +613,8 @@ luaA_spawn(lua_State *L)
 {
     gchar **argv = NULL, **envp = NULL;
     bool use_sn = true, return_stdin = false, return_stdout = false, return_stderr = false;
+    bool capture = false;
+    int max_bytes = 0;
     int stdin_fd = -1, stdout_fd = -1, stderr_fd = -1;
     int *stdin_ptr = NULL, *stdout_ptr = NULL, *stderr_ptr = NULL;
     GSpawnFlags flags = 0;
@@ -452,6 +634,22 @@ luaA_spawn(lua_State *L)
         luaA_checkfunction(L, 6);
         flags |= G_SPAWN_DO_NOT_REAP_CHILD;
     }
+    if(!lua_isnoneornil(L, 8))
+    {
+        if(lua_isnumber(L, 8))
+        {
+            max_bytes = MAX(1, lua_tointeger(L, 8));
+            capture = true;
+        }
+        else
+            capture = luaA_checkboolean(L, 8);
+    }
+    if(capture)
+    {
+        if(!(flags & G_SPAWN_DO_NOT_REAP_CHILD))
+            luaL_error(L, "spawn: capturing output requires an exit callback");
+        return_stdout = return_stderr = true;
+    }
     if(return_stdin)
         stdin_ptr = &stdin_fd;
     if(return_stdout)
@@ -517,7 +715,14 @@ luaA_spawn(lua_State *L)
     {
         /* Only do this down here to avoid leaks in case of errors */
         running_child_t child = { .pid = pid, .exit_callback = LUA_REFNIL };
-        luaA_registerfct(L, 6, &child.exit_callback);
+        if(capture)
+        {
+            child.capture = spawn_capture_new(stdout_fd, stderr_fd, max_bytes);
+            luaA_registerfct(L, 6, &child.capture->exit_callback);
+            return_stdout = return_stderr = false;
+        }
+        else
+            luaA_registerfct(L, 6, &child.exit_callback);
         running_child_array_insert(&running_children, child);
     }
 
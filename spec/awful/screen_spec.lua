@@ -8,6 +8,15 @@ local fake_screens = {}
 _G.screen = setmetatable({
     set_index_miss_handler = function() end,
     set_newindex_miss_handler = function() end,
+    at = function(x, y)
+        for _, s in ipairs(fake_screens) do
+            local geo = s.geometry
+            if x >= geo.x and x < geo.x + geo.width
+               and y >= geo.y and y < geo.y + geo.height then
+                return s
+            end
+        end
+    end,
 }, {
     __call = function(_, _, prev)
         if not prev then
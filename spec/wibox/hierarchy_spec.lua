@@ -5,7 +5,8 @@
 
 local hierarchy = require("wibox.hierarchy")
 
-local Region = require("lgi").cairo.Region
+local cairo = require("lgi").cairo
+local Region = cairo.Region
 local matrix = require("gears.matrix")
 local utils = require("wibox.test_utils")
 
@@ -320,6 +321,83 @@ describe("wibox.hierarchy", function()
             assert.is.equal(0, #weak)
         end)
     end)
+    describe("layer cache", function()
+        local context, child, parent, instance, draws
+
+        local function draw()
+            local surface = cairo.ImageSurface(cairo.Format.ARGB32, 20, 20)
+            instance:draw(context, cairo.Context(surface))
+        end
+
+        before_each(function()
+            local function nop() end
+            context = { dpi = 96 }
+            draws = 0
+            child = make_widget(nil)
+            child.get_opacity = function() return 1 end
+            child.draw = function() draws = draws + 1 end
+            parent = make_widget({
+                make_child(child, 5, 5, matrix.create_translate(2, 3))
+            })
+            parent.get_opacity = function() return 1 end
+            parent._private.cacheable = true
+            instance = hierarchy.new(context, parent, 10, 10, nop, nop)
+        end)
+
+        it("reuses the layer", function()
+            local stats = hierarchy.layer_stats()
+            draw()
+            draw()
+            assert.is.equal(1, draws)
+            local new_stats = hierarchy.layer_stats()
+            assert.is.equal(stats.misses + 1, new_stats.misses)
+            assert.is.equal(stats.hits + 1, new_stats.hits)
+        end)
+
+        it("redraws after redraw_needed", function()
+            draw()
+            child:emit_signal("widget::redraw_needed")
+            draw()
+            assert.is.equal(2, draws)
+        end)
+
+        it("redraws on a different dpi", function()
+            draw()
+            context.dpi = 192
+            draw()
+            assert.is.equal(2, draws)
+        end)
+
+        it("is not used when not cacheable", function()
+            parent._private.cacheable = false
+            draw()
+            draw()
+            assert.is.equal(2, draws)
+        end)
+
+        it("evicts the least recently used layer", function()
+            -- Get rid of the layers from other tests
+            collectgarbage("collect")
+            local limit = hierarchy.layer_cache_limit
+            -- Room for two layers of 10x10 pixels
+            hierarchy.layer_cache_limit = 2 * 10 * 10 * 4
+            local first = instance
+            draw()
+            local stats = hierarchy.layer_stats()
+            for _ = 1, 2 do
+                instance = hierarchy.new(context, parent, 10, 10, function() end, function() end)
+                draw()
+            end
+            local new_stats = hierarchy.layer_stats()
+            assert.is.equal(stats.evictions + 1, new_stats.evictions)
+
+            -- The first hierarchy's layer was dropped
+            instance = first
+            draw()
+            assert.is.equal(4, draws)
+            hierarchy.layer_cache_limit = limit
+        end)
+    end)
 end)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -69,42 +69,163 @@ stack_windows(void)
     need_stack_refresh = true;
 }
 
-/** Stack a window above another window, without causing errors.
+/** A window we stack: either a client (by its frame) or a drawin */
+DO_ARRAY(window_t *, stack_window, DO_NOTHING)
+
+/** The stacking order we want, from bottom to top */
+static stack_window_array_t stack_order;
+/** Scratch space for computing which windows do not need to be moved */
+static struct
+{
+    int *buf;
+    int size;
+    int *old_position, *tails, *prev;
+} stack_scratch;
+/** Identifies the current restack, see window_t.stack_serial. Newly created
+ * windows have a serial of 0, which never is the previous restack. */
+static unsigned int stack_serial = 2;
+
+/** Restacking statistics */
+static struct
+{
+    /** Number of restacks done */
+    unsigned int restacks;
+    /** Number of ConfigureWindow requests sent in total */
+    unsigned int requests;
+    /** Number of ConfigureWindow requests sent by the last restack */
+    unsigned int last_requests;
+    /** Number of windows in the last stacking order */
+    unsigned int last_windows;
+} stack_stats;
+
+static inline xcb_window_t
+stack_window_get_xwindow(window_t *w)
+{
+    /* Clients are stacked by their frame, drawins do not have one */
+    return w->frame_window != XCB_NONE ? w->frame_window : w->window;
+}
+
+/** Stack a window relative to a sibling, without causing errors.
  * \param w The window.
- * \param previous The window which should be below this window.
+ * \param sibling The window which this window should be above or below.
+ * \param mode XCB_STACK_MODE_ABOVE or XCB_STACK_MODE_BELOW.
  */
 static void
-stack_window_above(xcb_window_t w, xcb_window_t previous)
+stack_window_configure(window_t *w, window_t *sibling, uint32_t mode)
 {
-    if (previous == XCB_NONE)
-        /* This would cause an error from the X server. Also, if we really
-         * changed the stacking order of all windows, they'd all have to redraw
-         * themselves. Doing it like this is better. */
-        return;
-
-    xcb_configure_window(globalconf.connection, w,
+    xcb_configure_window(globalconf.connection, stack_window_get_xwindow(w),
                          XCB_CONFIG_WINDOW_SIBLING | XCB_CONFIG_WINDOW_STACK_MODE,
-                         (uint32_t[]) { previous, XCB_STACK_MODE_ABOVE });
+                         (uint32_t[]) { stack_window_get_xwindow(sibling), mode });
+    stack_stats.requests++;
+    stack_stats.last_requests++;
 }
 
-/** Stack a client above.
+/** Add a client and, recursively, its transients to the stacking order.
  * \param c The client.
- * \param previous The previous client on the stack.
- * \return The next-previous!
  */
-static xcb_window_t
-stack_client_above(client_t *c, xcb_window_t previous)
+static void
+stack_client_above(client_t *c)
 {
-    stack_window_above(c->frame_window, previous);
-
-    previous = c->frame_window;
+    stack_window_array_append(&stack_order, (window_t *) c);
 
     /* stack transient window on top of their parents */
+    for(client_t *tc = c->stack_transients; tc; tc = tc->stack_next_transient)
+        stack_client_above(tc);
+}
+
+/** Build the parent to transients relation for this restack.
+ * Each client gets a list of its transients, in stacking order.
+ */
+static void
+stack_build_transients(void)
+{
     foreach(node, globalconf.stack)
-        if((*node)->transient_for == c)
-            previous = stack_client_above(*node, previous);
+        (*node)->stack_transients = NULL;
+
+    foreach_reverse(node, globalconf.stack)
+    {
+        client_t *c = *node;
+        if(c->transient_for)
+        {
+            c->stack_next_transient = c->transient_for->stack_transients;
+            c->transient_for->stack_transients = c;
+        }
+    }
+}
+
+/** Remove duplicates from the stacking order. A window might be added more
+ * than once, e.g. a transient window in a layer of its own. The last
+ * occurrence is where it ends up, so that is the one we keep.
+ * While doing so, remember where each window was in the last order that was
+ * sent to the X server, or -1 if it was not part of it.
+ */
+static void
+stack_order_finish(void)
+{
+    int len = 0;
+
+    p_grow(&stack_scratch.buf, 3 * stack_order.len, &stack_scratch.size);
+    stack_scratch.old_position = stack_scratch.buf;
+    stack_scratch.tails = stack_scratch.buf + stack_order.len;
+    stack_scratch.prev = stack_scratch.buf + 2 * stack_order.len;
+
+    /* Walk from the top down, compacting towards the end of the array */
+    foreach_reverse(item, stack_order)
+    {
+        window_t *w = *item;
+        if(w->stack_serial == stack_serial)
+            continue;
+        len++;
+        stack_scratch.old_position[stack_order.len - len] =
+            w->stack_serial == stack_serial - 1 ? w->stack_position : -1;
+        w->stack_serial = stack_serial;
+        stack_order.tab[stack_order.len - len] = w;
+    }
 
-    return previous;
+    int skip = stack_order.len - len;
+    memmove(stack_order.tab, stack_order.tab + skip, len * sizeof(*stack_order.tab));
+    memmove(stack_scratch.old_position, stack_scratch.old_position + skip,
+            len * sizeof(*stack_scratch.old_position));
+    stack_order.len = len;
+}
+
+/** Find the windows that do not need to be moved. These are the longest
+ * subsequence of the new order that already is in the right order: the
+ * longest increasing subsequence of the old positions.
+ * \param stable Set to true for every window that can stay where it is.
+ */
+static void
+stack_find_stable(bool *stable)
+{
+    int *old = stack_scratch.old_position;
+    int *tails = stack_scratch.tails;
+    int *prev = stack_scratch.prev;
+    int n = 0;
+
+    for(int i = 0; i < stack_order.len; i++)
+    {
+        stable[i] = false;
+        if(old[i] < 0)
+            continue;
+
+        /* Binary search for the longest subsequence that i can extend */
+        int l = 0, r = n;
+        while(l < r)
+        {
+            int m = (l + r) / 2;
+            if(old[tails[m]] < old[i])
+                l = m + 1;
+            else
+                r = m;
+        }
+        prev[i] = l > 0 ? tails[l - 1] : -1;
+        tails[l] = i;
+        if(l == n)
+            n++;
+    }
+
+    for(int i = n > 0 ? tails[n - 1] : -1; i >= 0; i = prev[i])
+        stable[i] = true;
 }
 
 /** Stacking layout layers */
@@ -156,8 +277,8 @@ client_layer_translator(client_t *c)
 }
 
 /** Restack clients.
- * \todo It might be worth stopping to restack everyone and only stack `c'
- * relatively to the first matching in the list.
+ * The new stacking order is compared to the one that was last sent to the X
+ * server and only the windows that changed their relative position get moved.
  */
 void
 stack_refresh()
@@ -165,38 +286,85 @@ stack_refresh()
     if(!need_stack_refresh)
         return;
 
-    xcb_window_t next = XCB_NONE;
+    stack_order.len = 0;
+    stack_build_transients();
 
     /* stack desktop windows */
     for(window_layer_t layer = WINDOW_LAYER_DESKTOP; layer < WINDOW_LAYER_BELOW; layer++)
         foreach(node, globalconf.stack)
             if(client_layer_translator(*node) == layer)
-                next = stack_client_above(*node, next);
+                stack_client_above(*node);
 
     /* first stack not ontop drawin window */
     foreach(drawin, globalconf.drawins)
         if(!(*drawin)->ontop)
-        {
-            stack_window_above((*drawin)->window, next);
-            next = (*drawin)->window;
-        }
+            stack_window_array_append(&stack_order, (window_t *) *drawin);
 
     /* then stack clients */
     for(window_layer_t layer = WINDOW_LAYER_BELOW; layer < WINDOW_LAYER_COUNT; layer++)
         foreach(node, globalconf.stack)
             if(client_layer_translator(*node) == layer)
-                next = stack_client_above(*node, next);
+                stack_client_above(*node);
 
     /* then stack ontop drawin window */
     foreach(drawin, globalconf.drawins)
         if((*drawin)->ontop)
-        {
-            stack_window_above((*drawin)->window, next);
-            next = (*drawin)->window;
-        }
+            stack_window_array_append(&stack_order, (window_t *) *drawin);
+
+    stack_order_finish();
+
+    bool *stable = p_alloca(bool, stack_order.len + 1);
+    stack_find_stable(stable);
+
+    stack_stats.restacks++;
+    stack_stats.last_requests = 0;
+    stack_stats.last_windows = stack_order.len;
+
+    window_t *first_stable = NULL;
+    for(int i = 0; i < stack_order.len && !first_stable; i++)
+        if(stable[i])
+            first_stable = stack_order.tab[i];
+
+    for(int i = 0; i < stack_order.len; i++)
+    {
+        window_t *w = stack_order.tab[i];
+        w->stack_position = i;
+        if(stable[i])
+            continue;
+        if(i > 0)
+            stack_window_configure(w, stack_order.tab[i - 1], XCB_STACK_MODE_ABOVE);
+        else if(first_stable)
+            stack_window_configure(w, first_stable, XCB_STACK_MODE_BELOW);
+        /* Else this is the bottom-most window and nothing else is in a known
+         * position yet. If we really changed the stacking order of all
+         * windows, they'd all have to redraw themselves. Leaving this one
+         * alone and stacking everything else above it is better. */
+    }
+
+    /* Positions from this restack are valid during the next one */
+    if(++stack_serial < 2)
+        stack_serial = 2;
 
     need_stack_refresh = false;
 }
 
+/** Push restacking statistics onto the Lua stack.
+ * \param L The Lua VM state.
+ * \return The number of elements pushed on stack.
+ */
+int
+stack_push_stats(lua_State *L)
+{
+    lua_createtable(L, 0, 4);
+    lua_pushinteger(L, stack_stats.restacks);
+    lua_setfield(L, -2, "restacks");
+    lua_pushinteger(L, stack_stats.requests);
+    lua_setfield(L, -2, "requests");
+    lua_pushinteger(L, stack_stats.last_requests);
+    lua_setfield(L, -2, "last_requests");
+    lua_pushinteger(L, stack_stats.last_windows);
+    lua_setfield(L, -2, "last_windows");
+    return 1;
+}
 
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -22,6 +22,8 @@
 #ifndef AWESOME_STACK_H
 #define AWESOME_STACK_H
 
+#include <lua.h>
+
 typedef struct client_t client_t;
 
 void stack_client_remove(client_t *);
@@ -29,6 +31,7 @@ void stack_client_push(client_t *);
 void stack_client_append(client_t *);
 void stack_windows(void);
 void stack_refresh(void);
+int stack_push_stats(lua_State *);
 
 #endif
 // vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -204,24 +204,31 @@ systray_process_client_message(xcb_client_message_event_t *ev)
     return ret;
 }
 
-/** Check if a window is a KDE tray.
+/** Ask if a window is a KDE tray.
  * \param w The window to check.
+ * \return The cookie to pass to systray_iskdedockapp_reply().
+ */
+xcb_get_property_cookie_t
+systray_iskdedockapp_unchecked(xcb_window_t w)
+{
+    /* Check if that is a KDE tray because it does not respect fdo standards,
+     * thanks KDE. */
+    return xcb_get_property_unchecked(globalconf.connection, false, w,
+                                      _KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR,
+                                      XCB_ATOM_WINDOW, 0, 1);
+}
+
+/** Check if a window is a KDE tray.
+ * \param cookie The cookie from systray_iskdedockapp_unchecked().
  * \return True if it is, false otherwise.
  */
 bool
-systray_iskdedockapp(xcb_window_t w)
+systray_iskdedockapp_reply(xcb_get_property_cookie_t cookie)
 {
-    xcb_get_property_cookie_t kde_check_q;
     xcb_get_property_reply_t *kde_check;
     bool ret;
 
-    /* Check if that is a KDE tray because it does not respect fdo standards,
-     * thanks KDE. */
-    kde_check_q = xcb_get_property_unchecked(globalconf.connection, false, w,
-                                             _KDE_NET_WM_SYSTEM_TRAY_WINDOW_FOR,
-                                             XCB_ATOM_WINDOW, 0, 1);
-
-    kde_check = xcb_get_property_reply(globalconf.connection, kde_check_q, NULL);
+    kde_check = xcb_get_property_reply(globalconf.connection, cookie, NULL);
 
     /* it's a KDE systray ?*/
     ret = (kde_check && kde_check->value_len);
@@ -6,10 +6,14 @@ local spawn = require("awful.spawn")
 local test_client_source = [[
 local lgi = require 'lgi'
 local Gdk = lgi.require('Gdk')
+local GdkX11 = lgi.require('GdkX11')
 local Gtk = lgi.require('Gtk')
 local Gio = lgi.require('Gio')
+local GLib = lgi.require('GLib')
 Gtk.init()
 
+local windows_by_title = {}
+
 local function open_window(class, title, options)
     local window = Gtk.Window {
         default_width  = options.default_width  or 100,
@@ -35,6 +39,10 @@ local function open_window(class, title, options)
     if options.maximize_before then
         window:maximize()
     end
+    if options.transient_for then
+        window:set_transient_for(windows_by_title[options.transient_for])
+    end
+    windows_by_title[title] = window
     window:set_wmclass(class, class)
     window:show_all()
     if options.maximize_after then
@@ -45,6 +53,36 @@ local function open_window(class, title, options)
            tonumber(options.resize_after_width), tonumber(options.resize_after_height)
        )
     end
+    if options.retitle then
+        -- Change the title many times in a row once the window is managed
+        GLib.timeout_add(GLib.PRIORITY_DEFAULT, 500, function()
+            -- Grab the server so that awesome cannot get any reply until
+            -- all titles were set
+            GdkX11.x11_grab_server()
+            for i = 1, tonumber(options.retitle) do
+                window:set_title(title .. " " .. i)
+            end
+            window:set_title(title .. " done")
+            GdkX11.x11_ungrab_server()
+            Gdk.Display.get_default():flush()
+            return false
+        end)
+    end
+    if options.reconfigure then
+        -- Send many ConfigureRequests in a row once the window is managed
+        GLib.timeout_add(GLib.PRIORITY_DEFAULT, 500, function()
+            local gdk_window = window:get_window()
+            -- Grab the server so that awesome cannot get any reply until
+            -- all requests were sent
+            GdkX11.x11_grab_server()
+            for i = 1, tonumber(options.reconfigure) do
+                gdk_window:resize(200 + i, 200 + i)
+            end
+            GdkX11.x11_ungrab_server()
+            Gdk.Display.get_default():flush()
+            return false
+        end)
+    end
 end
 
 local function parse_options(options)
@@ -163,6 +201,20 @@ return function(class, title, sn_rules, callback, resize_increment, args)
         assert(type(args.gravity)=="number","Use `lgi.Gdk.Gravity.NORTH_WEST`")
         options = options .. "gravity=" .. args.gravity .. ","
     end
+    if args.transient_for then
+        -- The title of a window that was opened before
+        options = options .. "transient_for=" .. args.transient_for .. ","
+    end
+    if args.retitle then
+        -- How often to change the title; afterwards it is `title .. " done"`.
+        -- This happens while the server is grabbed.
+        options = options .. "retitle=" .. args.retitle .. ","
+    end
+    if args.reconfigure then
+        -- How many ConfigureRequests to send; the last one is for 200+n.
+        -- They are sent while the server is grabbed.
+        options = options .. "reconfigure=" .. args.reconfigure .. ","
+    end
 
     local data = class .. "\n" .. title .. "\n" .. options .. "\n"
     local success, msg = pipe:write_all(data)
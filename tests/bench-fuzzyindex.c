@@ -0,0 +1,158 @@
+/*
+ * A microbenchmark for searching application and command names.
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/fuzzyindex.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * This mimics typing into the menubar or the run prompt: every keystroke
+ * searches all desktop entries and executables. The old code matched every
+ * entry; the index only looks at entries containing the query's n-grams. The
+ * results of both have to be the same.
+ */
+
+#define ENTRIES 10000
+#define ROUNDS 20
+
+static const char *const syllables[] = {
+    "fi", "re", "fox", "term", "in", "al", "x", "ed", "it", "or", "ka", "te",
+    "gi", "mp", "li", "bre", "off", "ice", "vi", "m", "code", "chro", "me",
+    "sh", "zip", "py", "thon", "ls", "cat", "grep", "ar", "set", "ting", "s",
+};
+
+static const char *const queries[] = {
+    "f", "fi", "fir", "fire", "firef", "term", "xterm", "ffx", "set", "zzz",
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+random_word(char *buf, int parts)
+{
+    buf[0] = '\0';
+    for(int i = 0; i < parts; i++)
+        strcat(buf, syllables[rand() % countof(syllables)]);
+}
+
+/* Match every entry and sort, like menubar's menulist_update() did */
+static fuzzyindex_t *linear_sorting;
+static uint8_t *linear_matches;
+
+static int
+linear_cmp(const void *a, const void *b)
+{
+    int x = *(const int *) a, y = *(const int *) b;
+    fuzzyindex_entry_t *ex = &linear_sorting->entries.tab[x];
+    fuzzyindex_entry_t *ey = &linear_sorting->entries.tab[y];
+
+    if(linear_matches[x] != linear_matches[y])
+        return linear_matches[y] - linear_matches[x];
+    if(ex->weight != ey->weight)
+        return ex->weight < ey->weight ? 1 : -1;
+    return x - y;
+}
+
+static void
+linear_search(fuzzyindex_t *idx, const char *query, int_array_t *results)
+{
+    results->len = 0;
+    for(int i = 0; i < idx->entries.len; i++)
+    {
+        linear_matches[i] = fuzzyindex_match(&idx->entries.tab[i], query);
+        if(linear_matches[i] != FUZZYINDEX_NO_MATCH)
+            int_array_append(results, i);
+    }
+    linear_sorting = idx;
+    qsort(results->tab, results->len, sizeof(int), linear_cmp);
+}
+
+int
+main(void)
+{
+    fuzzyindex_t idx = { 0 };
+    int_array_t linear_results = { 0 }, indexed_results = { 0 };
+    char name[64], cmdline[128];
+    double start;
+
+    srand(42);
+    start = now();
+    for(int i = 0; i < ENTRIES; i++)
+    {
+        random_word(name, 2 + rand() % 3);
+        random_word(cmdline, 1 + rand() % 2);
+        strcat(cmdline, " %U");
+        fuzzyindex_add(&idx, name, cmdline, rand() % 4 ? 0 : rand() % 50);
+    }
+    printf("%d entries indexed in %.1f ms\n", ENTRIES, (now() - start) * 1e3);
+
+    linear_matches = p_new(uint8_t, ENTRIES);
+
+    for(int q = 0; q < countof(queries); q++)
+    {
+        double linear, indexed, top;
+
+        start = now();
+        for(int i = 0; i < ROUNDS; i++)
+            linear_search(&idx, queries[q], &linear_results);
+        linear = now() - start;
+
+        start = now();
+        for(int i = 0; i < ROUNDS; i++)
+            fuzzyindex_search(&idx, queries[q], 0, FUZZYINDEX_SUBSEQUENCE, &indexed_results);
+        indexed = now() - start;
+
+        if(linear_results.len != indexed_results.len
+           || memcmp(linear_results.tab, indexed_results.tab,
+                     linear_results.len * sizeof(int)))
+            fatal("results for \"%s\" differ: %d vs %d entries", queries[q],
+                  linear_results.len, indexed_results.len);
+
+        start = now();
+        for(int i = 0; i < ROUNDS; i++)
+            fuzzyindex_search(&idx, queries[q], 10, FUZZYINDEX_SUBSEQUENCE, &indexed_results);
+        top = now() - start;
+
+        if(memcmp(linear_results.tab, indexed_results.tab,
+                  indexed_results.len * sizeof(int)))
+            fatal("top results for \"%s\" differ", queries[q]);
+
+        printf("%-6s %5d matches: %8.1f us linear, %7.1f us indexed, %7.1f us top 10\n",
+               queries[q], linear_results.len, linear * 1e6 / ROUNDS,
+               indexed * 1e6 / ROUNDS, top * 1e6 / ROUNDS);
+    }
+
+    int_array_wipe(&linear_results);
+    int_array_wipe(&indexed_results);
+    p_delete(&linear_matches);
+    fuzzyindex_wipe(&idx);
+
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,123 @@
+/*
+ * A microbenchmark for converting client icons.
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/iconcache.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * This mimics what happens when many windows of the same application are
+ * managed: every window has the same _NET_WM_ICON with a couple of sizes. The
+ * old code converted every size for every window with a floating point loop;
+ * now the first window converts its icons with an integer kernel and all
+ * others share the resulting surfaces.
+ */
+
+#define WINDOWS 100
+
+static const int sizes[] = { 16, 24, 32, 48, 64, 128, 256 };
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The conversion that was used before */
+static void
+premultiply_float(uint32_t *dst, const uint32_t *src, size_t len)
+{
+    for(size_t i = 0; i < len; i++)
+    {
+        uint8_t a = (src[i] >> 24) & 0xff;
+        double alpha = a / 255.0;
+        uint8_t r = ((src[i] >> 16) & 0xff) * alpha;
+        uint8_t g = ((src[i] >>  8) & 0xff) * alpha;
+        uint8_t b = ((src[i] >>  0) & 0xff) * alpha;
+        dst[i] = (a << 24) | (r << 16) | (g << 8) | b;
+    }
+}
+
+int
+main(void)
+{
+    uint32_t *icons[countof(sizes)];
+    cairo_surface_t *surfaces[WINDOWS][countof(sizes)];
+    size_t pixels = 0;
+    double start, elapsed_float, elapsed_int, elapsed_cache;
+
+    srand(42);
+    for(int i = 0; i < countof(sizes); i++)
+    {
+        size_t len = (size_t) sizes[i] * sizes[i];
+        icons[i] = p_new(uint32_t, len);
+        for(size_t j = 0; j < len; j++)
+            icons[i][j] = ((uint32_t) rand() << 16) ^ (uint32_t) rand();
+        pixels += len;
+    }
+
+    uint32_t *buffer = p_new(uint32_t, sizes[countof(sizes) - 1] * sizes[countof(sizes) - 1]);
+
+    start = now();
+    for(int w = 0; w < WINDOWS; w++)
+        for(int i = 0; i < countof(sizes); i++)
+            premultiply_float(buffer, icons[i], (size_t) sizes[i] * sizes[i]);
+    elapsed_float = now() - start;
+
+    start = now();
+    for(int w = 0; w < WINDOWS; w++)
+        for(int i = 0; i < countof(sizes); i++)
+            iconcache_premultiply(buffer, icons[i], (size_t) sizes[i] * sizes[i]);
+    elapsed_int = now() - start;
+
+    start = now();
+    for(int w = 0; w < WINDOWS; w++)
+        for(int i = 0; i < countof(sizes); i++)
+            surfaces[w][i] = iconcache_get(sizes[i], sizes[i], icons[i]);
+    elapsed_cache = now() - start;
+
+    printf("%d windows with %zu icon pixels each:\n", WINDOWS, pixels);
+    printf("  float premultiply:   %8.3f ms\n", elapsed_float * 1e3);
+    printf("  integer premultiply: %8.3f ms\n", elapsed_int * 1e3);
+    printf("  icon cache:          %8.3f ms (%lu of %lu lookups hit)\n",
+           elapsed_cache * 1e3, iconcache_stats.hits, iconcache_stats.lookups);
+
+    if(iconcache_stats.entries != countof(sizes))
+        fatal("expected %d cached icons, got %lu", (int) countof(sizes), iconcache_stats.entries);
+
+    /* Once all windows are gone, the cache is empty again */
+    for(int w = 0; w < WINDOWS; w++)
+        for(int i = 0; i < countof(sizes); i++)
+            cairo_surface_destroy(surfaces[w][i]);
+    if(iconcache_stats.entries != 0 || iconcache_stats.bytes != 0)
+        fatal("icon cache not empty after all surfaces were destroyed");
+
+    for(int i = 0; i < countof(sizes); i++)
+        p_delete(&icons[i]);
+    p_delete(&buffer);
+
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
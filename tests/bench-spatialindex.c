@@ -0,0 +1,246 @@
+/*
+ * A microbenchmark for finding clients by position and direction.
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/spatialindex.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * This mimics client.at() and awful.client.focus.bydirection(): find the
+ * client below a point and the nearest client in some direction. The old code
+ * looked at every visible client for this; the spatial index only looks at the
+ * grid cells around the query.
+ */
+
+#define QUERIES (1 << 16)
+#define WIDTH 3840
+#define HEIGHT 2160
+
+struct fake_client {
+    int x, y, width, height;
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct fake_client *
+linear_at(struct fake_client *clients, int n, int x, int y)
+{
+    for(int i = 0; i < n; i++)
+        if(x >= clients[i].x && x < clients[i].x + clients[i].width
+           && y >= clients[i].y && y < clients[i].y + clients[i].height)
+            return &clients[i];
+    return NULL;
+}
+
+static struct fake_client *
+indexed_at(spatialindex_t *idx, int x, int y)
+{
+    spatialindex_cell_array_t *cell = spatialindex_cell(idx, x, y);
+    if(cell)
+        foreach(item, *cell)
+            if(spatialindex_item_contains(*item, x, y))
+                return (*item)->object;
+    return NULL;
+}
+
+/* The same rules as gears.geometry.rectangle.get_in_direction() */
+static bool
+direction_distance(spatialindex_direction_t dir, struct fake_client *a,
+                   struct fake_client *b, double *dist)
+{
+    double ax = a->x, ay = a->y, bx = b->x, by = b->y;
+    bool in_direction = false;
+
+    switch(dir)
+    {
+    case SPATIALINDEX_UP:
+        in_direction = a->y > b->y;
+        by += b->height;
+        break;
+    case SPATIALINDEX_DOWN:
+        in_direction = a->y < b->y;
+        ay += a->height;
+        break;
+    case SPATIALINDEX_LEFT:
+        in_direction = a->x > b->x;
+        bx += b->width;
+        break;
+    case SPATIALINDEX_RIGHT:
+        in_direction = a->x < b->x;
+        ax += a->width;
+        break;
+    }
+
+    *dist = (bx - ax) * (bx - ax) + (by - ay) * (by - ay);
+    return in_direction;
+}
+
+static struct fake_client *
+linear_in_direction(struct fake_client *clients, int n,
+                    spatialindex_direction_t dir, struct fake_client *a)
+{
+    struct fake_client *best = NULL;
+    double best_dist = 0, dist;
+
+    for(int i = 0; i < n; i++)
+        if(direction_distance(dir, a, &clients[i], &dist)
+           && (!best || dist < best_dist))
+        {
+            best = &clients[i];
+            best_dist = dist;
+        }
+    return best;
+}
+
+/** Like linear_in_direction(), prefer the client that comes first */
+static bool
+fake_client_before(void *object, void *other, void *data)
+{
+    return object < other;
+}
+
+static void
+run(int n)
+{
+    struct fake_client *clients = p_new(struct fake_client, n);
+    int *queries = p_new(int, 2 * QUERIES);
+    spatialindex_t idx = { 0 };
+    unsigned long found_linear = 0, found_indexed = 0;
+    double start, linear, indexed;
+
+    /* The more clients, the smaller they are; like tiled clients on a few
+     * screens. Some of them are partly off screen. */
+    int max_width = MAX(200, 2 * WIDTH / (int) sqrt(n));
+    int max_height = MAX(150, 2 * HEIGHT / (int) sqrt(n));
+    srand(42);
+    for(int i = 0; i < n; i++)
+    {
+        clients[i].width = 50 + rand() % max_width;
+        clients[i].height = 50 + rand() % max_height;
+        clients[i].x = rand() % (WIDTH + 200) - 100;
+        clients[i].y = rand() % (HEIGHT + 200) - 100;
+        /* Some clients are at the same place, so that there are ties */
+        if(i % 8 == 7)
+            clients[i] = clients[i - 1];
+    }
+    /* Backwards, so that the order in the cells is not the one ties are
+     * broken by */
+    for(int i = n - 1; i >= 0; i--)
+        spatialindex_set(&idx, &clients[i], clients[i].x, clients[i].y,
+                         clients[i].width, clients[i].height);
+    for(int i = 0; i < 2 * QUERIES; i += 2)
+    {
+        queries[i] = rand() % WIDTH;
+        queries[i + 1] = rand() % HEIGHT;
+    }
+
+    /* Point queries */
+    start = now();
+    for(int i = 0; i < 2 * QUERIES; i += 2)
+        found_linear += linear_at(clients, n, queries[i], queries[i + 1]) != NULL;
+    linear = now() - start;
+
+    start = now();
+    for(int i = 0; i < 2 * QUERIES; i += 2)
+        found_indexed += indexed_at(&idx, queries[i], queries[i + 1]) != NULL;
+    indexed = now() - start;
+
+    if(found_linear != found_indexed)
+        fatal("point queries differ: %lu vs %lu", found_linear, found_indexed);
+    for(int i = 0; i < 2 * QUERIES; i += 2)
+    {
+        struct fake_client *c = indexed_at(&idx, queries[i], queries[i + 1]);
+        if(c && !linear_at(c, 1, queries[i], queries[i + 1]))
+            fatal("point query %d: found a client not containing the point", i / 2);
+    }
+
+    printf("%5d clients: %8.1f ns/point linear, %6.1f ns/point indexed\n",
+           n, linear * 1e9 / QUERIES, indexed * 1e9 / QUERIES);
+
+    /* Direction queries, starting from a random client each */
+    found_linear = found_indexed = 0;
+    start = now();
+    for(int i = 0; i < QUERIES; i++)
+        found_linear += linear_in_direction(clients, n, i % 4, &clients[queries[i] % n]) != NULL;
+    linear = now() - start;
+
+    start = now();
+    for(int i = 0; i < QUERIES; i++)
+    {
+        struct fake_client *c = &clients[queries[i] % n];
+        found_indexed += spatialindex_in_direction(&idx, i % 4, c->x, c->y,
+                                                   c->width, c->height, NULL,
+                                                   fake_client_before, NULL) != NULL;
+    }
+    indexed = now() - start;
+
+    if(found_linear != found_indexed)
+        fatal("direction queries differ: %lu vs %lu", found_linear, found_indexed);
+
+    /* Both have to find the same client, also when several are equally far */
+    for(int i = 0; i < QUERIES; i++)
+    {
+        struct fake_client *c = &clients[queries[i] % n];
+        struct fake_client *l = linear_in_direction(clients, n, i % 4, c);
+        struct fake_client *x = spatialindex_in_direction(&idx, i % 4,
+                c->x, c->y, c->width, c->height, NULL, fake_client_before, NULL);
+
+        if(l != x)
+            fatal("direction query %d: found %p instead of %p", i, (void *) x, (void *) l);
+    }
+
+    printf("%5d clients: %8.1f ns/direction linear, %6.1f ns/direction indexed\n",
+           n, linear * 1e9 / QUERIES, indexed * 1e9 / QUERIES);
+
+    /* Unmanage everything again and make sure the index ends up empty */
+    for(int i = 0; i < n; i++)
+        spatialindex_remove(&idx, &clients[i]);
+    if(idx.items.len != 0)
+        fatal("index not empty after removing all clients");
+    for(int i = 0; i < idx.cols * idx.rows; i++)
+        if(idx.cells[i].len != 0)
+            fatal("cell %d not empty after removing all clients", i);
+
+    spatialindex_wipe(&idx);
+    p_delete(&queries);
+    p_delete(&clients);
+}
+
+int
+main(void)
+{
+    const int counts[] = { 10, 30, 100, 300, 1000 };
+
+    for(int i = 0; i < countof(counts); i++)
+        run(counts[i]);
+
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,142 @@
+/*
+ * A microbenchmark for looking up windows by their id.
+ *
+ * Copyright © 2026 awesome developers
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+#include "common/windowindex.h"
+
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * This mimics what event.c does for every event: resolve the event window to a
+ * client via its frame, its own window or its nofocus window. The old code did
+ * a linear scan over all clients for each of these; the window index does a
+ * hash probe instead. The time per lookup should not depend on the number of
+ * managed clients.
+ */
+
+#define LOOKUPS (1 << 20)
+
+struct fake_client {
+    xcb_window_t window, frame_window, nofocus_window;
+};
+
+static double
+now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static struct fake_client *
+linear_getbyframewin(struct fake_client *clients, int n, xcb_window_t w)
+{
+    for(int i = 0; i < n; i++)
+        if(clients[i].frame_window == w)
+            return &clients[i];
+    return NULL;
+}
+
+static struct fake_client *
+linear_getbywin(struct fake_client *clients, int n, xcb_window_t w)
+{
+    for(int i = 0; i < n; i++)
+        if(clients[i].window == w)
+            return &clients[i];
+    return NULL;
+}
+
+static void
+run(int n)
+{
+    struct fake_client *clients = p_new(struct fake_client, n);
+    xcb_window_t *queries = p_new(xcb_window_t, LOOKUPS);
+    windowindex_t idx = { 0 };
+    unsigned long found = 0;
+    double start, linear, hashed;
+
+    /* Client windows come from many connections, our own windows are
+     * allocated sequentially from our resource id base. */
+    for(int i = 0; i < n; i++)
+    {
+        clients[i].window = 0x00800000 + (i << 8) + 0x0a;
+        clients[i].frame_window = 0x00400000 + 2 * i + 1;
+        clients[i].nofocus_window = 0x00400000 + 2 * i + 2;
+        windowindex_insert(&idx, clients[i].window, WINDOW_ROLE_CLIENT, &clients[i]);
+        windowindex_insert(&idx, clients[i].frame_window, WINDOW_ROLE_FRAME, &clients[i]);
+        windowindex_insert(&idx, clients[i].nofocus_window, WINDOW_ROLE_NOFOCUS, &clients[i]);
+    }
+
+    /* Half the events are for frames, half for client windows */
+    srand(42);
+    for(int i = 0; i < LOOKUPS; i++)
+    {
+        struct fake_client *c = &clients[rand() % n];
+        queries[i] = (i & 1) ? c->window : c->frame_window;
+    }
+
+    start = now();
+    for(int i = 0; i < LOOKUPS; i++)
+        found += linear_getbyframewin(clients, n, queries[i])
+            || linear_getbywin(clients, n, queries[i]);
+    linear = now() - start;
+
+    start = now();
+    for(int i = 0; i < LOOKUPS; i++)
+        found += windowindex_get(&idx, queries[i], WINDOW_ROLE_FRAME)
+            || windowindex_get(&idx, queries[i], WINDOW_ROLE_CLIENT);
+    hashed = now() - start;
+
+    if(found != 2 * LOOKUPS)
+        fatal("lookup failed: found %lu of %d windows", found, 2 * LOOKUPS);
+
+    printf("%5d clients: %10.1f ns/lookup linear, %6.1f ns/lookup indexed\n",
+           n, linear * 1e9 / LOOKUPS, hashed * 1e9 / LOOKUPS);
+
+    /* Unmanage everything again and make sure the index ends up empty */
+    for(int i = 0; i < n; i++)
+    {
+        windowindex_remove(&idx, clients[i].window);
+        windowindex_remove(&idx, clients[i].frame_window);
+        windowindex_remove(&idx, clients[i].nofocus_window);
+        if(windowindex_lookup(&idx, clients[i].window))
+            fatal("window %d still in index after removal", i);
+    }
+    if(idx.len != 0)
+        fatal("index not empty after removing all windows");
+
+    windowindex_wipe(&idx);
+    p_delete(&queries);
+    p_delete(&clients);
+}
+
+int
+main(void)
+{
+    const int counts[] = { 10, 100, 300, 1000, 5000 };
+
+    for(int i = 0; i < countof(counts); i++)
+        run(counts[i]);
+
+    return EXIT_SUCCESS;
+}
+
+// vim: filetype=c:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
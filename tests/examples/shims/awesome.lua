@@ -46,6 +46,9 @@ awesome.startup = true
 function awesome.register_xproperty()
 end
 
+function awesome.profile_record()
+end
+
 function awesome.xkb_get_group_names()
     return "pc+us+inet(evdev)"
 end
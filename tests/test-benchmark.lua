@@ -2,7 +2,11 @@
 -- that we notice if they break.
 
 local runner = require("_runner")
+local test_client = require("_client")
 local awful = require("awful")
+local wibox = require("wibox")
+local gfs = require("gears.filesystem")
+local icon_theme = require("menubar.icon_theme")
 local GLib = require("lgi").GLib
 local create_wibox = require("_wibox_helper").create_wibox
 
@@ -71,12 +75,232 @@ local function e2e_tag_switch()
     do_pending_repaint()
 end
 
+-- A bar with lots of widgets next to a clock. The whole bar is repainted, so
+-- every widget is drawn unless its drawing is cached.
+local function create_large_bar(cacheable)
+    local items = wibox.layout.fixed.horizontal()
+    for i = 1, 200 do
+        items:add(wibox.widget.textbox("item " .. i))
+    end
+    items:set_cacheable(cacheable)
+
+    local layout = wibox.layout.align.horizontal(items, nil, wibox.widget.textclock())
+    local wb = wibox({ width = 4000, height = 20, screen = 1 })
+    wb:set_widget(layout)
+    do_pending_repaint()
+    return layout
+end
+
+local large_bar = create_large_bar(false)
+local cached_large_bar = create_large_bar(true)
+
+local function redraw_large_bar()
+    large_bar:emit_signal("widget::redraw_needed")
+    do_pending_repaint()
+end
+
+local function redraw_cached_large_bar()
+    cached_large_bar:emit_signal("widget::redraw_needed")
+    do_pending_repaint()
+end
+
+-- A 4K bar full of graphs, drawn either on the X server (cairo-xcb) or into a
+-- MIT-SHM segment of which only the damaged part is uploaded. Every iteration
+-- adds a value to one graph and waits for the X server to finish, so that the
+-- server side of the work is included. The main loop does not run in between,
+-- so the completion event of the last upload is never handled before the next
+-- redraw and the MIT-SHM numbers include one extra round trip per iteration
+-- that a redraw from the main loop does not have.
+local graph_bar = wibox({ width = 3840, height = 30, screen = 1, visible = true })
+local graphs = wibox.layout.flex.horizontal()
+for _ = 1, 16 do
+    graphs:add(wibox.widget.graph { max_value = 100, step_width = 1 })
+end
+graph_bar:set_widget(graphs)
+do_pending_repaint()
+
+local graph_index = 0
+local function update_graph_bar()
+    graph_index = graph_index % #graphs.children + 1
+    graphs.children[graph_index]:add_value(math.random(100))
+    do_pending_repaint()
+    awesome.sync()
+end
+
+local function set_graph_bar_shm(shm)
+    graph_bar._drawable.drawable.shm = shm
+    do_pending_repaint()
+end
+
+-- Setting a key's modifiers emits property::modifiers from C
+local signal_objects = {}
+for i = 1, 10000 do
+    signal_objects[i] = key { key = "a" }
+end
+
+local function emit_property_signals()
+    for _, k in ipairs(signal_objects) do
+        k.modifiers = {}
+    end
+end
+
+-- Resolving the icons of a tasklist full of clients in a theme with many
+-- directories, like Adwaita or Papirus. A fifth of the icons do not exist and
+-- fall through to hicolor and the fallback directories.
+local icon_dir = os.tmpname()
+os.remove(icon_dir)
+local icon_names = {}
+do
+    local sizes = { 16, 22, 24, 32, 48, 64, 96, 128, 256 }
+    local contexts = { "actions", "apps", "devices", "mimetypes", "places", "status" }
+    local directories = {}
+    for _, size in ipairs(sizes) do
+        for _, context in ipairs(contexts) do
+            table.insert(directories, string.format("%dx%d/%s", size, size, context))
+        end
+    end
+    table.insert(directories, "scalable/apps")
+
+    local index = { "[Icon Theme]", "Name=bench", "Directories=" .. table.concat(directories, ",") }
+    for _, dir in ipairs(directories) do
+        local size = tonumber(dir:match("^(%d+)")) or 48
+        table.insert(index, string.format("[%s]\nSize=%d\nType=%s", dir, size,
+                                          dir:match("^scalable") and "Scalable" or "Fixed"))
+        assert(gfs.make_directories(icon_dir .. "/bench/" .. dir))
+    end
+    local f = assert(io.open(icon_dir .. "/bench/index.theme", "w"))
+    f:write(table.concat(index, "\n"), "\n")
+    f:close()
+
+    for i = 1, 500 do
+        icon_names[i] = "app-" .. i
+        if i % 5 ~= 0 then
+            local dirs = i % 3 == 0 and { "48x48/apps", "scalable/apps" }
+                or { "16x16/apps", "32x32/apps", "48x48/apps" }
+            for _, dir in ipairs(dirs) do
+                f = assert(io.open(string.format("%s/bench/%s/app-%d.png", icon_dir, dir, i), "w"))
+                f:close()
+            end
+        end
+    end
+end
+
+local function lookup_theme_icons()
+    local theme = icon_theme("bench", { icon_dir })
+    for _, name in ipairs(icon_names) do
+        theme:find_icon_path(name, 16)
+    end
+end
+
 benchmark(create_and_draw_wibox, "create&draw wibox")
 benchmark(update_textclock, "update textclock")
 benchmark(relayout_textclock, "relayout textclock")
 benchmark(redraw_textclock, "redraw textclock")
 benchmark(e2e_tag_switch, "tag switch")
+benchmark(redraw_large_bar, "redraw large bar")
+benchmark(redraw_cached_large_bar, "redraw cached bar")
+set_graph_bar_shm(false)
+benchmark(update_graph_bar, "graph bar (xcb)")
+set_graph_bar_shm(true)
+benchmark(update_graph_bar, "graph bar (shm)")
+graph_bar.visible = false
+benchmark(emit_property_signals, "emit on 10k objects")
+signal_objects[1]:connect_signal("property::modifiers", function() end)
+benchmark(emit_property_signals, "emit on 10k (1 conn)")
+signal_objects = nil
+benchmark(lookup_theme_icons, "500 theme icons")
+assert(os.execute("rm -rf '" .. icon_dir .. "'"))
+
+-- Tag switching with many clients spread over all tags. Spawning this many
+-- clients takes a while, so only do the full run for exact measurements (and
+-- set TEST_TIMEOUT accordingly).
+local client_count = BENCHMARK_EXACT and 1000 or 50
+local spawn_batch = 25
+
+local steps = {}
+for batch = 1, math.ceil(client_count / spawn_batch) do
+    local target = math.min(batch * spawn_batch, client_count)
+    table.insert(steps, function(count)
+        if count == 1 then
+            for i = #client.get() + 1, target do
+                test_client(nil, "benchmark client " .. i)
+            end
+        end
+        if #client.get() >= target then
+            return true
+        end
+    end)
+end
+
+-- Capturing a lot of output: line by line in Lua versus in one piece in C
+local spawn_output_cmd = { "sh", "-c", "head -c 1048576 /dev/zero | tr '\\0' x | fold -w 99" }
+local spawn_timer = GLib.Timer()
+local spawn_results = {}
+
+table.insert(steps, function(count)
+    if count == 1 then
+        spawn_timer:start()
+        local stdout = ""
+        awful.spawn.with_line_callback(spawn_output_cmd, {
+            stdout = function(line) stdout = stdout .. line .. "\n" end,
+            output_done = function()
+                spawn_results.lines = { spawn_timer:elapsed(), #stdout }
+            end,
+        })
+    end
+    return spawn_results.lines ~= nil or nil
+end)
+
+table.insert(steps, function(count)
+    if count == 1 then
+        spawn_timer:start()
+        awful.spawn.easy_async(spawn_output_cmd, function(stdout)
+            spawn_results.capture = { spawn_timer:elapsed(), #stdout }
+        end)
+    end
+    if not spawn_results.capture then
+        return
+    end
+
+    assert(spawn_results.lines[2] == spawn_results.capture[2])
+    print(string.format("%20s: %-10.6g sec", "spawn 1MB (lines)", spawn_results.lines[1]))
+    print(string.format("%20s: %-10.6g sec", "spawn 1MB (capture)", spawn_results.capture[1]))
+    return true
+end)
+
+table.insert(steps, function()
+    local tags = awful.screen.focused().tags
+    for i, c in ipairs(client.get()) do
+        c:tags({ tags[i % #tags + 1] })
+    end
+    do_pending_repaint()
+
+    benchmark(e2e_tag_switch, string.format("tag switch (%d c)", client_count))
+    return true
+end)
+
+-- Main loop wakeups where nothing changed should not have to look at any of
+-- the clients.
+local idle_refresh
+table.insert(steps, function(count)
+    if count == 1 then
+        idle_refresh = awesome.stats().refresh
+        return
+    end
+    if count < 20 then
+        return
+    end
+
+    local stats = awesome.stats().refresh
+    local refreshes = stats.refreshes - idle_refresh.refreshes
+    local visited = stats.clients - idle_refresh.clients
+        + stats.drawins - idle_refresh.drawins
+    print(string.format("%20s: %-10.6g objects/refresh (%d refreshes)",
+                        string.format("idle wakeup (%d c)", client_count),
+                        visited / refreshes, refreshes))
+    return true
+end)
 
-runner.run_steps({ function() return true end })
+runner.run_steps(steps)
 
 -- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,138 @@
+-- Test client.at(), client.in_direction() and screen.at() against the plain
+-- Lua implementations in gears.geometry
+
+local runner = require("_runner")
+local test_client = require("_client")
+local grect = require("gears.geometry").rectangle
+
+local clients = {}
+
+local function check_directions()
+    local visible, geometries = {}, {}
+    for _, c in ipairs(client.get()) do
+        if c:isvisible() then
+            table.insert(visible, c)
+            table.insert(geometries, c:geometry())
+        end
+    end
+
+    for _, c in ipairs(visible) do
+        for _, dir in ipairs { "up", "down", "left", "right" } do
+            local expected = grect.get_in_direction(dir, geometries, c:geometry())
+            expected = expected and visible[expected]
+            local got = client.in_direction(c, dir)
+            assert(got == expected, string.format("%s of %s: %s instead of %s",
+                   dir, c.name, got and got.name, expected and expected.name))
+        end
+    end
+end
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            for i = 1, 3 do
+                test_client("client" .. i, "client" .. i)
+            end
+        end
+        if #client.get() >= 3 then
+            for _, c in ipairs(client.get()) do
+                clients[c.name] = c
+                c.floating = true
+            end
+            return true
+        end
+    end,
+
+    function()
+        clients.client1:geometry { x = 0, y = 0, width = 200, height = 200 }
+        clients.client2:geometry { x = 300, y = 20, width = 200, height = 200 }
+        clients.client3:geometry { x = 20, y = 300, width = 200, height = 200 }
+        return true
+    end,
+
+    function()
+        local c1, c2, c3 = clients.client1, clients.client2, clients.client3
+
+        assert(client.at(100, 100) == c1)
+        assert(client.at(350, 100) == c2)
+        assert(client.at(100, 350) == c3)
+        assert(client.at(250, 250) == nil)
+
+        assert(client.in_direction(c1, "right") == c2)
+        assert(client.in_direction(c1, "down") == c3)
+        assert(client.in_direction(c1, "left") == nil)
+        assert(client.in_direction({ x = 250, y = 0, width = 10, height = 10 }, "left") == c1)
+        assert(client.in_direction(c1, "right", screen[1]) == c2)
+        check_directions()
+
+        assert(screen.at(0, 0) == screen[1])
+        assert(screen.at(-10, -10) == nil)
+        for s in screen do
+            local geo = s.geometry
+            assert(screen.at(geo.x + geo.width - 1, geo.y + geo.height - 1) == s)
+        end
+
+        -- Changes are visible right away, before the next refresh
+        c2:geometry { x = 100, y = 100 }
+        c2:raise()
+        assert(client.in_direction(c1, "right") == c2)
+        check_directions()
+
+        c3.minimized = true
+        assert(client.in_direction(c1, "down") == c2)
+        check_directions()
+        return true
+    end,
+
+    function()
+        local c1, c2 = clients.client1, clients.client2
+
+        -- The raised client is on top where both overlap
+        assert(client.at(150, 150) == c2)
+        assert(client.at(50, 50) == c1)
+        assert(client.at(100, 350) == nil)
+
+        c1:raise()
+        return true
+    end,
+
+    function()
+        assert(client.at(150, 150) == clients.client1)
+
+        -- Two clients at the same distance to the right
+        clients.client3.minimized = false
+        clients.client2:geometry { x = 300, y = 0 }
+        clients.client3:geometry { x = 300, y = 200 }
+        return true
+    end,
+
+    function()
+        local source = { x = 0, y = 100, width = 10, height = 10 }
+        local expected
+        for _, c in ipairs(client.get()) do
+            if c == clients.client2 or c == clients.client3 then
+                expected = c
+                break
+            end
+        end
+
+        -- Ties are broken by the order of client.get(), like in the Lua
+        -- implementation
+        assert(client.in_direction(source, "right") == expected)
+        check_directions()
+
+        for _, c in ipairs(client.get()) do
+            c:kill()
+        end
+        return true
+    end,
+
+    function()
+        if #client.get() > 0 then return end
+        assert(client.at(100, 100) == nil)
+        assert(client.in_direction({ x = 0, y = 0, width = 1, height = 1 }, "right") == nil)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
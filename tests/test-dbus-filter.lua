@@ -0,0 +1,65 @@
+-- Test filtering and lazy decoding of D-Bus messages
+local runner = require("_runner")
+local awful = require("awful")
+
+local interface = "org.awesomewm.filter"
+local pings = 0
+
+local function dbus_callback(data, list)
+    assert(data.member == "Ping", data.member)
+    -- Arrays of strings are passed as proxies
+    assert(type(list) == "userdata")
+    assert(list[1] == "a" and list[2] == "b" and #list == 2)
+    local plain = dbus.decode(list)
+    assert(type(plain) == "table" and #plain == 2)
+    assert(dbus.decode(plain) == plain)
+    pings = pings + 1
+end
+
+dbus.request_name("session", interface)
+assert(dbus.connect_signal(interface, dbus_callback,
+    { members = { "Ping" }, lazy = true }))
+
+local function send(member)
+    awful.spawn({
+                "dbus-send",
+                "--dest=" .. interface,
+                "--type=method_call",
+                "/",
+                interface .. "." .. member,
+                "array:string:a,b"
+            })
+end
+
+runner.run_steps({
+    function()
+        send("Pong")
+        send("Ping")
+        return true
+    end,
+    function()
+        local stats = dbus.stats()[interface]
+        if pings < 1 or not stats or stats.filtered < 1 then return end
+
+        assert(pings == 1)
+        assert(stats.messages == 2, stats.messages)
+        assert(stats.filtered == 1, stats.filtered)
+        assert(stats.bytes > 0)
+        assert(stats.decode_time >= 0)
+
+        -- Without a receiver nothing is decoded at all
+        dbus.disconnect_signal(interface, dbus_callback)
+        send("Ping")
+        return true
+    end,
+    function()
+        local stats = dbus.stats()[interface]
+        if stats.messages < 3 then return end
+
+        assert(stats.filtered == 2, stats.filtered)
+        assert(pings == 1)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
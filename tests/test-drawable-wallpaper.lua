@@ -0,0 +1,94 @@
+-- Test that the cached wallpaper below translucent wiboxes is only fetched when
+-- it can have changed and that it is updated when the wallpaper changes
+
+local runner = require("_runner")
+local wibox = require("wibox")
+local gears_surface = require("gears.surface")
+local gears_wallpaper = require("gears.wallpaper")
+local lgi = require("lgi")
+local cairo = lgi.cairo
+local Gdk = lgi.Gdk
+
+local textbox = wibox.widget.textbox("")
+local w = wibox {
+    x = 10,
+    y = 10,
+    width = 100,
+    height = 20,
+    visible = true,
+    bg = "#ff000080",
+    widget = textbox,
+}
+
+local function pixel_at(x, y)
+    local content = gears_surface(root.content())
+    local img = cairo.ImageSurface(cairo.Format.RGB24, 1, 1)
+    local cr = cairo.Context(img)
+    cr:set_source_surface(content, -x, -y)
+    cr:paint()
+    img:flush()
+
+    local data = Gdk.pixbuf_get_from_surface(img, 0, 0, 1, 1):get_pixels_with_length()
+    if type(data) == "string" then
+        return data:byte(1, 3)
+    end
+    return data[1], data[2], data[3]
+end
+
+-- Count how often the wallpaper is fetched (setting it does not count)
+local wallpaper_fetches = 0
+local orig_wallpaper = root.wallpaper
+root.wallpaper = function(...)
+    if select("#", ...) == 0 then
+        wallpaper_fetches = wallpaper_fetches + 1
+    end
+    return orig_wallpaper(...)
+end
+
+runner.run_steps({
+    function()
+        gears_wallpaper.set("#0000ff")
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+        local r, g, b = pixel_at(w.x + 50, w.y + 10)
+        assert(r > 100 and g < 10 and b > 100, string.format("%d %d %d", r, g, b))
+
+        -- Redrawing does not need the wallpaper again
+        wallpaper_fetches = 0
+        for i = 1, 10 do
+            textbox.text = "tick " .. i
+            require("gears.timer").run_delayed_calls_now()
+        end
+        assert(wallpaper_fetches == 0, wallpaper_fetches)
+
+        gears_wallpaper.set("#00ff00")
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+        local r, g, b = pixel_at(w.x + 50, w.y + 10)
+        assert(r > 100 and g > 100 and b < 10, string.format("%d %d %d", r, g, b))
+        assert(wallpaper_fetches > 0)
+
+        -- Moving the wibox needs the wallpaper below its new position
+        wallpaper_fetches = 0
+        w.x = 200
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+        local r, g, b = pixel_at(w.x + 50, w.y + 10)
+        assert(r > 100 and g > 100 and b < 10, string.format("%d %d %d", r, g, b))
+        assert(wallpaper_fetches > 0)
+
+        root.wallpaper = orig_wallpaper
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,55 @@
+-- Test that a burst of ConfigureRequests is merged before it reaches Lua
+
+local runner = require("_runner")
+local test_client = require("_client")
+
+local reconfigure_count = 30
+local final_size = 200 + reconfigure_count
+local stats_before
+local requests = 0
+
+-- Getting an X property is always a round trip
+awesome.register_xproperty("_AWESOME_TEST_SYNC", "string")
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            stats_before = awesome.stats().events
+            test_client(nil, "reconfigured", nil, nil, nil, { reconfigure = reconfigure_count })
+        end
+        local c = client.get()[1]
+        if c and not c.counting then
+            c.counting = true
+            c:connect_signal("request::geometry", function(_, context)
+                if context == "ewmh" then
+                    requests = requests + 1
+                    -- The client sends its requests while it grabs the
+                    -- server, so this round trip only finishes once all of
+                    -- them were generated. The rest then arrives in one
+                    -- batch, however the events happen to be read.
+                    if requests == 1 then
+                        c:get_xproperty("_AWESOME_TEST_SYNC")
+                    end
+                end
+            end)
+        end
+        if c and c.width == final_size then
+            return true
+        end
+    end,
+
+    function()
+        local stats = awesome.stats().events
+        local collapsed = stats.configure_requests - stats_before.configure_requests
+
+        -- The last request always wins
+        assert(client.get()[1].width == final_size)
+        assert(collapsed >= reconfigure_count - 2, collapsed)
+        assert(requests + collapsed >= reconfigure_count, requests .. " " .. collapsed)
+        assert(requests <= 2, requests)
+        assert(stats.events >= stats.drains)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,85 @@
+-- Test that exposed parts of a drawin are repainted correctly and with few
+-- CopyArea requests
+
+local runner = require("_runner")
+local wibox = require("wibox")
+local gears_surface = require("gears.surface")
+local lgi = require("lgi")
+local cairo = lgi.cairo
+local Gdk = lgi.Gdk
+
+local base = wibox {
+    x = 10,
+    y = 10,
+    width = 200,
+    height = 40,
+    visible = true,
+    bg = "#ff0000",
+    widget = wibox.widget.textbox("Some text so that not all pixels are equal"),
+}
+
+-- Narrow wiboxes next to each other that together cover the base
+local covers = {}
+for i = 1, 20 do
+    covers[i] = wibox {
+        x = base.x + (i - 1) * 10,
+        y = base.y,
+        width = 10,
+        height = base.height,
+        ontop = true,
+        bg = "#0000ff",
+    }
+end
+
+local function base_pixels()
+    local content = gears_surface(root.content())
+    local img = cairo.ImageSurface(cairo.Format.RGB24, base.width, base.height)
+    local cr = cairo.Context(img)
+    cr:set_source_surface(content, -base.x, -base.y)
+    cr:paint()
+    img:flush()
+
+    local pixbuf = Gdk.pixbuf_get_from_surface(img, 0, 0, base.width, base.height)
+    local data = pixbuf:get_pixels_with_length()
+    if type(data) == "table" then
+        data = table.concat(data, ",")
+    end
+    return data
+end
+
+local expected, stats_before
+
+runner.run_steps({
+    function(count)
+        if count < 3 then return end
+        expected = base_pixels()
+        for _, w in ipairs(covers) do
+            w.visible = true
+        end
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+        assert(base_pixels() ~= expected)
+        stats_before = awesome.stats().expose
+        for _, w in ipairs(covers) do
+            w.visible = false
+        end
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+        local stats = awesome.stats().expose
+        local events = stats.events - stats_before.events
+        local copies = stats.copies - stats_before.copies
+
+        assert(base_pixels() == expected)
+        assert(events >= #covers, events)
+        assert(copies > 0 and copies < events, copies .. " " .. events)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
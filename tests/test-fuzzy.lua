@@ -0,0 +1,100 @@
+-- Test fuzzy indices and completing commands from $PATH with them
+
+local runner = require("_runner")
+local completion = require("awful.completion")
+local GLib = require("lgi").GLib
+
+local bindir = os.tmpname()
+os.remove(bindir)
+assert(os.execute("mkdir -p '" .. bindir .. "'"))
+
+local function add_executable(name)
+    assert(os.execute(string.format("touch '%s/%s' && chmod +x '%s/%s'",
+                                    bindir, name, bindir, name)))
+end
+
+local orig_path = GLib.getenv("PATH")
+
+runner.run_steps({
+    function()
+        local index = fuzzy.new()
+        index:add("Firefox", "firefox %u", 1)
+        index:add("Terminal", "xterm", 2)
+        index:add("File manager", "pcmanfm", 3)
+        index:add("Text editor", "gedit", 4)
+        assert(#index == 4)
+
+        -- Prefix matches first, then substrings, then subsequences
+        assert(table.concat(index:search("fi"), ",") == "1,3")
+        assert(table.concat(index:search("TER"), ",") == "2,4")
+        assert(table.concat(index:search("fox"), ",") == "1")
+        assert(table.concat(index:search("ffx"), ",") == "1")
+        assert(table.concat(index:search("e", nil, "prefix"), ",") == "")
+        assert(table.concat(index:search("xterm", nil, "substring"), ",") == "2")
+        assert(#index:search("zzz") == 0)
+
+        -- An empty query returns everything in order
+        assert(table.concat(index:search(""), ",") == "1,2,3,4")
+        assert(table.concat(index:search("", 2), ",") == "1,2")
+
+        -- Weights rank within the same kind of match
+        index:set_weight("File manager", 5)
+        assert(table.concat(index:search("fi"), ",") == "3,1")
+        assert(table.concat(index:search("fi", 1), ",") == "3")
+
+        -- The name is the default value
+        index:clear()
+        assert(#index == 0)
+        index:add("awesome")
+        assert(index:search("aw")[1] == "awesome")
+
+        assert(awesome.stats().fuzzy.searches >= 10)
+        return true
+    end,
+
+    function()
+        -- The shell's own commands are listed once, while it can still be
+        -- found in $PATH
+        local matches = select(3, completion.shell("ech", 4, 1, "bash"))
+        assert(matches and matches[1] == "echo", matches and table.concat(matches, ","))
+
+        add_executable("awesome-test-one")
+        add_executable("awesome-test-two")
+        add_executable("echo-awesome-test")
+        assert(os.execute("touch '" .. bindir .. "/awesome-test-data'"))
+        GLib.setenv("PATH", bindir, true)
+
+        local index = fuzzy.executables()
+        assert(table.concat(index:search("awesome-test"), ",")
+               == "awesome-test-one,awesome-test-two")
+
+        local command, pos
+        command, pos, matches = completion.shell("awesome-test-t", 15, 1, "bash")
+        assert(command == "awesome-test-two")
+        assert(pos == 17)
+        assert(#matches == 1)
+
+        -- New executables are found after the directory changed
+        local rescans = awesome.stats().fuzzy.rescans
+        add_executable("awesome-test-three")
+        matches = select(3, completion.shell("awesome-test-t", 15, 1, "bash"))
+        assert(table.concat(matches, ",") == "awesome-test-three,awesome-test-two")
+        assert(awesome.stats().fuzzy.rescans == rescans + 1)
+
+        -- Nothing changed, nothing is read again
+        completion.shell("awesome-test-t", 15, 1, "bash")
+        assert(awesome.stats().fuzzy.rescans == rescans + 1)
+
+        -- Executables are merged with the shell's builtins, although the
+        -- shell cannot be run anymore
+        matches = select(3, completion.shell("ech", 4, 1, "bash"))
+        assert(table.concat(matches, ",") == "echo,echo-awesome-test",
+               table.concat(matches, ","))
+
+        GLib.setenv("PATH", orig_path, true)
+        assert(os.execute("rm -r '" .. bindir .. "'"))
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
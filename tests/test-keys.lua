@@ -0,0 +1,68 @@
+-- Test that key bindings are found among many others and that ignored
+-- modifiers do not prevent a binding from matching, even when the binding
+-- itself uses one of them.
+
+local awful = require("awful")
+local gtable = require("gears.table")
+local runner = require("_runner")
+
+local pressed = 0
+local lock_pressed = 0
+local old_keys
+
+runner.run_steps({
+    function()
+        old_keys = root.keys()
+
+        -- Lots of bindings that do not match
+        local keys = {}
+        for i = 1, 600 do
+            keys = gtable.join(keys, awful.key({ "Mod4", "Control" }, "#" .. (10 + i % 80),
+                                               function() error("wrong key") end))
+        end
+
+        -- Ignored modifiers no longer need one key object per combination
+        local binding = awful.key({}, "F12", function() pressed = pressed + 1 end)
+        assert(#binding == 1, #binding)
+        assert(gtable.hasitem(binding[1].ignore_modifiers, "Lock"))
+        assert(not gtable.hasitem(binding[1].modifiers, "Lock"))
+
+        -- Lock is both ignored and required here, so it is not ignored
+        local lock_binding = awful.key({ "Lock" }, "F11",
+                                       function() lock_pressed = lock_pressed + 1 end)
+
+        root.keys(gtable.join(keys, binding, lock_binding))
+
+        root.fake_input("key_press", "F11")
+        root.fake_input("key_release", "F11")
+        root.fake_input("key_press", "F12")
+        root.fake_input("key_release", "F12")
+        return true
+    end,
+
+    function()
+        if pressed ~= 1 then return end
+        assert(lock_pressed == 0, lock_pressed)
+
+        -- Turn on Caps Lock; the binding still has to work
+        root.fake_input("key_press", "Caps_Lock")
+        root.fake_input("key_release", "Caps_Lock")
+        root.fake_input("key_press", "F11")
+        root.fake_input("key_release", "F11")
+        root.fake_input("key_press", "F12")
+        root.fake_input("key_release", "F12")
+        return true
+    end,
+
+    function()
+        if pressed ~= 2 then return end
+        assert(lock_pressed == 1, lock_pressed)
+
+        root.fake_input("key_press", "Caps_Lock")
+        root.fake_input("key_release", "Caps_Lock")
+        root.keys(old_keys)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,164 @@
+-- Test the persistent cache of parsed .desktop files in menubar.utils
+
+local runner = require("_runner")
+local GLib = require("lgi").GLib
+
+-- The same lgi problems as in test-menubar.lua apply here
+if _VERSION == "Lua 5.3" or debug.gethook() or jit then --luacheck: globals jit
+    print("Skipping this test since it would just fail.")
+    runner.run_steps { function() return true end }
+    return
+end
+
+local root = os.tmpname()
+os.remove(root)
+local apps = root .. "/applications"
+local cache_file = root .. "/cache/awesome/menubar_cache"
+
+local function write(path, content)
+    local f = assert(io.open(path, "w"))
+    f:write(content)
+    f:close()
+end
+
+-- A fresh copy of menubar.utils, as after a restart
+local parses
+local function load_utils()
+    package.loaded["menubar.utils"] = nil
+    local utils = require("menubar.utils")
+    local parse_desktop_file = utils.parse_desktop_file
+    function utils.parse_desktop_file(...)
+        parses = parses + 1
+        return parse_desktop_file(...)
+    end
+    parses = 0
+    return utils
+end
+
+local function find(programs, name)
+    for _, program in ipairs(programs) do
+        if program.Name == name then
+            return program
+        end
+    end
+end
+
+local tricky_name = "Tab\there\nnew line\\back slash"
+local calls, parsed_entry
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            assert(os.execute("mkdir -p '" .. apps .. "' '" .. root .. "/cache'"))
+            GLib.setenv("XDG_CACHE_HOME", root .. "/cache", true)
+            write(apps .. "/tricky.desktop", table.concat({
+                "[Desktop Entry]",
+                "Type=Application",
+                "Name=Tab\\there\\nnew line\\\\back slash",
+                "Exec=tricky --path a\\\\b",
+                "Categories=Utility;Development;",
+            }, "\n") .. "\n")
+
+            -- Nothing is cached yet, so there is only the background parse
+            calls = {}
+            load_utils().parse_dir_cached(apps, function(programs)
+                table.insert(calls, programs)
+            end)
+            assert(#calls == 0)
+        end
+
+        if #calls == 0 then return end
+        local f = io.open(cache_file)
+        if not f then return end
+        f:close()
+        assert(#calls == 1)
+        assert(parses == 1, parses)
+        parsed_entry = find(calls[1], tricky_name)
+        assert(parsed_entry, "entry not found")
+        return true
+    end,
+
+    function(count)
+        if count == 1 then
+            -- A warm start gets the entries right away, without parsing
+            calls = {}
+            load_utils().parse_dir_cached(apps, function(programs)
+                table.insert(calls, programs)
+            end)
+            assert(#calls == 1)
+            local cached = find(calls[1], tricky_name)
+            assert(cached, "entry not cached")
+            for _, field in ipairs({ "file", "show", "Name", "cmdline", "icon_path" }) do
+                assert(cached[field] == parsed_entry[field], field)
+            end
+            assert(table.concat(cached.categories, ";") == "Utility;Development")
+        end
+
+        -- Give the background check time to run
+        if count < 5 then return end
+        assert(#calls == 1, #calls)
+        assert(parses == 0, parses)
+        return true
+    end,
+
+    function(count)
+        if count == 1 then
+            -- Adding a file modifies the menu dir
+            write(apps .. "/other.desktop",
+                  "[Desktop Entry]\nType=Application\nName=Other\nExec=other\n")
+            calls = {}
+            load_utils().parse_dir_cached(apps, function(programs)
+                table.insert(calls, programs)
+            end)
+            assert(#calls == 1)
+            assert(not find(calls[1], "Other"))
+        end
+
+        if #calls < 2 then return end
+        assert(#calls == 2, #calls)
+        assert(find(calls[2], "Other"))
+        assert(find(calls[2], tricky_name))
+        assert(parses == 2, parses)
+        return true
+    end,
+
+    function(count)
+        if count == 1 then
+            -- The icon directories are system directories that cannot be
+            -- touched from here, so make the cache look like one of them
+            -- changed since it was written
+            local f = assert(io.open(cache_file))
+            local content = f:read("*a")
+            f:close()
+            local touched
+            content, touched = content:gsub("\nicon_dir\t([^\t\n]*)\t[^\n]*",
+                                            "\nicon_dir\t%1\t0.0")
+            if touched == 0 then
+                content = content .. "icon_dir\t/nonexistent\t0.0\n"
+            end
+            write(cache_file, content)
+
+            calls = {}
+            load_utils().parse_dir_cached(apps, function(programs)
+                table.insert(calls, programs)
+            end)
+            assert(#calls == 1)
+        end
+
+        -- The entries contain icons that were looked up, so they are parsed
+        -- again
+        if #calls < 2 then return end
+        assert(#calls == 2, #calls)
+        assert(parses == 2, parses)
+        return true
+    end,
+
+    function()
+        GLib.unsetenv("XDG_CACHE_HOME")
+        package.loaded["menubar.utils"] = nil
+        assert(os.execute("rm -rf '" .. root .. "'"))
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
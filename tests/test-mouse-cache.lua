@@ -0,0 +1,124 @@
+-- Test that the pointer position is tracked from events instead of asking the
+-- X server each time, without ever being out of date
+
+local runner = require("_runner")
+local test_client = require("_client")
+local wibox = require("wibox")
+
+local w = wibox {
+    x = 100,
+    y = 100,
+    width = 200,
+    height = 50,
+    visible = true,
+}
+
+local function check_coords(x, y)
+    local coords = mouse.coords()
+    assert(coords.x == x and coords.y == y,
+           string.format("%d,%d instead of %d,%d", coords.x, coords.y, x, y))
+    assert(mouse.screen == screen[1])
+end
+
+local stats, c, geo, other_screen
+
+runner.run_steps({
+    function()
+        root.fake_input("motion_notify", false, 150, 120)
+        return true
+    end,
+
+    -- Over a drawin all motion is reported, so nothing has to be queried
+    function(count)
+        if count < 3 then return end
+        check_coords(150, 120)
+        stats = awesome.stats().pointer
+        for _ = 1, 10 do
+            check_coords(150, 120)
+        end
+        local new = awesome.stats().pointer
+        assert(new.queries == stats.queries, new.queries - stats.queries)
+        assert(new.cached >= stats.cached + 20, new.cached - stats.cached)
+
+        root.fake_input("motion_notify", false, w.x + w.width + 100, 300)
+        return true
+    end,
+
+    -- Over the root window, only the first read after a movement queries
+    function(count)
+        if count < 3 then return end
+        stats = awesome.stats().pointer
+        for _ = 1, 10 do
+            check_coords(w.x + w.width + 100, 300)
+        end
+        local new = awesome.stats().pointer
+        assert(new.queries <= stats.queries + 1, new.queries - stats.queries)
+
+        root.fake_input("motion_notify", false, w.x + w.width + 120, 320)
+        return true
+    end,
+
+    function(count)
+        if count < 3 then return end
+        check_coords(w.x + w.width + 120, 320)
+
+        -- Warping and syncing are never answered from the cache
+        mouse.coords { x = 160, y = 130 }
+        check_coords(160, 130)
+        stats = awesome.stats().pointer
+        mouse.sync()
+        check_coords(160, 130)
+        assert(awesome.stats().pointer.queries == stats.queries + 1)
+
+        -- Split the screen in two halves
+        geo = screen[1].geometry
+        screen[1]:fake_resize(geo.x, geo.y, geo.width / 2, geo.height)
+        other_screen = screen.fake_add(geo.x + geo.width / 2, geo.y,
+                                       geo.width / 2, geo.height)
+        test_client("mouse_cache", "mouse_cache")
+        return true
+    end,
+
+    function()
+        c = client.get()[1]
+        if not c then return end
+        c.floating = true
+        c:geometry { x = 50, y = 200, width = 200, height = 200 }
+        return true
+    end,
+
+    function()
+        root.fake_input("motion_notify", false, 150, 300)
+        return true
+    end,
+
+    -- In a client, the screen comes from the client's geometry
+    function(count)
+        if count < 3 then return end
+        assert(mouse.screen == screen[1])
+        stats = awesome.stats().pointer
+        assert(mouse.screen == screen[1])
+        assert(awesome.stats().pointer.queries == stats.queries)
+
+        -- Moving the client does not move the pointer
+        c.screen = other_screen
+        assert(c.screen == other_screen)
+        assert(mouse.screen == screen[1])
+        c:geometry { x = geo.x + geo.width / 2 + 50 }
+        assert(mouse.screen == screen[1])
+        return true
+    end,
+
+    function(count)
+        if count == 1 then
+            c:kill()
+        end
+        if #client.get() > 0 then return end
+
+        other_screen:fake_remove()
+        screen[1]:fake_resize(geo.x, geo.y, geo.width, geo.height)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,84 @@
+-- Test the main loop statistics and their D-Bus interface
+local runner = require("_runner")
+local awful = require("awful")
+require("awful.remote")
+
+local refreshes = 0
+local function on_refresh()
+    refreshes = refreshes + 1
+end
+
+local report
+
+runner.run_steps({
+    function(count)
+        if count < 3 then return end
+
+        local stats = awesome.stats().mainloop
+        assert(stats.mode == "phases")
+        for _, phase in ipairs({ "iteration", "events", "sources", "property",
+                "refresh", "drawins", "clients", "banning", "stack", "destroy" }) do
+            local entry = stats.phases[phase]
+            assert(entry, phase)
+            assert(entry.count > 0, phase)
+            assert(entry.max <= entry.total + 1e-9, phase)
+            local sum = 0
+            for _, n in ipairs(entry.histogram) do
+                sum = sum + n
+            end
+            assert(sum == entry.count, phase)
+        end
+        assert(next(stats.callbacks) == nil)
+
+        awesome.profile_record("test section", 0.25)
+        stats = awesome.stats().mainloop
+        assert(stats.sections["test section"].count == 1)
+        assert(stats.sections["test section"].max == 0.25)
+
+        assert(not pcall(awesome.set_profile_mode, "nonsense"))
+        awesome.set_profile_mode("detailed")
+        awesome.connect_signal("refresh", on_refresh)
+        return true
+    end,
+    function()
+        if refreshes < 2 then return end
+
+        local stats = awesome.stats().mainloop
+        assert(stats.mode == "detailed")
+        local found = false
+        for name, entry in pairs(stats.callbacks) do
+            if name:match("test%-profile%.lua") then
+                found = entry.count >= 2
+            end
+        end
+        assert(found)
+
+        awesome.disconnect_signal("refresh", on_refresh)
+        awesome.set_profile_mode("phases")
+        awesome.profile_reset()
+        stats = awesome.stats().mainloop
+        assert(next(stats.sections) == nil and next(stats.callbacks) == nil)
+
+        awful.spawn.easy_async({ "dbus-send", "--session", "--print-reply",
+            "--dest=org.awesomewm.awful", "/",
+            "org.awesomewm.awful.Remote.Stats" }, function(stdout)
+            report = stdout
+        end)
+        return true
+    end,
+    function()
+        if not report then return end
+
+        assert(report:match("mode: phases"), report)
+        assert(report:match("phases iteration: count=%d+"), report)
+
+        -- Answering the Stats call and its output are attributed to D-Bus and
+        -- spawn
+        local phases = awesome.stats().mainloop.phases
+        assert(phases.dbus.count > 0)
+        assert(phases.spawn.count > 0)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
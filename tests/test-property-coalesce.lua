@@ -0,0 +1,38 @@
+-- Test that a burst of property changes is fetched with few requests
+
+local runner = require("_runner")
+local test_client = require("_client")
+
+local retitle_count = 100
+local stats_before
+
+runner.run_steps({
+    function(count)
+        if count == 1 then
+            stats_before = awesome.stats().property
+            test_client(nil, "retitled", nil, nil, nil, { retitle = retitle_count })
+        end
+        for _, c in ipairs(client.get()) do
+            if c.name == "retitled done" then
+                return true
+            end
+        end
+    end,
+
+    function()
+        local stats = awesome.stats().property
+        local notifies = stats.notifies - stats_before.notifies
+        local coalesced = stats.coalesced - stats_before.coalesced
+        local fetched = stats.fetched - stats_before.fetched
+
+        -- Every title change sets both WM_NAME and _NET_WM_NAME. The client
+        -- grabs the server meanwhile, so the first batch of GetProperty
+        -- requests cannot finish and every later change is merged.
+        assert(notifies >= retitle_count, notifies)
+        assert(coalesced >= retitle_count, coalesced .. " " .. notifies)
+        assert(fetched < notifies, fetched .. " " .. notifies)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,115 @@
+-- Test the sampler with a fake /proc and /sys
+
+local runner = require("_runner")
+
+local root = os.tmpname()
+os.remove(root)
+
+local function write(path, content)
+    local f = assert(io.open(root .. path, "w"))
+    f:write(content)
+    f:close()
+end
+
+local function stat(user, idle)
+    return string.format("cpu  %d 0 10 %d 0 0 0 0 0 0\n", user * 2, idle * 2) ..
+           string.format("cpu0 %d 0 5 %d 0 0 0 0 0 0\n", user, idle) ..
+           string.format("cpu1 %d 0 5 %d 0 0 0 0 0 0\n", user, idle) ..
+           "intr 12345 0 0\n"
+end
+
+local function netdev(rx, tx)
+    return "Inter-|   Receive                                                |  Transmit\n" ..
+           " face |bytes    packets errs drop fifo frame compressed multicast|bytes    packets errs drop fifo colls carrier compressed\n" ..
+           string.format("    lo: %d 10 0 0 0 0 0 0 %d 20 0 0 0 0 0 0\n", rx, tx)
+end
+
+for _, dir in ipairs { "/proc/net", "/sys/class/power_supply/BAT0", "/sys/class/hwmon/hwmon0" } do
+    assert(os.execute("mkdir -p '" .. root .. dir .. "'"))
+end
+write("/proc/stat", stat(100, 1000))
+write("/proc/meminfo", "MemTotal:        8000000 kB\nMemAvailable:    6000000 kB\n")
+write("/proc/net/dev", netdev(1000, 2000))
+write("/sys/class/power_supply/BAT0/type", "Battery\n")
+write("/sys/class/power_supply/BAT0/status", "Discharging\n")
+write("/sys/class/power_supply/BAT0/capacity", "87\n")
+write("/sys/class/hwmon/hwmon0/name", "coretemp\n")
+write("/sys/class/hwmon/hwmon0/temp1_input", "45500\n")
+write("/sys/class/hwmon/hwmon0/temp1_label", "Package id 0\n")
+
+local samples = {}
+local ids = {}
+
+runner.run_steps({
+    function()
+        sampler.set_root(root)
+        for _, source in ipairs { "cpu", "memory", "network", "power_supply", "hwmon" } do
+            ids[source] = sampler.subscribe(source, function(values)
+                samples[source] = values
+            end)
+        end
+
+        -- The files are kept open, so rewriting them must be noticed
+        write("/proc/stat", stat(150, 1150))
+        write("/proc/net/dev", netdev(1500, 2100))
+        sampler.sample_now()
+
+        local cpu = samples.cpu
+        assert(cpu[0].user == 100, cpu[0].user)
+        assert(cpu[0].idle == 300, cpu[0].idle)
+        assert(cpu[1].user == 50, cpu[1].user)
+        assert(cpu[2].system == 0, cpu[2].system)
+        assert(math.abs(cpu[0].usage - 0.25) < 1e-9, cpu[0].usage)
+        assert(cpu.interval >= 0)
+
+        assert(samples.memory.MemTotal == 8000000)
+        assert(samples.memory.MemAvailable == 6000000)
+
+        assert(samples.network.lo.rx_bytes == 500, samples.network.lo.rx_bytes)
+        assert(samples.network.lo.tx_bytes == 100, samples.network.lo.tx_bytes)
+        assert(samples.network.lo.rx_total == 1500)
+
+        local bat = samples.power_supply.BAT0
+        assert(bat.type == "Battery", bat.type)
+        assert(bat.status == "Discharging", bat.status)
+        assert(bat.capacity == 87, bat.capacity)
+
+        local hwmon = samples.hwmon.hwmon0
+        assert(hwmon.name == "coretemp", hwmon.name)
+        assert(#hwmon.temperatures == 1)
+        assert(hwmon.temperatures[1].label == "Package id 0")
+        assert(hwmon.temperatures[1].celsius == 45.5)
+
+        -- Nothing changed, so the deltas are zero now
+        sampler.sample_now()
+        assert(samples.cpu[0].user == 0)
+        assert(samples.network.lo.rx_bytes == 0)
+
+        assert(awesome.stats().sampler.subscribers == 5)
+        return true
+    end,
+
+    function()
+        -- The shared tick keeps delivering samples
+        samples.memory = nil
+        sampler.set_interval(0.05)
+        return true
+    end,
+
+    function()
+        if not samples.memory then
+            return
+        end
+
+        for _, id in pairs(ids) do
+            assert(sampler.unsubscribe(id))
+            assert(not sampler.unsubscribe(id))
+        end
+        assert(awesome.stats().sampler.subscribers == 0)
+        sampler.set_root()
+        assert(os.execute("rm -rf '" .. root .. "'"))
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
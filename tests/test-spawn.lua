@@ -80,6 +80,23 @@ local steps = {
                     async_spawns_done = async_spawns_done + 1
                 end
             end)
+            spawn.easy_async({ "sh", "-c", "printf 'a\\nb' ; printf err >&2 ; exit 3" },
+                function(stdout, stderr, reason, code)
+                    assert(stdout == "a\nb\n", stdout)
+                    assert(stderr == "err\n", stderr)
+                    assert(reason == "exit" and code == 3, reason .. " " .. code)
+                    async_spawns_done = async_spawns_done + 1
+                end)
+            spawn.easy_async({ "head", "-c", "1000000", "/dev/zero" },
+                function(stdout)
+                    -- Everything after the first 1000 bytes is discarded
+                    assert(#stdout <= 1000, #stdout)
+                    assert(stdout == string.rep("\0", #stdout))
+                    async_spawns_done = async_spawns_done + 1
+                end, 1000)
+            local ok = pcall(awesome.spawn, "true", false, false, false, false, nil, nil, true)
+            assert(not ok, "capturing output without an exit callback should fail")
+
             local steps_yay = 0
             spawn.with_line_callback("echo yay", {
                                      stdout = function(line)
@@ -151,10 +168,9 @@ local steps = {
 
             spawn.once(tiny_client("client1"), {tag=screen[1].tags[2]})
         end
-        if spawns_done == 3 then
+        if spawns_done == 3 and async_spawns_done == 4 then
             assert(exit_yay == 0)
             assert(exit_snd == 42)
-            assert(async_spawns_done == 2)
             return true
         end
     end,
@@ -0,0 +1,74 @@
+-- Test that restacking many transient windows only moves what changed
+
+local runner = require("_runner")
+local test_client = require("_client")
+
+local transient_count = 30
+local parent, other
+local stats_before
+
+local function get_client(title)
+    for _, c in ipairs(client.get()) do
+        if c.name == title then
+            return c
+        end
+    end
+end
+
+runner.run_steps({
+    -- Spawn a parent with lots of transients and one unrelated client
+    function(count)
+        if count == 1 then
+            test_client(nil, "parent")
+            for i = 1, transient_count do
+                test_client(nil, "transient" .. i, nil, nil, nil, { transient_for = "parent" })
+            end
+            test_client(nil, "other")
+        end
+        if #client.get() == transient_count + 2 then
+            return true
+        end
+    end,
+
+    -- Wait for all the WM_TRANSIENT_FOR properties to be processed
+    function()
+        parent, other = get_client("parent"), get_client("other")
+        assert(parent and other)
+        for i = 1, transient_count do
+            local c = get_client("transient" .. i)
+            if not c or c.transient_for ~= parent then
+                return
+            end
+        end
+
+        stats_before = awesome.stats().stack
+        assert(stats_before.last_windows >= transient_count + 2)
+
+        -- Move the whole group above the other client
+        parent:raise()
+        return true
+    end,
+
+    -- The group stayed in order, so only the other client had to move
+    function()
+        local stats = awesome.stats().stack
+        local requests = stats.requests - stats_before.requests
+        assert(stats.restacks > stats_before.restacks)
+        assert(requests <= 2, requests)
+
+        -- Raising a single transient only moves that transient
+        stats_before = stats
+        get_client("transient5"):raise()
+        return true
+    end,
+
+    function()
+        local stats = awesome.stats().stack
+        local requests = stats.requests - stats_before.requests
+        assert(stats.restacks > stats_before.restacks)
+        assert(requests <= 2, requests)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
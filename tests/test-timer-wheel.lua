@@ -0,0 +1,101 @@
+-- Test that timers with similar deadlines share their wakeups
+
+local runner = require("_runner")
+local gtimer = require("gears.timer")
+
+local timers = {}
+local fired = 0
+local single_shot_fired = 0
+local stats_before
+local stopper_fired, stopped_fired, zero_fired = 0, 0, 0
+
+runner.run_steps({
+    function()
+        stats_before = gtimer.stats()
+
+        -- Timers started at slightly different times are batched together
+        for i = 1, 20 do
+            timers[i] = gtimer {
+                timeout = 0.5 + i / 1000,
+                slack = 0.05,
+                autostart = true,
+                callback = function() fired = fired + 1 end,
+            }
+        end
+
+        gtimer {
+            timeout = 0.1,
+            autostart = true,
+            single_shot = true,
+            callback = function() single_shot_fired = single_shot_fired + 1 end,
+        }
+        return true
+    end,
+
+    function()
+        if fired < 40 then
+            return
+        end
+
+        for _, t in ipairs(timers) do
+            t:stop()
+            assert(not t.started)
+            assert(t.drift >= 0, t.drift)
+            assert(t.drift < 0.5, t.drift)
+        end
+
+        local stats = gtimer.stats()
+        local wakeups = stats.wakeups - stats_before.wakeups
+        local batched = stats.fired - stats_before.fired
+
+        -- Both rounds of the 20 timers took one wakeup each (give or take one
+        -- for timers that fell just beyond a slack boundary). Other timers
+        -- (e.g. the test runner's) may fire in between.
+        assert(batched >= fired, batched .. " " .. fired)
+        assert(wakeups < batched - 30, wakeups .. " " .. batched)
+        assert(stats.max_batch_time >= stats.last_batch_time)
+        assert(single_shot_fired == 1, single_shot_fired)
+        return true
+    end,
+
+    function()
+        -- Stopping the only timer of a batch removes its GLib source
+        local pending = gtimer.stats().pending
+        local t = gtimer.start_new(0.0123, function() return true end)
+        assert(t.started)
+        t:stop()
+        assert(gtimer.stats().pending == pending, gtimer.stats().pending)
+        return true
+    end,
+
+    function()
+        -- The first timer of a batch stops the second one, which leaves the
+        -- batch empty while it is firing, and schedules a timer that may end
+        -- up with the same deadline as the firing batch
+        local stopped = gtimer { timeout = 0.2, slack = 0.05,
+            callback = function() stopped_fired = stopped_fired + 1 end }
+        local stopper = gtimer { timeout = 0.2, slack = 0.05, single_shot = true,
+            callback = function()
+                stopper_fired = stopper_fired + 1
+                gtimer.start_new(0, function()
+                    zero_fired = zero_fired + 1
+                end)
+                stopped:stop()
+            end }
+        stopper:start()
+        stopped:start()
+        return true
+    end,
+
+    function()
+        if zero_fired == 0 then
+            return
+        end
+        assert(stopper_fired == 1, stopper_fired)
+        assert(stopped_fired == 0, stopped_fired)
+        assert(zero_fired == 1, zero_fired)
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
@@ -0,0 +1,74 @@
+-- Test that wallpapers can be set asynchronously
+
+local runner = require("_runner")
+local gears_wallpaper = require("gears.wallpaper")
+local gears_surface = require("gears.surface")
+local lgi = require("lgi")
+local cairo = lgi.cairo
+local Gdk = lgi.Gdk
+
+local function wallpaper_pixel(x, y)
+    local img = cairo.ImageSurface(cairo.Format.RGB24, 1, 1)
+    local cr = cairo.Context(img)
+    cr:set_source_surface(gears_surface(root.wallpaper()), -x, -y)
+    cr:paint()
+    img:flush()
+
+    local data = Gdk.pixbuf_get_from_surface(img, 0, 0, 1, 1):get_pixels_with_length()
+    if type(data) == "string" then
+        return data:byte(1, 3)
+    end
+    return data[1], data[2], data[3]
+end
+
+local red = cairo.ImageSurface(cairo.Format.RGB24, 10, 10)
+do
+    local cr = cairo.Context(red)
+    cr:set_source_rgb(1, 0, 0)
+    cr:paint()
+end
+
+local changed, results = 0, {}
+awesome.connect_signal("wallpaper_changed", function() changed = changed + 1 end)
+
+runner.run_steps({
+    function()
+        gears_wallpaper.set("#0000ff")
+        changed = 0
+
+        gears_wallpaper.async({ image = red, mode = "fit", background = "#00ff00" },
+            function(...) results.surface = { ... } end)
+        gears_wallpaper.async({ image = "/this/file/does/not/exist.png" },
+            function(...) results.missing = { ... } end)
+
+        -- Nothing happened yet, the old wallpaper is still there
+        assert(changed == 0)
+        local r, g, b = wallpaper_pixel(0, 0)
+        assert(r == 0 and g == 0 and b == 255, string.format("%d %d %d", r, g, b))
+        return true
+    end,
+
+    function()
+        if not results.surface or not results.missing then
+            return
+        end
+
+        assert(results.surface[1] == true, tostring(results.surface[2]))
+        assert(results.missing[1] == false)
+        assert(type(results.missing[2]) == "string")
+        assert(changed == 1, changed)
+
+        -- A square image fitted on a wider screen has the background on the
+        -- sides and the image in the middle
+        local width, height = root.size()
+        local r, g, b = wallpaper_pixel(width / 2, height / 2)
+        assert(r == 255 and g == 0 and b == 0, string.format("%d %d %d", r, g, b))
+        if width > height then
+            r, g, b = wallpaper_pixel(0, height / 2)
+            assert(r == 0 and g == 255 and b == 0, string.format("%d %d %d", r, g, b))
+        end
+        return true
+    end,
+})
+
+-- vim: filetype=lua:expandtab:shiftwidth=4:tabstop=8:softtabstop=4:textwidth=80
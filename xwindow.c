@@ -118,37 +118,80 @@ xwindow_buttons_grab(xcb_window_t win, button_array_t *buttons)
                         (*b)->button, (*b)->modifiers);
 }
 
-/** Grab key on a window.
- * \param win The window.
+DO_ARRAY(uint32_t, keygrab, DO_NOTHING)
+
+/** Add the grabs needed for a key to a grab set.
+ * \param grabs The grab set, each entry is modifiers << 8 | keycode.
  * \param k The key.
  */
 static void
-xwindow_grabkey(xcb_window_t win, keyb_t *k)
+xwindow_key_grabs(keygrab_array_t *grabs, keyb_t *k)
 {
-    if(k->keycode)
-        xcb_grab_key(globalconf.connection, true, win,
-                     k->modifiers, k->keycode, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-    else if(k->keysym)
+    xcb_keycode_t single[] = { k->keycode, 0 };
+    xcb_keycode_t *keycodes = single;
+
+    if(!k->keycode)
     {
-        xcb_keycode_t *keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, k->keysym);
-        if(keycodes)
+        if(!k->keysym)
+            return;
+        keycodes = xcb_key_symbols_get_keycode(globalconf.keysyms, k->keysym);
+        if(!keycodes)
+            return;
+    }
+
+    /* X11 grabs are for an exact modifier state, so grab the key once for
+     * every combination of the ignored modifiers. */
+    uint16_t ignore = k->modifiers == XCB_BUTTON_MASK_ANY ? 0 : k->ignore_modifiers & ~k->modifiers;
+    for(xcb_keycode_t *kc = keycodes; *kc; kc++)
+        for(uint16_t sub = ignore;; sub = (sub - 1) & ignore)
         {
-            for(xcb_keycode_t *kc = keycodes; *kc; kc++)
-                xcb_grab_key(globalconf.connection, true, win,
-                             k->modifiers, *kc, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
-            p_delete(&keycodes);
+            keygrab_array_append(grabs, (uint32_t) (k->modifiers | sub) << 8 | *kc);
+            if(!sub)
+                break;
         }
-    }
+
+    if(keycodes != single)
+        p_delete(&keycodes);
+}
+
+static int
+xwindow_grab_cmp(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a, y = *(const uint32_t *) b;
+    return x < y ? -1 : x > y;
 }
 
+/** Grab the keys of a key array on a window, replacing all previous grabs.
+ * The grabs of all keys are collected first, so that every (keycode,
+ * modifiers) pair is only grabbed once.
+ * \param win The window.
+ * \param keys The keys to grab.
+ */
 void
 xwindow_grabkeys(xcb_window_t win, key_array_t *keys)
 {
+    keygrab_array_t grabs;
+
     /* Ungrab everything first */
     xcb_ungrab_key(globalconf.connection, XCB_GRAB_ANY, win, XCB_BUTTON_MASK_ANY);
 
+    keygrab_array_init(&grabs);
     foreach(k, *keys)
-        xwindow_grabkey(win, *k);
+        xwindow_key_grabs(&grabs, *k);
+    qsort(grabs.tab, grabs.len, sizeof(*grabs.tab), xwindow_grab_cmp);
+
+    for(int i = 0; i < grabs.len; i++)
+    {
+        uint16_t modifiers = grabs.tab[i] >> 8;
+        xcb_keycode_t keycode = grabs.tab[i] & 0xff;
+
+        if(i > 0 && grabs.tab[i] == grabs.tab[i - 1])
+            continue;
+        xcb_grab_key(globalconf.connection, true, win,
+                     modifiers, keycode, XCB_GRAB_MODE_ASYNC, XCB_GRAB_MODE_ASYNC);
+    }
+
+    keygrab_array_wipe(&grabs);
 }
 
 /** Send a request for a window's opacity.